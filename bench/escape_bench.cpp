@@ -0,0 +1,189 @@
+/**
+ * @file escape_bench.cpp
+ * @brief JSON/Pango转义基准测试
+ *
+ * 使用真实的模块输出（Nerd Font字形、U+2004空格、电池模块的<span>标记、
+ * 脚本输出）测量：
+ * - 整帧序列化：原先逐模块调用toJson()（nlohmann::json::dump）与
+ *   现在按预编译模板拼装（buildFrame，全部模块为脏）
+ * - 每种实现（scalar/sse2/avx2）转义一帧全部文本的耗时
+ * - 4 KiB长文本（纯ASCII和中英混合）的吞吐量
+ *
+ * 开始测量之前先校验各实现的输出与标量实现完全一致，
+ * 且JSON转义结果能被nlohmann解析回原文，不一致时直接退出。
+ */
+
+#include <escape.h>
+#include <module.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 一帧中各模块的典型输出
+const std::vector<std::string> FRAME_TEXTS = {
+    "<span color='#98BC37'>󰂄</span> <span color='#FCE8C3'>87%</span>"
+    " <span color='#6A6862'>2:41</span>",
+    "󰛨 60%",
+    "󰕾 45%",
+    "󰍬 80%",
+    "󰈀 1.23M 456.00K",
+    "󰍹 12.5",
+    "󰍛 3.21G",
+    "󰓅 15.3W",
+    "󰓅 07.9",
+    " 52.0",
+    "VPN: wg0 \"office\" <up> & routing 10.0.0.0/8",
+    "Sun 10/18 11:36:40",
+};
+
+// 固定输出的模块
+class StaticModule : public Module {
+  public:
+    StaticModule(const std::string &name, const std::string &text) : Module(name), text_(text) {}
+
+    void update() override {
+        setOutput(text_, Color::IDLE);
+    }
+
+  private:
+    std::string text_;
+};
+
+// 测量func执行iterations次的平均耗时（纳秒）
+template <typename F> double measure(size_t iterations, F &&func) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        func(i);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()
+           ) /
+           static_cast<double>(iterations);
+}
+
+// 校验所有实现的输出一致，JSON转义结果可以被解析回原文
+void verify(const std::vector<std::string> &texts) {
+    for (const std::string &text : texts) {
+        std::string json_scalar;
+        std::string pango_scalar;
+        appendJsonEscaped(text, json_scalar, EscapeIsa::SCALAR);
+        appendPangoEscaped(text, pango_scalar, EscapeIsa::SCALAR);
+
+        if (nlohmann::json::parse('"' + json_scalar + '"').get<std::string>() != text) {
+            std::fprintf(stderr, "JSON round trip mismatch: %s\n", text.c_str());
+            std::exit(EXIT_FAILURE);
+        }
+
+        for (const EscapeIsa isa : {EscapeIsa::SSE2, EscapeIsa::AVX2}) {
+            std::string json;
+            std::string pango;
+            appendJsonEscaped(text, json, isa);
+            appendPangoEscaped(text, pango, isa);
+            if (json != json_scalar || pango != pango_scalar) {
+                std::fprintf(stderr, "%s output differs from scalar: %s\n", escapeIsaName(isa),
+                             text.c_str());
+                std::exit(EXIT_FAILURE);
+            }
+        }
+    }
+}
+
+// 生成约4 KiB的长文本
+std::string makeLongText(bool mixed) {
+    std::string text;
+    while (text.size() < 4096) {
+        text += mixed ? "构建 #1234 通过 󰄬 tests=512 " : "build #1234 passed, tests=512 in 3.2s ";
+    }
+    return text;
+}
+
+void benchFrame() {
+    ModuleManager manager;
+    std::vector<std::shared_ptr<StaticModule>> modules;
+    for (size_t i = 0; i < FRAME_TEXTS.size(); ++i) {
+        auto module = std::make_shared<StaticModule>("m" + std::to_string(i), FRAME_TEXTS[i]);
+        manager.addModule(module);
+        module->update();
+        modules.push_back(module);
+    }
+
+    const size_t iterations = 200000;
+    size_t bytes = 0;
+
+    const double dump_ns = measure(iterations, [&](size_t) {
+        std::string frame;
+        for (const auto &module : modules) {
+            frame += module->toJson();
+            frame += ',';
+        }
+        bytes = frame.size();
+    });
+
+    const double template_ns = measure(iterations, [&](size_t) {
+        for (size_t j = 0; j < modules.size(); ++j) {
+            manager.markDirty(static_cast<ModuleId>(j));
+        }
+        bytes = manager.buildFrame().size();
+    });
+
+    std::printf("frame (%zu modules, all dirty)\n", modules.size());
+    std::printf("  %-28s %10.1f ns\n", "toJson() per module", dump_ns);
+    std::printf("  %-28s %10.1f ns  (%zu bytes)\n", "buildFrame() templates", template_ns, bytes);
+}
+
+void benchIsa(const char *label, const std::vector<std::string> &texts, size_t iterations) {
+    size_t input_bytes = 0;
+    for (const std::string &text : texts) {
+        input_bytes += text.size();
+    }
+
+    std::printf("%s (%zu bytes)\n", label, input_bytes);
+    for (const EscapeIsa isa : {EscapeIsa::SCALAR, EscapeIsa::SSE2, EscapeIsa::AVX2}) {
+        if (static_cast<int>(isa) > static_cast<int>(bestEscapeIsa())) {
+            continue;
+        }
+
+        std::string out;
+        const double json_ns = measure(iterations, [&](size_t) {
+            out.clear();
+            for (const std::string &text : texts) {
+                appendJsonEscaped(text, out, isa);
+            }
+        });
+        const double pango_ns = measure(iterations, [&](size_t) {
+            out.clear();
+            for (const std::string &text : texts) {
+                appendPangoEscaped(text, out, isa);
+            }
+        });
+
+        std::printf("  %-8s json %10.1f ns %8.0f MB/s   pango %10.1f ns %8.0f MB/s\n",
+                    escapeIsaName(isa), json_ns,
+                    static_cast<double>(input_bytes) * 1000.0 / json_ns, pango_ns,
+                    static_cast<double>(input_bytes) * 1000.0 / pango_ns);
+    }
+}
+
+} // namespace
+
+int main() {
+    const std::vector<std::string> ascii = {makeLongText(false)};
+    const std::vector<std::string> mixed = {makeLongText(true)};
+
+    verify(FRAME_TEXTS);
+    verify(ascii);
+    verify(mixed);
+
+    std::printf("best implementation: %s\n\n", escapeIsaName(bestEscapeIsa()));
+    benchFrame();
+    benchIsa("frame texts", FRAME_TEXTS, 200000);
+    benchIsa("4 KiB ASCII", ascii, 20000);
+    benchIsa("4 KiB mixed UTF-8", mixed, 20000);
+    return 0;
+}
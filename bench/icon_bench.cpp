@@ -0,0 +1,148 @@
+/**
+ * @file icon_bench.cpp
+ * @brief 图标与颜色选择的分配计数基准测试
+ *
+ * 替换全局operator new统计堆分配次数，对比：
+ * - 原先的做法：每次调用构造std::vector<std::string>图标表，if/else选择颜色，
+ *   getColorString()返回新的std::string
+ * - 编译期常量表：pickIcon()/pickColor()/getColorString()
+ * - 完整的更新路径：选择图标和颜色、渲染格式模板、Module::setOutput()
+ *
+ * 后两者在预热之后必须完全不分配内存，否则直接退出。
+ */
+
+#include <format.h>
+#include <icons.h>
+#include <module.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+size_t allocations = 0;
+
+} // namespace
+
+void *operator new(size_t size) {
+    ++allocations;
+    if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t /*size*/) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+// 模拟CPU模块
+class BenchModule : public Module {
+  public:
+    BenchModule() : Module("cpu") {}
+
+    void update() override {}
+
+    void render(double usage) {
+        FormatBuffer buffer;
+        setOutput(
+            format_.render(buffer, pickIcon(icons::CPU, usage), usage),
+            pickColor(thresholds::CPU, usage)
+        );
+    }
+
+  private:
+    FormatTemplate format_{"{icon} {usage:4.2a}%", {"icon", "usage"}};
+};
+
+// 原先CPU模块的图标和颜色选择
+std::string legacySelect(double usage, std::string &color_string) {
+    const std::vector<std::string> icons = {"󰾆", "󰾅", "󰓅"};
+    size_t icon_idx = static_cast<size_t>(static_cast<double>(icons.size()) * usage / 101);
+    icon_idx = std::clamp(icon_idx, size_t(0), icons.size() - 1);
+
+    Color color = Color::IDLE;
+    if (usage >= 60) {
+        color = Color::CRITICAL;
+    } else if (usage >= 30) {
+        color = Color::WARNING;
+    }
+    color_string = std::string(getColorString(color));
+    return icons[icon_idx];
+}
+
+struct Result {
+    double ns;          // 每次调用的平均耗时
+    size_t allocations; // 分配总次数
+};
+
+// 执行func iterations次，统计耗时和分配次数
+template <typename F> Result measure(size_t iterations, F &&func) {
+    const size_t before = allocations;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        func(static_cast<double>(i % 10001) / 100.0);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return {
+        static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+            static_cast<double>(iterations),
+        allocations - before
+    };
+}
+
+void report(const char *label, const Result &result, size_t iterations) {
+    std::printf("  %-32s %8.1f ns  %6.2f allocs/call\n", label, result.ns,
+                static_cast<double>(result.allocations) / static_cast<double>(iterations));
+}
+
+} // namespace
+
+int main() {
+    const size_t iterations = 1000000;
+    size_t sink = 0;
+
+    const Result legacy = measure(iterations, [&](double usage) {
+        std::string color;
+        sink += legacySelect(usage, color).size() + color.size();
+    });
+
+    const Result tables = measure(iterations, [&](double usage) {
+        sink += pickIcon(icons::CPU, usage).size();
+        sink += getColorString(pickColor(thresholds::CPU, usage)).size();
+        sink += pickIcon(icons::TEMPERATURE, usage, 100.0).size();
+        sink += static_cast<size_t>(pickColor(thresholds::TEMPERATURE, usage));
+        sink += pickIcon(icons::BATTERY_DISCHARGING, usage).size();
+        sink += static_cast<size_t>(pickColor(thresholds::BATTERY, usage));
+    });
+
+    // 预热一次，使输出字符串的容量足够
+    BenchModule module;
+    module.render(100.0);
+    const Result update = measure(iterations, [&](double usage) {
+        module.render(usage);
+        sink += module.getOutput().size();
+    });
+
+    std::printf("icon/color selection (%zu iterations)\n", iterations);
+    report("vector<string> + if/else (old)", legacy, iterations);
+    report("constexpr tables (6 lookups)", tables, iterations);
+    report("select + render + setOutput", update, iterations);
+    std::printf("  (checksum %zu)\n", sink);
+
+    if (tables.allocations != 0 || update.allocations != 0) {
+        std::fprintf(stderr, "icon/color selection allocated memory\n");
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
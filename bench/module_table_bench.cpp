@@ -0,0 +1,118 @@
+/**
+ * @file module_table_bench.cpp
+ * @brief 模块表扩展性基准测试
+ *
+ * 使用10～1000个合成模块，测量以下操作的耗时随模块数量的增长情况：
+ * - 定时器节拍调度（dispatchTick）
+ * - 文件描述符事件分发（dispatchEvent）
+ * - 帧拼装（buildFrame），分别测量无脏模块、10%脏模块和全部脏模块三种情况
+ * - 按名称查找模块（点击事件路由）
+ */
+
+#include <module.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+namespace {
+
+// 合成模块：每次更新在两个预先生成的输出之间切换
+class SyntheticModule : public Module {
+  public:
+    SyntheticModule(const std::string &name, uint64_t interval)
+        : Module(name), a_("󰍛 " + name + " 1.23G"), b_("󰍛 " + name + " 4.56G") {
+        setInterval(interval);
+    }
+
+    void update() override {
+        flip_ = !flip_;
+        setOutput(flip_ ? a_ : b_, flip_ ? Color::IDLE : Color::WARNING);
+    }
+
+  private:
+    std::string a_;
+    std::string b_;
+    bool flip_ = false;
+};
+
+// 测量func执行iterations次的平均耗时（纳秒）
+template <typename F> double measure(size_t iterations, F &&func) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        func(i);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()
+           ) /
+           static_cast<double>(iterations);
+}
+
+void runScale(size_t count) {
+    ModuleManager manager;
+    std::vector<std::shared_ptr<SyntheticModule>> modules;
+    for (size_t i = 0; i < count; ++i) {
+        auto module = std::make_shared<SyntheticModule>("m" + std::to_string(i), 1 + i % 4);
+        manager.addModule(module);
+        module->update();
+        modules.push_back(module);
+    }
+    manager.buildFrame();
+
+    const size_t iterations = 200000 / count + 100;
+    uint64_t tick = 0;
+    size_t frame_bytes = 0;
+
+    const double tick_ns = measure(iterations, [&](size_t) { manager.dispatchTick(++tick); });
+    manager.buildFrame();
+
+    const double event_ns = measure(iterations * count, [&](size_t i) {
+        manager.dispatchEvent(static_cast<ModuleId>(i % count));
+    });
+    manager.buildFrame();
+
+    const double clean_ns = measure(iterations, [&](size_t) {
+        frame_bytes = manager.buildFrame().size();
+    });
+
+    const size_t dirty_count = count / 10 > 0 ? count / 10 : 1;
+    const double partial_ns = measure(iterations, [&](size_t i) {
+        for (size_t j = 0; j < dirty_count; ++j) {
+            manager.markDirty(static_cast<ModuleId>((i * dirty_count + j) % count));
+        }
+        frame_bytes = manager.buildFrame().size();
+    });
+
+    const double full_ns = measure(iterations, [&](size_t) {
+        for (size_t j = 0; j < count; ++j) {
+            manager.markDirty(static_cast<ModuleId>(j));
+        }
+        frame_bytes = manager.buildFrame().size();
+    });
+
+    const std::string last_name = "m" + std::to_string(count - 1);
+    const double lookup_ns = measure(iterations, [&](size_t) {
+        if (!manager.getModuleByName(last_name)) {
+            std::abort();
+        }
+    });
+
+    std::printf(
+        "%6zu %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f %10zu\n", count, tick_ns, event_ns,
+        clean_ns, partial_ns, full_ns, lookup_ns, frame_bytes
+    );
+}
+
+} // namespace
+
+int main() {
+    std::printf(
+        "%6s %12s %12s %12s %12s %12s %12s %10s\n", "mods", "tick(ns)", "event(ns)",
+        "frame0(ns)", "frame10%(ns)", "frame100%(ns)", "lookup(ns)", "bytes"
+    );
+    for (size_t count : {size_t{10}, size_t{30}, size_t{100}, size_t{300}, size_t{1000}}) {
+        runScale(count);
+    }
+    return 0;
+}
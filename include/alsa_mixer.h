@@ -0,0 +1,221 @@
+#pragma once
+#include <alsa/asoundlib.h>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @file alsa_mixer.h
+ * @brief 多个音频模块共享的ALSA混音器连接
+ *
+ * 音量和麦克风模块原本各自打开一个混音器连接，只把第一个poll描述符加入epoll，
+ * 任何元素变化都会唤醒两个模块；声卡拔出后还要靠1秒定时器反复重连。
+ *
+ * AlsaMixerHub按声卡名称共享一个连接：
+ * - snd_mixer_poll_descriptors()返回的所有描述符都注册到System的事件循环
+ * - 通过snd_mixer_elem_set_callback()按元素分发，只有值发生变化的元素的订阅者被通知
+ * - 元素被移除或连接出错时通知订阅者设备丢失，并关闭连接
+ * - 通过inotify监听/dev/snd，出现新的控制设备时重新打开连接，不需要轮询
+ * - 启动时可以在工作线程中预先加载（preload()），事件循环线程打开时直接接管
+ */
+
+class System;
+
+/**
+ * @brief 混音器元素订阅者
+ *
+ * 回调均在事件循环线程中调用。
+ */
+class MixerElementListener {
+  public:
+    virtual ~MixerElementListener() = default;
+
+    /**
+     * @brief 订阅的元素值发生变化，或元素（重新）出现
+     */
+    virtual void onMixerElementChanged() = 0;
+
+    /**
+     * @brief 订阅的元素被移除或声卡不可用
+     */
+    virtual void onMixerElementLost() = 0;
+};
+
+/**
+ * @brief 按声卡共享的ALSA混音器连接
+ *
+ * 通过acquire()获取，同一声卡名称在仍有持有者时返回同一个实例。
+ * 订阅者在析构前必须调用unsubscribe()。
+ */
+class AlsaMixerHub {
+  public:
+    /**
+     * @brief 获取声卡对应的共享混音器连接
+     * @param system 系统对象，用于注册文件描述符监听
+     * @param card 声卡名称（如"default"、"hw:0"）
+     * @return 共享连接，打开失败时也会返回（等待设备出现后自动重连）
+     */
+    static std::shared_ptr<AlsaMixerHub> acquire(System &system, const std::string &card);
+
+    /**
+     * @brief 预先加载声卡的混音器
+     * @param card 声卡名称
+     *
+     * snd_mixer_load()经由PulseAudio/PipeWire插件连接时可能阻塞上百毫秒。
+     * 预先加载的句柄被保存起来，之后首次打开同一声卡时直接接管，不再重复加载。
+     * 可以在任意线程中调用，同一声卡已有预先加载的句柄时直接返回。
+     */
+    static void preload(const std::string &card);
+
+    /**
+     * @brief 关闭所有没有被接管的预先加载句柄
+     *
+     * 在所有模块启动完成后调用。没有模块打开对应的声卡时，预先加载的句柄会作为
+     * 第二个混音器连接一直保留到进程退出。
+     */
+    static void releasePreloaded();
+
+    ~AlsaMixerHub();
+
+    // 删除拷贝和移动操作，元素回调保存了订阅记录的地址
+    AlsaMixerHub(const AlsaMixerHub &) = delete;
+    AlsaMixerHub &operator=(const AlsaMixerHub &) = delete;
+    AlsaMixerHub(AlsaMixerHub &&) = delete;
+    AlsaMixerHub &operator=(AlsaMixerHub &&) = delete;
+
+    /**
+     * @brief 订阅简单元素
+     * @param element 元素名称（如"Master"、"Capture"）
+     * @param listener 订阅者
+     */
+    void subscribe(const std::string &element, MixerElementListener *listener);
+
+    /**
+     * @brief 取消订阅
+     * @param element 元素名称
+     * @param listener 订阅者
+     */
+    void unsubscribe(const std::string &element, MixerElementListener *listener);
+
+    /**
+     * @brief 检查元素当前是否可用
+     * @param element 元素名称
+     * @return true如果连接已打开且元素存在
+     */
+    bool hasElement(const std::string &element) const;
+
+    /**
+     * @brief 读取映射后的音量百分比（与alsamixer的刻度一致）
+     * @param element 元素名称
+     * @param capture true为录音方向，false为播放方向
+     * @return 0～100的音量，静音时为-1，元素不可用时为空
+     */
+    std::optional<int64_t> getVolume(const std::string &element, bool capture) const;
+
+    /**
+     * @brief 按百分比调整音量（映射后的刻度）
+     * @param element 元素名称
+     * @param capture true为录音方向，false为播放方向
+     * @param delta_percent 调整量，正数增加，负数减少
+     * @return true如果写入成功
+     */
+    bool changeVolume(const std::string &element, bool capture, int64_t delta_percent);
+
+    /**
+     * @brief 切换静音状态
+     * @param element 元素名称
+     * @param capture true为录音方向，false为播放方向
+     * @return true如果写入成功
+     */
+    bool toggleMute(const std::string &element, bool capture);
+
+  private:
+    /**
+     * @brief 一个元素的订阅记录
+     *
+     * 以unique_ptr保存，地址作为元素回调的私有数据。
+     */
+    struct Subscription {
+        std::string name;                             ///< 元素名称
+        snd_mixer_elem_t *elem = nullptr;             ///< 当前绑定的元素，不可用时为nullptr
+        std::vector<MixerElementListener *> listeners; ///< 订阅者
+    };
+
+    AlsaMixerHub(System &system, const std::string &card);
+
+    /**
+     * @brief 打开混音器连接并注册所有poll描述符
+     * @return true如果打开成功
+     */
+    bool open();
+
+    /**
+     * @brief 关闭混音器连接并通知所有订阅者设备丢失
+     */
+    void close();
+
+    /**
+     * @brief 处理混音器poll描述符上的事件
+     * @param fd 触发事件的描述符
+     * @param events epoll事件掩码
+     */
+    void handleMixerEvents(int fd, uint32_t events);
+
+    /**
+     * @brief 处理/dev/snd目录变化，出现新的控制设备时尝试重新打开
+     */
+    void handleDeviceEvents();
+
+    /**
+     * @brief 开始监听/dev/snd目录
+     */
+    void watchDevices();
+
+    /**
+     * @brief 将元素绑定到同名订阅记录
+     * @param elem 新出现的元素
+     * @return 绑定到的订阅记录，没有同名订阅时为nullptr
+     */
+    Subscription *bindElement(snd_mixer_elem_t *elem);
+
+    /**
+     * @brief 通知一个元素的所有订阅者
+     * @param subscription 订阅记录
+     * @param available true表示元素可用（值变化或重新出现），false表示丢失
+     */
+    static void notifyListeners(const Subscription &subscription, bool available);
+
+    /**
+     * @brief 按名称查找订阅记录
+     */
+    Subscription *findSubscription(const std::string &element) const;
+
+    /**
+     * @brief 查找可用的元素
+     */
+    snd_mixer_elem_t *findElement(const std::string &element) const;
+
+    /**
+     * @brief 取出预先加载的句柄
+     * @param card 声卡名称
+     * @return 句柄，没有预先加载时为nullptr
+     */
+    static snd_mixer_t *takePreloaded(const std::string &card);
+
+    // 混音器级别回调，处理元素的添加
+    static int mixerCallback(snd_mixer_t *mixer, unsigned int mask, snd_mixer_elem_t *elem);
+
+    // 元素级别回调，处理值变化和移除
+    static int elementCallback(snd_mixer_elem_t *elem, unsigned int mask);
+
+    System &system_;   ///< 系统对象
+    std::string card_; ///< 声卡名称
+    std::unique_ptr<snd_mixer_t, decltype(&snd_mixer_close)> handle_; ///< 混音器句柄
+    std::vector<struct pollfd> poll_fds_;                   ///< 已注册的poll描述符
+    std::vector<struct pollfd> revents_fds_;                ///< 传给ALSA的描述符数组，每次事件复用
+    int inotify_fd_ = -1;                                   ///< /dev/snd的inotify描述符
+    bool loading_ = false;                                  ///< 是否处于snd_mixer_load()中
+    std::vector<std::unique_ptr<Subscription>> subscriptions_; ///< 订阅记录
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @file click_parser.h
+ * @brief i3bar点击事件的流式解析器
+ *
+ * i3bar通过标准输入发送一个无限JSON数组，每个元素是一个点击事件对象：
+ * @code
+ * [
+ * {"name":"volume","instance":"4","button":4,"modifiers":["Shift"],"x":1820,...}
+ * ,{"name":"volume","instance":"4","button":4,...}
+ * @endcode
+ *
+ * 快速滚动时一次read()可能包含多个事件，一个事件也可能被拆分在两次read()之间。
+ * 本解析器维护一个跨读取的残留缓冲区，按花括号深度（感知字符串和转义）切分出
+ * 完整对象，然后只提取name、instance、button和modifiers字段，不构建DOM。
+ */
+
+/**
+ * @brief 点击修饰键位掩码
+ */
+enum ClickModifier : uint32_t {
+    MODIFIER_SHIFT = 1u << 0,
+    MODIFIER_CONTROL = 1u << 1,
+    MODIFIER_LOCK = 1u << 2,
+    MODIFIER_MOD1 = 1u << 3,
+    MODIFIER_MOD2 = 1u << 4,
+    MODIFIER_MOD3 = 1u << 5,
+    MODIFIER_MOD4 = 1u << 6,
+    MODIFIER_MOD5 = 1u << 7,
+};
+
+/**
+ * @brief 一次点击事件
+ *
+ * name和instance是指向解析器缓冲区的原始（未反转义）视图，
+ * 仅在下一次调用ClickEventParser::append()之前有效。
+ */
+struct ClickEvent {
+    std::string_view name;     ///< 模块名称
+    std::string_view instance; ///< 实例字段（本程序输出的模块ID）
+    uint64_t button = 0;       ///< 鼠标按钮编号
+    uint32_t modifiers = 0;    ///< ClickModifier位掩码
+};
+
+/**
+ * @brief 增量式点击事件解析器
+ *
+ * 使用方式：每次从标准输入读到数据后调用append()，
+ * 然后循环调用next()直到返回false，取出所有已完整到达的事件。
+ *
+ * @code
+ * ClickEventParser parser;
+ * parser.append(buf, n);
+ * ClickEvent event;
+ * while (parser.next(event)) {
+ *     dispatch(event);
+ * }
+ * @endcode
+ */
+class ClickEventParser {
+  public:
+    /**
+     * @brief 单个对象的最大长度，超过时丢弃该对象以防止缓冲区无限增长
+     */
+    static constexpr size_t MAX_OBJECT_SIZE = 64 * 1024;
+
+    ClickEventParser();
+
+    /**
+     * @brief 追加新读取的数据
+     * @param data 数据指针
+     * @param size 数据长度
+     *
+     * 追加前会丢弃已经交付的字节，因此之前返回的ClickEvent视图随之失效。
+     */
+    void append(const char *data, size_t size);
+
+    /**
+     * @brief 取出下一个完整事件
+     * @param event 输出的事件
+     * @return true如果取出了一个事件，false表示缓冲区中没有完整事件
+     *
+     * 格式错误的对象会被跳过，不影响后续事件。
+     */
+    bool next(ClickEvent &event);
+
+    /**
+     * @brief 获取缓冲区中尚未交付的字节数
+     * @return 字节数
+     */
+    size_t pendingBytes() const;
+
+    /**
+     * @brief 获取因格式错误或超长而丢弃的对象数
+     * @return 丢弃数量
+     */
+    uint64_t droppedObjects() const;
+
+  private:
+    /**
+     * @brief 解析一个完整对象
+     * @param object 以'{'开始、'}'结束的对象文本
+     * @param event 输出的事件
+     * @return true如果对象包含有效的button字段
+     */
+    static bool parseObject(std::string_view object, ClickEvent &event);
+
+    static constexpr size_t NO_OBJECT = static_cast<size_t>(-1);
+
+    std::string buffer_;              ///< 残留缓冲区
+    size_t consumed_ = 0;             ///< 已交付（可丢弃）的字节数
+    size_t scan_pos_ = 0;             ///< 下一个待扫描的字节
+    size_t object_start_ = NO_OBJECT; ///< 当前对象的起始位置
+    int depth_ = 0;                   ///< 当前嵌套深度
+    bool in_string_ = false;          ///< 是否位于字符串内部
+    bool escape_ = false;             ///< 上一个字符是否为反斜杠
+    uint64_t dropped_ = 0;            ///< 丢弃的对象数
+};
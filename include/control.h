@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file control.h
+ * @brief 本地控制套接字
+ *
+ * 在$XDG_RUNTIME_DIR/seedstatus.sock上监听AF_UNIX流套接字，外部程序
+ * （音量脚本、VPN钩子等）状态变化时可以立即推送刷新，而不必等待下一次轮询：
+ *
+ * @code
+ * echo "refresh vpn" | socat - UNIX-CONNECT:$XDG_RUNTIME_DIR/seedstatus.sock
+ * @endcode
+ *
+ * 每行一个命令，每个命令回复一行"ok ..."或"error ..."：
+ * - refresh <模块|all>          立即更新模块
+ * - set-state <模块> <n>        设置模块状态并更新
+ * - click <模块> <按钮>         模拟点击
+ * - interval <模块> <秒>        修改更新间隔，0表示关闭轮询
+ * - list                        列出模块（ID、名称、间隔、刷新信号）
+ * - output                      标准输出统计（提交、写出、丢弃的帧数等）
+ * - render                      各模块的渲染缓存命中和未命中次数
+ * - budget                      各模块的时间预算（毫秒）、超出次数、最长耗时（毫秒）、
+ *                               间隔加倍级数和是否被隔离
+ * - budget <模块> <毫秒>        修改update()的时间预算（0表示默认值），并解除降级和隔离
+ * - stats                       运行统计摘要（帧率、延迟和各模块update()耗时的分布等，见telemetry.h）
+ * - trace                       把追踪缓冲区写入追踪文件并返回其路径（需要--trace，见trace.h）
+ *
+ * <模块>可以是模块名称（匹配所有同名模块）或数字模块ID。
+ * 套接字、连接和命令处理都在事件循环线程中完成。
+ */
+
+class System;
+
+/**
+ * @brief 控制套接字服务
+ */
+class ControlServer {
+  public:
+    /**
+     * @brief 单行命令的最大长度
+     */
+    static constexpr size_t MAX_LINE_SIZE = 1024;
+
+    /**
+     * @brief 同时连接的客户端上限
+     */
+    static constexpr size_t MAX_CLIENTS = 16;
+
+    /**
+     * @brief 构造函数
+     * @param system 系统对象
+     */
+    explicit ControlServer(System &system);
+
+    /**
+     * @brief 析构函数
+     *
+     * 关闭所有连接并删除套接字文件。
+     */
+    ~ControlServer();
+
+    // 删除拷贝和移动操作，监听回调保存了this指针
+    ControlServer(const ControlServer &) = delete;
+    ControlServer &operator=(const ControlServer &) = delete;
+    ControlServer(ControlServer &&) = delete;
+    ControlServer &operator=(ControlServer &&) = delete;
+
+    /**
+     * @brief 开始监听
+     * @param path 套接字路径，为空时使用defaultPath()
+     * @return true如果监听成功
+     *
+     * 路径上已有套接字文件时先尝试连接：连接成功说明另一个实例正在运行，
+     * 返回false；连接被拒绝则视为残留文件，删除后重新绑定。
+     */
+    bool start(const std::string &path = {});
+
+    /**
+     * @brief 默认套接字路径
+     * @return $XDG_RUNTIME_DIR/seedstatus.sock，未设置时为/tmp/seedstatus-<uid>/seedstatus.sock
+     *
+     * 退回到/tmp时，start()以0700权限创建其中的目录，目录已存在但不属于当前用户或
+     * 其他用户可以访问时拒绝监听。
+     */
+    static std::string defaultPath();
+
+    /**
+     * @brief 执行一条命令
+     * @param line 命令行（不含换行符）
+     * @return 回复（不含换行符）
+     */
+    std::string execute(std::string_view line);
+
+  private:
+    /**
+     * @brief 接受新的连接
+     */
+    void acceptClients();
+
+    /**
+     * @brief 读取客户端命令并回复
+     * @param fd 客户端描述符
+     */
+    void handleClient(int fd);
+
+    /**
+     * @brief 关闭客户端连接
+     * @param fd 客户端描述符
+     */
+    void closeClient(int fd);
+
+    /**
+     * @brief 按名称或ID解析模块
+     * @param selector 模块名称或数字ID
+     * @return 匹配的模块ID列表
+     */
+    std::vector<uint32_t> resolveModules(std::string_view selector) const;
+
+    System &system_;                                       ///< 系统对象
+    int listen_fd_ = -1;                                   ///< 监听套接字
+    std::string path_;                                     ///< 套接字路径
+    std::unordered_map<int, std::string> clients_;         ///< 客户端描述符→未完成的输入
+};
@@ -0,0 +1,128 @@
+#pragma once
+#include "task.h"
+#include <sdbus-c++/sdbus-c++.h>
+#include <coroutine>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+
+/**
+ * @file dbus_call.h
+ * @brief 可在Task中co_await的D-Bus方法调用
+ *
+ * 同步的getProperty()/callMethod()在事件循环线程中等待回复，每次往返都会阻塞
+ * 点击和其它模块。dbusCall()发出异步调用后挂起协程，回复由连接的事件处理
+ * （模块在连接的fd可读时调用processPendingEvent()）分发，在事件循环线程中恢复协程：
+ *
+ * @code
+ * auto reply = co_await dbusCall<std::map<std::string, sdbus::Variant>>(
+ *     *proxy_, "org.freedesktop.DBus.Properties", "GetAll", DEVICE_INTERFACE);
+ * if (!reply) {
+ *     std::cerr << reply.error->getMessage() << std::endl;
+ *     co_return;
+ * }
+ * const auto &properties = reply.get<0>();
+ * @endcode
+ *
+ * 单独放在这个头文件中，不使用D-Bus的代码包含task.h时不依赖sdbus-c++。
+ */
+
+/**
+ * @brief D-Bus方法调用的结果
+ * @tparam Results 回复中的各个值的类型
+ */
+template <typename... Results> struct DBusReply {
+    std::optional<sdbus::Error> error; ///< 调用失败时的错误
+    std::tuple<Results...> values;     ///< 回复中的值，失败时为默认值
+
+    explicit operator bool() const {
+        return !error.has_value();
+    }
+
+    /**
+     * @brief 获取第I个值
+     */
+    template <size_t I> const auto &get() const {
+        return std::get<I>(values);
+    }
+};
+
+/**
+ * @brief 等待D-Bus方法调用的回复
+ * @tparam Results 回复中的各个值的类型
+ *
+ * 构造时立即发出调用。协程在等待中被销毁时取消调用，回复不会再被分发到已销毁的帧。
+ */
+template <typename... Results> class DBusCallAwaiter {
+  public:
+    template <typename... Args>
+    DBusCallAwaiter(sdbus::IProxy &proxy, const std::string &interface, const std::string &method,
+                    Args &&...args) {
+        call_ = proxy.callMethodAsync(method)
+                    .onInterface(interface)
+                    .withArguments(std::forward<Args>(args)...)
+                    .uponReplyInvoke([this](std::optional<sdbus::Error> error, Results... values) {
+                        onReply(std::move(error), std::move(values)...);
+                    });
+    }
+
+    /**
+     * @brief 析构函数，回复尚未到达时取消调用
+     */
+    ~DBusCallAwaiter() {
+        if (!done_) {
+            call_.cancel();
+        }
+    }
+
+    // 回调保存了this指针，只能由dbusCall()就地构造
+    DBusCallAwaiter(const DBusCallAwaiter &) = delete;
+    DBusCallAwaiter &operator=(const DBusCallAwaiter &) = delete;
+
+    bool await_ready() const noexcept {
+        return done_;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) noexcept {
+        handle_ = handle;
+    }
+
+    DBusReply<Results...> await_resume() {
+        return std::move(reply_);
+    }
+
+  private:
+    /**
+     * @brief 回复到达（在处理连接事件的事件循环线程中调用）
+     */
+    void onReply(std::optional<sdbus::Error> error, Results... values) {
+        done_ = true;
+        reply_.error = std::move(error);
+        if (!reply_.error) {
+            reply_.values = std::tuple<Results...>(std::move(values)...);
+        }
+        if (handle_) {
+            handle_.resume();
+        }
+    }
+
+    sdbus::PendingAsyncCall call_;  ///< 进行中的调用，用于取消
+    DBusReply<Results...> reply_;   ///< 回复
+    std::coroutine_handle<> handle_; ///< 等待中的协程
+    bool done_ = false;              ///< 回复是否已到达
+};
+
+/**
+ * @brief 调用D-Bus方法并等待回复
+ * @tparam Results 回复中的各个值的类型
+ * @param proxy 对象代理
+ * @param interface 接口名称
+ * @param method 方法名称
+ * @param args 调用参数
+ */
+template <typename... Results, typename... Args>
+DBusCallAwaiter<Results...> dbusCall(sdbus::IProxy &proxy, const std::string &interface,
+                                     const std::string &method, Args &&...args) {
+    return DBusCallAwaiter<Results...>(proxy, interface, method, std::forward<Args>(args)...);
+}
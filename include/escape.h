@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+/**
+ * @file escape.h
+ * @brief JSON字符串和Pango标记转义
+ *
+ * 每一帧都要把所有脏模块的文本写进JSON字符串，文本中大部分是Nerd Font
+ * 多字节字形、 空格和Pango的<span>标记，真正需要转义的字符很少。
+ * 转义函数每次用SSE2检查16字节、AVX2检查32字节，整块都不需要处理时直接整段
+ * 拷贝，只有命中的字节才逐个处理：
+ * - JSON：转义"、\、控制字符和DEL；非ASCII字节按UTF-8校验，
+ *   非法序列替换为U+FFFD，保证i3bar的JSON解析器不会因为一个模块出错而整帧失败
+ * - Pango：转义&、<、>、'、"，去掉Pango不接受的控制字符（保留\t），
+ *   用于脚本输出等不可信文本，避免其中的"<"破坏整个模块的标记
+ *
+ * AVX2在运行时检测，不支持时使用SSE2（x86-64的基线），其它架构使用标量实现。
+ */
+
+/**
+ * @brief 转义实现
+ */
+enum class EscapeIsa {
+    SCALAR, ///< 逐字节
+    SSE2,   ///< 每次16字节
+    AVX2    ///< 每次32字节
+};
+
+/**
+ * @brief 当前CPU支持的最快实现
+ * @return 转义实现（首次调用时检测，结果被缓存）
+ */
+EscapeIsa bestEscapeIsa();
+
+/**
+ * @brief 获取实现的名称
+ * @param isa 转义实现
+ * @return "scalar"、"sse2"或"avx2"
+ */
+const char *escapeIsaName(EscapeIsa isa);
+
+/**
+ * @brief 追加JSON字符串内容（不含两端引号）
+ * @param text 原始文本
+ * @param out 输出缓冲区
+ */
+void appendJsonEscaped(std::string_view text, std::string &out);
+
+/**
+ * @brief 使用指定实现追加JSON字符串内容，用于基准测试
+ * @param text 原始文本
+ * @param out 输出缓冲区
+ * @param isa 转义实现，CPU不支持时退回到bestEscapeIsa()
+ */
+void appendJsonEscaped(std::string_view text, std::string &out, EscapeIsa isa);
+
+/**
+ * @brief 追加转义后的Pango文本
+ * @param text 不可信的原始文本
+ * @param out 输出缓冲区
+ */
+void appendPangoEscaped(std::string_view text, std::string &out);
+
+/**
+ * @brief 使用指定实现追加转义后的Pango文本，用于基准测试
+ * @param text 不可信的原始文本
+ * @param out 输出缓冲区
+ * @param isa 转义实现，CPU不支持时退回到bestEscapeIsa()
+ */
+void appendPangoEscaped(std::string_view text, std::string &out, EscapeIsa isa);
+
+/**
+ * @brief 转义Pango文本
+ * @param text 不可信的原始文本
+ * @return 可以直接放进Pango标记的文本
+ */
+std::string escapePango(std::string_view text);
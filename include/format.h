@@ -0,0 +1,213 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @file format.h
+ * @brief 模块输出的格式模板
+ *
+ * 模块原先用std::ostringstream拼装输出，每次更新都要切换precision/width并分配
+ * 字符串，三个模块还各自实现了一份行为不同的存储单位格式化。格式模板在模块构造时
+ * 解析一次，生成操作列表；渲染时按列表把字面量和字段依次写进栈上的固定缓冲区，
+ * 数值用std::to_chars格式化，不分配内存：
+ *
+ * @code
+ * FormatTemplate format("{icon} {usage:4.2a}%", {"icon", "usage"});
+ * FormatBuffer buffer;
+ * setOutput(format.render(buffer, icon, usage), color);
+ * @endcode
+ *
+ * 字段写作{名称}或{名称:格式}，{{和}}表示字面量的花括号。格式：
+ * - 空：整数按十进制，浮点数按最短表示，字符串原样输出
+ * - Nd、0Nd：整数，最小宽度N，右对齐，0表示用0填充（如{minutes:02d}）
+ * - W.Pf：浮点数，P位小数，最小宽度W（如{energy:.1f}）
+ * - W.Pa：自适应小数位，在宽度W内尽量多保留小数（最多P位，省略时为W-2），
+ *   数值变大时减少小数位而不是变宽：4.2a显示为9.87、12.3、100
+ * - bytes：字节数，按1024进位，最小单位K，固定5个字符（如" 512K"、"12.3M"、"1.23G"）
+ */
+
+/**
+ * @brief 渲染缓冲区
+ *
+ * 放在栈上使用，超出容量的部分被截断。
+ */
+class FormatBuffer {
+  public:
+    /**
+     * @brief 缓冲区容量（字节）
+     */
+    static constexpr size_t CAPACITY = 256;
+
+    /**
+     * @brief 获取渲染结果
+     * @return 指向缓冲区内部的视图，下一次渲染前有效
+     */
+    std::string_view view() const {
+        return {data_, size_};
+    }
+
+    /**
+     * @brief 上一次渲染是否因容量不足被截断
+     */
+    bool truncated() const {
+        return truncated_;
+    }
+
+  private:
+    friend class FormatTemplate;
+
+    char data_[CAPACITY];    ///< 数据
+    size_t size_ = 0;        ///< 已写入的字节数
+    bool truncated_ = false; ///< 是否被截断
+};
+
+/**
+ * @brief 模板字段的值
+ *
+ * 由字符串、整数或浮点数隐式构造，只在render()调用期间存在，
+ * 字符串不会被复制。
+ */
+class FormatValue {
+  public:
+    /**
+     * @brief 值的类型
+     */
+    enum class Type : uint8_t { STRING, SIGNED, UNSIGNED, DOUBLE };
+
+    FormatValue(std::string_view value) : type_(Type::STRING), string_(value) {}
+    FormatValue(const char *value) : type_(Type::STRING), string_(value) {}
+    FormatValue(const std::string &value) : type_(Type::STRING), string_(value) {}
+    FormatValue(double value) : type_(Type::DOUBLE), double_(value) {}
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, int> = 0>
+    FormatValue(T value) : type_(Type::SIGNED), signed_(value) {}
+
+    template <typename T,
+              std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T> &&
+                                   !std::is_same_v<T, bool>,
+                               int> = 0>
+    FormatValue(T value) : type_(Type::UNSIGNED), unsigned_(value) {}
+
+  private:
+    friend class FormatTemplate;
+
+    Type type_;
+    union {
+        std::string_view string_;
+        int64_t signed_;
+        uint64_t unsigned_;
+        double double_;
+    };
+};
+
+/**
+ * @brief 预编译的格式模板
+ */
+class FormatTemplate {
+  public:
+    /**
+     * @brief 解析模板
+     * @param pattern 模板字符串
+     * @param fields 字段名称列表，render()的参数按此顺序传入
+     * @throws std::invalid_argument 模板语法错误或引用了未声明的字段
+     */
+    FormatTemplate(std::string_view pattern, std::initializer_list<std::string_view> fields)
+        : FormatTemplate(pattern, std::span(fields.begin(), fields.size())) {}
+
+    /**
+     * @brief 解析模板，字段名称列表由多个模板共用时使用
+     * @param pattern 模板字符串
+     * @param fields 字段名称列表，render()的参数按此顺序传入
+     * @throws std::invalid_argument 模板语法错误或引用了未声明的字段
+     */
+    FormatTemplate(std::string_view pattern, std::span<const std::string_view> fields);
+
+    /**
+     * @brief 渲染模板
+     * @param buffer 渲染缓冲区
+     * @param args 字段值，顺序与构造时的字段名称列表一致
+     * @return 渲染结果，指向buffer内部
+     */
+    template <typename... Args>
+    std::string_view render(FormatBuffer &buffer, const Args &...args) const {
+        if constexpr (sizeof...(Args) == 0) {
+            return render(buffer, nullptr, 0);
+        } else {
+            const FormatValue values[] = {FormatValue(args)...};
+            return render(buffer, values, sizeof...(Args));
+        }
+    }
+
+    /**
+     * @brief 渲染模板
+     * @param buffer 渲染缓冲区
+     * @param values 字段值数组，缺少的字段输出为空
+     * @param count 字段值数量
+     * @return 渲染结果，指向buffer内部
+     */
+    std::string_view render(FormatBuffer &buffer, const FormatValue *values, size_t count) const;
+
+  private:
+    /**
+     * @brief 字段格式
+     */
+    enum class Style : uint8_t {
+        DEFAULT,  ///< 默认格式
+        INTEGER,  ///< Nd
+        FIXED,    ///< W.Pf
+        ADAPTIVE, ///< W.Pa
+        BYTES     ///< bytes
+    };
+
+    /**
+     * @brief 一个操作：输出字面量或字段
+     */
+    struct Op {
+        bool literal = false;       ///< true为字面量
+        uint32_t offset = 0;        ///< 字面量在literals_中的偏移
+        uint32_t length = 0;        ///< 字面量长度
+        uint16_t field = 0;         ///< 字段索引
+        Style style = Style::DEFAULT; ///< 字段格式
+        bool zero_pad = false;      ///< 是否用0填充
+        uint8_t width = 0;          ///< 最小宽度
+        int8_t precision = -1;      ///< 小数位数，-1表示未指定
+    };
+
+    /**
+     * @brief 解析字段格式
+     * @param spec 冒号之后的格式字符串
+     * @param op 要填充的操作
+     * @throws std::invalid_argument 格式无效
+     */
+    static void parseSpec(std::string_view spec, Op &op);
+
+    std::vector<Op> ops_;  ///< 操作列表
+    std::string literals_; ///< 所有字面量的连续存储
+};
+
+/**
+ * @brief 计算W.Pa格式显示value时保留的小数位数
+ * @param value 数值
+ * @param width 宽度W
+ * @param precision 最多保留的小数位数P，-1表示W-2
+ * @return 小数位数，与render()的结果一致，可用于构造RenderKey
+ */
+int adaptiveDecimals(double value, unsigned width, int precision = -1);
+
+/**
+ * @brief 把字节数格式化为固定5个字符的可读形式
+ * @param bytes 字节数
+ * @param first 输出缓冲区起始
+ * @param last 输出缓冲区末尾
+ * @return 写入的字节数，空间不足时为0
+ *
+ * 按1024进位、最小单位K：" 512K"、"12.3M"、"1.23G"。
+ * 网络流量、内存和显存共用此格式。
+ */
+size_t formatBytes(uint64_t bytes, char *first, char *last);
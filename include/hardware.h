@@ -0,0 +1,84 @@
+#pragma once
+#include <optional>
+#include <string>
+
+/**
+ * @file hardware.h
+ * @brief 启动时的硬件探测
+ *
+ * 原先System无条件创建所有模块，设备路径也写死在各模块中（hwmon5、card1、
+ * amdgpu_bl1、RAPL/SVI2的编译期开关）。没有对应硬件的机器上，这些模块在运行时
+ * 反复失败，电池模块还要建立一个用不上的D-Bus连接。
+ *
+ * 启动时先探测一次实际存在的硬件，System只创建适用的模块，并把探测到的路径
+ * 传给模块。探测结果以boot_id为键缓存在$XDG_CACHE_HOME/seedstatus/hardware，
+ * 同一次开机内再次启动时直接读取缓存，不再遍历sysfs和打开混音器；重启后
+ * boot_id改变，缓存自动失效。
+ */
+
+/**
+ * @brief 探测到的硬件
+ *
+ * 路径为空表示对应硬件不存在。
+ */
+struct HardwareProfile {
+    std::string boot_id; ///< 探测时的/proc/sys/kernel/random/boot_id
+
+    std::string rapl;       ///< RAPL封装域目录（含energy_uj和max_energy_range_uj）
+    std::string svi2;       ///< zenpower的hwmon目录（power1_input为核心，power2_input为SoC）
+    std::string cpu_temp;   ///< CPU温度输入文件（hwmon的temp*_input）
+    std::string gpu;        ///< DRM设备目录（含gpu_busy_percent和mem_info_vram_used）
+    std::string backlight;  ///< 背光设备目录（含brightness和max_brightness）
+    bool battery = false;   ///< 是否有为系统供电的电池
+    bool playback = false;  ///< 默认混音器是否有带音量的Master元素
+    bool capture = false;   ///< 默认混音器是否有带音量的Capture元素
+};
+
+/**
+ * @brief 硬件探测与缓存
+ */
+class HardwareProbe {
+  public:
+    /**
+     * @brief 获取硬件信息
+     * @param reprobe 为true时忽略缓存重新探测
+     * @return 缓存有效时为缓存内容，否则为新的探测结果（同时写入缓存）
+     */
+    static HardwareProfile load(bool reprobe = false);
+
+    /**
+     * @brief 探测当前硬件
+     * @return 探测结果
+     */
+    static HardwareProfile probe();
+
+    /**
+     * @brief 读取缓存
+     * @param path 缓存文件路径
+     * @param boot_id 当前的boot_id
+     * @return 缓存内容，文件不存在、格式版本不同或boot_id不一致时为空
+     */
+    static std::optional<HardwareProfile>
+    readCache(const std::string &path, const std::string &boot_id);
+
+    /**
+     * @brief 写入缓存（先写临时文件再rename，读取端不会看到半个文件）
+     * @param path 缓存文件路径
+     * @param profile 探测结果
+     * @return true如果写入成功
+     */
+    static bool writeCache(const std::string &path, const HardwareProfile &profile);
+
+    /**
+     * @brief 获取默认缓存路径
+     * @return $XDG_CACHE_HOME/seedstatus/hardware或~/.cache/seedstatus/hardware，
+     *         两个环境变量都没有时为空
+     */
+    static std::string defaultCachePath();
+
+    /**
+     * @brief 读取当前的boot_id
+     * @return boot_id，读取失败时为空（此时不使用缓存）
+     */
+    static std::string currentBootId();
+};
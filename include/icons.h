@@ -0,0 +1,160 @@
+#pragma once
+#include "module.h"
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+/**
+ * @file icons.h
+ * @brief 图标阶梯与颜色阈值表
+ *
+ * 模块原先在每次update()时构造std::vector<std::string>图标表，并用一串if/else
+ * 选择颜色。这里把所有图标阶梯和“数值→颜色”的阈值映射定义为编译期常量表，
+ * 选择函数同样是constexpr，只返回指向静态存储的std::string_view或Color枚举，
+ * 选择过程不分配内存，也可以在static_assert中检查。
+ */
+
+/**
+ * @brief 图标阶梯，按数值从低到高排列
+ */
+template <size_t N> using IconLadder = std::array<std::string_view, N>;
+
+/**
+ * @brief 颜色阈值：数值不低于min时使用color
+ */
+struct ColorThreshold {
+    double min;  ///< 下限（含）
+    Color color; ///< 颜色
+};
+
+/**
+ * @brief 颜色阈值表
+ *
+ * steps按min从高到低排列，取第一个满足的阈值；都不满足时使用below。
+ */
+template <size_t N> struct ColorScale {
+    std::array<ColorThreshold, N> steps; ///< 阈值，从高到低
+    Color below;                         ///< 低于所有阈值时的颜色
+};
+
+/**
+ * @brief 按数值计算图标在阶梯中的索引
+ * @param ladder 图标阶梯
+ * @param value 数值，小于0时按0处理
+ * @param full 满量程，value达到full时选择最后一个图标。默认101，
+ *             使0～100的百分比均匀分布且100落在最后一档
+ * @return 索引，可用于构造RenderKey
+ */
+template <size_t N>
+constexpr size_t pickIconIndex(const IconLadder<N> & /*ladder*/, double value, double full = 101.0) {
+    static_assert(N > 0, "icon ladder must not be empty");
+    if (!(value > 0.0)) {
+        return 0;
+    }
+    const double position = static_cast<double>(N) * value / full;
+    return position >= static_cast<double>(N - 1) ? N - 1 : static_cast<size_t>(position);
+}
+
+/**
+ * @brief 按数值在阶梯中选择图标
+ * @param ladder 图标阶梯
+ * @param value 数值，小于0时按0处理
+ * @param full 满量程，含义同pickIconIndex()
+ * @return 图标
+ */
+template <size_t N>
+constexpr std::string_view pickIcon(const IconLadder<N> &ladder, double value, double full = 101.0) {
+    return ladder[pickIconIndex(ladder, value, full)];
+}
+
+/**
+ * @brief 按数值选择颜色
+ * @param scale 颜色阈值表
+ * @param value 数值
+ * @return 颜色
+ */
+template <size_t N> constexpr Color pickColor(const ColorScale<N> &scale, double value) {
+    for (const ColorThreshold &step : scale.steps) {
+        if (value >= step.min) {
+            return step.color;
+        }
+    }
+    return scale.below;
+}
+
+namespace icons {
+
+// CPU负载
+inline constexpr IconLadder<3> CPU = {
+    "󰾆", "󰾅", "󰓅"
+};
+
+// 温度，0～100°C均分为5档
+inline constexpr IconLadder<5> TEMPERATURE = {
+    "", "", "", "", ""
+};
+
+// 无线信号强度
+inline constexpr IconLadder<6> WIRELESS = {
+    "󰤮", "󰤯", "󰤟", "󰤢", "󰤥", "󰤨"
+};
+
+// 屏幕亮度
+inline constexpr IconLadder<15> BRIGHTNESS = {
+    "", "", "", "", "", "", "", "",
+    "", "", "", "", "", "", ""
+};
+
+// 充电中的电量
+inline constexpr IconLadder<7> BATTERY_CHARGING = {
+    "󰂆", "󰂇", "󰂈", "󰂉", "󰂊", "󰂋", "󰂅"
+};
+
+// 放电中的电量
+inline constexpr IconLadder<11> BATTERY_DISCHARGING = {
+    "󰂎", "󰁺", "󰁻", "󰁼", "󰁽", "󰁾", "󰁿", "󰂀", "󰂁", "󰂂", "󰁹"
+};
+
+// 扬声器音量
+inline constexpr IconLadder<4> VOLUME = {
+    "󰕿", "󰖀", "󰕾", "󰝝"
+};
+
+// 麦克风音量
+inline constexpr IconLadder<4> MICROPHONE = {
+    "󰍮", "󰢳", "󰍬", "󰢴"
+};
+
+} // namespace icons
+
+namespace thresholds {
+
+// CPU使用率（%）
+inline constexpr ColorScale<2> CPU = {{{{60, Color::CRITICAL}, {30, Color::WARNING}}}, Color::IDLE};
+
+// GPU使用率（%）
+inline constexpr ColorScale<2> GPU = {{{{60, Color::CRITICAL}, {30, Color::WARNING}}}, Color::IDLE};
+
+// 内存使用率（%）
+inline constexpr ColorScale<2> MEMORY = {
+    {{{80, Color::CRITICAL}, {50, Color::WARNING}}}, Color::IDLE
+};
+
+// 温度（°C）
+inline constexpr ColorScale<3> TEMPERATURE = {
+    {{{80, Color::CRITICAL}, {60, Color::WARNING}, {30, Color::IDLE}}}, Color::COOL
+};
+
+// 电池电量（%），电量越低越危险
+inline constexpr ColorScale<2> BATTERY = {
+    {{{40, Color::IDLE}, {20, Color::WARNING}}}, Color::CRITICAL
+};
+
+} // namespace thresholds
+
+// 编译期检查阶梯的边界
+static_assert(pickIcon(icons::CPU, 0.0) == icons::CPU.front());
+static_assert(pickIcon(icons::CPU, 100.0) == icons::CPU.back());
+static_assert(pickIcon(icons::TEMPERATURE, 150.0, 100.0) == icons::TEMPERATURE.back());
+static_assert(pickColor(thresholds::TEMPERATURE, 10) == Color::COOL);
+static_assert(pickColor(thresholds::BATTERY, 19) == Color::CRITICAL);
@@ -0,0 +1,188 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file launcher.h
+ * @brief 外部程序启动服务
+ *
+ * 模块点击时需要启动外部程序（网络管理器、音量控制等）。原先直接调用
+ * system("... &")：每次都要fork整个状态栏进程并运行/bin/sh，事件循环阻塞到
+ * shell返回，后台子进程也从不回收，长时间运行后僵尸进程不断累积。
+ *
+ * Launcher使用posix_spawnp()按argv直接启动程序（glibc内部为vfork语义，
+ * 不复制地址空间），不经过shell：
+ * - 子进程的pidfd注册到System的事件循环，退出时立即回收并记录非零退出状态
+ * - 子进程的标准输入和标准输出重定向到/dev/null，不会污染i3bar协议输出
+ * - 子进程的信号掩码和信号处理被重置，并在新会话中运行
+ * - 每个调用者（通常是模块名）有独立的令牌桶限速和并发上限，
+ *   连续点击不会无限制地创建进程
+ */
+
+class System;
+
+/**
+ * @brief 外部程序启动服务
+ */
+class Launcher {
+  public:
+    /**
+     * @brief 子进程退出回调
+     * @param pid 子进程ID
+     * @param status waitpid()返回的状态
+     */
+    using ExitHandler = std::function<void(pid_t pid, int status)>;
+
+    /**
+     * @brief 启动选项
+     */
+    struct SpawnOptions {
+        ExitHandler on_exit;          ///< 可选的退出回调，在事件循环线程中调用
+        int stdin_fd = -1;            ///< 子进程的标准输入，-1表示/dev/null
+        int stdout_fd = -1;           ///< 子进程的标准输出，-1表示/dev/null
+        std::vector<std::string> env; ///< 追加的环境变量（"KEY=VALUE"）
+    };
+
+    /**
+     * @brief 限速参数
+     */
+    struct RateLimit {
+        double per_second = 4.0; ///< 令牌补充速率（每秒可启动的进程数）
+        uint32_t burst = 8;      ///< 令牌桶容量（允许的突发启动数）
+        uint32_t max_running = 8; ///< 同一调用者同时运行的子进程上限
+    };
+
+    /**
+     * @brief 构造函数
+     * @param system 系统对象，用于注册pidfd监听
+     */
+    explicit Launcher(System &system);
+
+    /**
+     * @brief 析构函数
+     *
+     * 关闭所有pidfd，子进程本身继续运行。
+     */
+    ~Launcher();
+
+    // 删除拷贝和移动操作，pidfd监听回调保存了this指针
+    Launcher(const Launcher &) = delete;
+    Launcher &operator=(const Launcher &) = delete;
+    Launcher(Launcher &&) = delete;
+    Launcher &operator=(Launcher &&) = delete;
+
+    /**
+     * @brief 启动外部程序
+     * @param owner 调用者名称，用于限速和日志（通常为模块名）
+     * @param argv 参数列表，argv[0]按PATH查找，以~/开头的参数展开为$HOME
+     * @param on_exit 可选的退出回调，在事件循环线程中调用
+     * @return 子进程ID，被限速或启动失败时返回-1
+     */
+    pid_t spawn(const std::string &owner, std::vector<std::string> argv,
+                ExitHandler on_exit = nullptr);
+
+    /**
+     * @brief 按启动选项启动外部程序
+     * @param owner 调用者名称，用于限速和日志（通常为模块名）
+     * @param argv 参数列表，argv[0]按PATH查找，以~/开头的参数展开为$HOME
+     * @param options 启动选项（标准输入输出重定向、追加环境变量等）
+     * @return 子进程ID，被限速或启动失败时返回-1
+     *
+     * 传入的stdin_fd和stdout_fd由调用者负责关闭。
+     */
+    pid_t spawn(const std::string &owner, std::vector<std::string> argv, SpawnOptions options);
+
+    /**
+     * @brief 向子进程所在的进程组发送信号
+     * @param pid spawn()返回的子进程ID
+     * @param sig 信号
+     * @return true如果该子进程仍由本服务管理且信号发送成功
+     *
+     * 子进程在新会话中运行，因此脚本派生的孙进程也会收到信号。
+     */
+    bool signal(pid_t pid, int sig);
+
+    /**
+     * @brief 清除子进程的退出回调
+     * @param pid spawn()返回的子进程ID
+     *
+     * 回调的持有者先于子进程销毁时调用，子进程退出后仍会被回收。
+     */
+    void detach(pid_t pid);
+
+    /**
+     * @brief 按空白拆分命令行（不支持引号和shell语法）
+     * @param command 命令行，如"pavucontrol -t 3"
+     * @return 参数列表
+     */
+    static std::vector<std::string> splitCommand(const std::string &command);
+
+    /**
+     * @brief 设置限速参数（对之后的启动生效）
+     * @param limit 限速参数
+     */
+    void setRateLimit(const RateLimit &limit);
+
+    /**
+     * @brief 获取尚未退出的子进程数
+     * @return 子进程数
+     */
+    size_t runningCount() const;
+
+    /**
+     * @brief 获取因限速而被拒绝的启动次数
+     * @return 拒绝次数
+     */
+    uint64_t rejectedCount() const;
+
+  private:
+    /**
+     * @brief 一个正在运行的子进程
+     */
+    struct Child {
+        std::string owner;   ///< 调用者名称
+        std::string program; ///< 程序名（argv[0]），用于日志
+        int pidfd = -1;      ///< pidfd，内核不支持时为-1
+        ExitHandler on_exit; ///< 退出回调
+    };
+
+    /**
+     * @brief 调用者的限速状态
+     */
+    struct Bucket {
+        double tokens = 0.0;                              ///< 剩余令牌
+        std::chrono::steady_clock::time_point last_refill; ///< 上次补充时间
+        uint32_t running = 0;                             ///< 正在运行的子进程数
+        bool initialized = false;                         ///< 是否已初始化
+    };
+
+    /**
+     * @brief 尝试为调用者消耗一个令牌
+     * @param owner 调用者名称
+     * @return true如果允许启动
+     */
+    bool acquireToken(const std::string &owner);
+
+    /**
+     * @brief 回收子进程并调用退出回调
+     * @param pid 子进程ID
+     * @return true如果子进程已退出并被回收
+     */
+    bool reap(pid_t pid);
+
+    /**
+     * @brief 回收没有pidfd的已退出子进程（旧内核回退路径）
+     */
+    void reapWithoutPidfd();
+
+    System &system_;                               ///< 系统对象
+    RateLimit rate_limit_;                         ///< 限速参数
+    std::unordered_map<pid_t, Child> children_;    ///< 正在运行的子进程
+    std::unordered_map<std::string, Bucket> buckets_; ///< 调用者→限速状态
+    uint64_t rejected_ = 0;                        ///< 被限速拒绝的次数
+};
@@ -1,9 +1,17 @@
 #pragma once
+#include "telemetry.h"
+#include <array>
+#include <cmath>
+#include <type_traits>
 #include <string>
 #include <memory>
 #include <functional>
 #include <cstdint>
 #include <chrono>
+#include <vector>
+#include <span>
+#include <string_view>
+#include <unordered_map>
 
 /**
  * @file module.h
@@ -19,6 +27,7 @@
  * - 支持文件描述符监控（epoll集成）
  * - 统一的输出格式和颜色管理
  * - 模块间解耦，易于扩展
+ * - 热数据按模块ID以结构数组（SoA）形式集中存放，减少指针追逐
  */
 
 /**
@@ -36,12 +45,114 @@ enum class Color {
     CRITICAL      // #F75341 - 严重状态（红色）
 };
 
+/**
+ * @brief 颜色数量，用于按颜色索引的表
+ */
+inline constexpr size_t COLOR_COUNT = static_cast<size_t>(Color::CRITICAL) + 1;
+
+/**
+ * @brief 颜色的十六进制表示，按Color枚举值索引
+ */
+inline constexpr std::array<std::string_view, COLOR_COUNT> COLOR_STRINGS = {
+    "#6A6862", // DEACTIVE
+    "#729FCF", // COOL
+    "#98BC37", // GOOD
+    "#FCE8C3", // IDLE
+    "#FED06E", // WARNING
+    "#F75341"  // CRITICAL
+};
+
 /**
  * @brief 获取颜色的字符串表示
  * @param color 颜色枚举值
- * @return 对应的十六进制颜色字符串（如"#729FCF"）
+ * @return 对应的十六进制颜色字符串（如"#729FCF"），指向静态存储
+ */
+constexpr std::string_view getColorString(Color color) {
+    const auto index = static_cast<size_t>(color);
+    return index < COLOR_COUNT ? COLOR_STRINGS[index]
+                               : COLOR_STRINGS[static_cast<size_t>(Color::IDLE)];
+}
+
+/**
+ * @brief 模块ID类型
+ *
+ * 模块注册到ModuleManager时分配，作为热数据数组的下标。
+ * ID在进程生命周期内保持稳定，删除模块后其槽位留空而不复用。
+ */
+using ModuleId = uint32_t;
+
+/**
+ * @brief 无效模块ID，表示模块尚未注册
+ */
+inline constexpr ModuleId INVALID_MODULE_ID = UINT32_MAX;
+
+class ModuleManager;
+class System;
+class WorkerPool;
+class OutputBackend;
+struct ModuleTemplate;
+
+/**
+ * @brief 渲染键
+ *
+ * 由模块显示内容所依赖的量化值组成：显示精度下的数值、图标索引、颜色、显示模式等。
+ * 两次更新的渲染键相同时显示内容必然相同，Module::renderOutput()据此跳过格式化和
+ * setOutput()，模块也不会被标记为脏。各部分按值精确比较，不使用哈希，不会误判。
  */
-std::string getColorString(Color color);
+class RenderKey {
+  public:
+    /**
+     * @brief 最多包含的部分数量
+     */
+    static constexpr size_t CAPACITY = 6;
+
+    /**
+     * @brief 添加整数、布尔值或枚举值
+     * @param value 值
+     * @return *this，便于链式调用
+     */
+    template <typename T> RenderKey &add(T value) {
+        static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "use add(value, decimals)");
+        return push(static_cast<int64_t>(value));
+    }
+
+    /**
+     * @brief 添加按显示精度量化的浮点数
+     * @param value 值
+     * @param decimals 显示的小数位数（0～6）
+     * @return *this，便于链式调用
+     *
+     * 小数位数本身也是键的一部分，避免5.00和50.0这样量化后相同的值被误判为相等。
+     */
+    RenderKey &add(double value, int decimals) {
+        static constexpr double SCALE[] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+        const int index = decimals < 0 ? 0 : (decimals > 6 ? 6 : decimals);
+        push(index);
+        return push(std::llround(value * SCALE[index]));
+    }
+
+    /**
+     * @brief 添加按formatBytes()显示形式量化的字节数
+     * @param bytes 字节数
+     * @return *this，便于链式调用
+     */
+    RenderKey &addBytes(uint64_t bytes);
+
+    bool operator==(const RenderKey &other) const {
+        return size_ == other.size_ && parts_ == other.parts_;
+    }
+
+  private:
+    RenderKey &push(int64_t value) {
+        if (size_ < CAPACITY) {
+            parts_[size_++] = value;
+        }
+        return *this;
+    }
+
+    std::array<int64_t, CAPACITY> parts_{}; ///< 各部分的值
+    size_t size_ = 0;                       ///< 已添加的部分数量
+};
 
 /**
  * @brief 模块基类
@@ -91,22 +202,34 @@ class Module {
 
     /**
      * @brief 获取模块名称
-     * @return 模块名称字符串
+     * @return 模块名称的常量引用，不产生拷贝
      */
-    std::string getName() const;
+    const std::string &getName() const;
+
+    /**
+     * @brief 获取模块ID
+     * @return 模块ID，未注册到ModuleManager时返回INVALID_MODULE_ID
+     */
+    ModuleId getId() const;
 
     /**
      * @brief 获取模块输出
-     * @return 当前输出内容
+     * @return 当前输出内容的常量引用，不产生拷贝
+     */
+    const std::string &getOutput() const;
+
+    /**
+     * @brief 获取模块输出的颜色
+     * @return 最近一次setOutput()设置的颜色
      */
-    std::string getOutput() const;
+    Color getColor() const;
 
     /**
      * @brief 设置模块输出
-     * @param output 输出内容
+     * @param output 输出内容，会被复制，可以指向FormatBuffer等临时缓冲区
      * @param color 输出颜色，默认为IDLE
      */
-    void setOutput(const std::string &output, Color color = Color::IDLE);
+    void setOutput(std::string_view output, Color color = Color::IDLE);
 
     /**
      * @brief 设置更新间隔（秒）
@@ -120,6 +243,21 @@ class Module {
      */
     uint64_t getInterval() const;
 
+    /**
+     * @brief 设置update()的时间预算
+     * @param budget 预算，0表示使用ModuleManager的默认预算
+     *
+     * update()在事件循环线程中执行，连续多次超出预算的模块会被自动降级，
+     * 见ModuleManager::DEFAULT_UPDATE_BUDGET。本身就需要较长时间的模块可以放宽预算。
+     */
+    void setUpdateBudget(std::chrono::milliseconds budget);
+
+    /**
+     * @brief 获取update()的时间预算
+     * @return 预算，0表示使用ModuleManager的默认预算
+     */
+    std::chrono::milliseconds getUpdateBudget() const;
+
     /**
      * @brief 设置模块状态
      * @param state 状态值
@@ -132,6 +270,21 @@ class Module {
      */
     uint64_t getState() const;
 
+    /**
+     * @brief 设置刷新信号（与i3blocks的signal属性相同）
+     * @param signal 信号偏移N，收到SIGRTMIN+N时立即更新模块，0表示不使用
+     *
+     * 外部程序可以用pkill -RTMIN+N seedstatus推送更新，
+     * 配合setInterval(0)可以完全关闭该模块的轮询。
+     */
+    void setRefreshSignal(int signal);
+
+    /**
+     * @brief 获取刷新信号
+     * @return 信号偏移，0表示不使用
+     */
+    int getRefreshSignal() const;
+
     /**
      * @brief 更新模块，子类必须实现
      *
@@ -146,13 +299,83 @@ class Module {
      */
     virtual void handleClick(uint64_t button);
 
+    /**
+     * @brief 耗时的启动准备，子类可以重写
+     *
+     * 在init()之前调用一次。调用了setAsyncStart()的模块在工作线程中执行本方法：
+     * 事件循环先输出模块的占位内容，准备完成后才在事件循环线程中调用init()，
+     * 此前不会向模块分发更新和点击。因此本方法只能访问模块自身的数据，
+     * 不能调用setOutput()、setFd()或getSystem()。适合建立D-Bus连接、
+     * 加载混音器等可能阻塞数十到数百毫秒的操作。抛出的异常会被记录，
+     * init()仍然会被调用。
+     */
+    virtual void start();
+
     /**
      * @brief 初始化模块，子类可以重写
      *
-     * 在模块被添加到系统后调用，用于执行一次性初始化操作。
+     * 在模块被添加到系统、start()完成后调用，用于执行一次性初始化操作。
      */
     virtual void init();
 
+    /**
+     * @brief start()是否在工作线程中执行
+     * @return true如果模块调用过setAsyncStart(true)
+     */
+    bool isAsyncStart() const;
+
+    /**
+     * @brief 可能阻塞的采样，子类可以重写
+     *
+     * 调用了setBlockingSample()的模块到期时，ModuleManager不直接调用update()，
+     * 而是在工作线程中调用本方法，完成后再在事件循环线程中调用update()渲染采样结果。
+     * 同一模块同时最多只有一次采样在进行，上一次尚未完成时本次到期被跳过。
+     *
+     * 本方法只能读取数据源并把结果写入模块自己的暂存区，不能调用setOutput()
+     * 或getSystem()。采样进行中handleClick()等方法仍可能在事件循环线程中被调用，
+     * 它们不能访问本方法正在写入的数据，update()中再把暂存区复制出来。
+     */
+    virtual void sample();
+
+    /**
+     * @brief 采样是否在工作线程中执行
+     * @return true如果模块调用过setBlockingSample()
+     */
+    bool isBlockingSample() const;
+
+    /**
+     * @brief 获取采样超时
+     * @return 超时时间，0表示采样不在工作线程中执行
+     */
+    std::chrono::milliseconds getSampleTimeout() const;
+
+    /**
+     * @brief 提交累积的待处理操作，子类可以重写
+     *
+     * 模块调用requestFlush()后，ModuleManager会在本轮事件处理结束、
+     * 输出帧之前调用一次此方法。用于把一帧内的多次点击（如快速滚动）
+     * 合并成一次实际操作。
+     */
+    virtual void flush();
+
+    /**
+     * @brief 保存计算速率所需的计数器，子类可以重写
+     * @param counters 追加计数器的值
+     *
+     * 用于持久化快照（见snapshot.h）。重启后由restoreCounters()恢复为差值的基准，
+     * 第一次采样就能得到速率。时间戳应保存为steady_clock的纳秒数，
+     * 同一次开机内的不同进程之间可以直接比较。
+     */
+    virtual void saveCounters(std::vector<uint64_t> &counters) const;
+
+    /**
+     * @brief 从快照恢复计数器，子类可以重写
+     * @param counters saveCounters()保存的值，数量不符时应忽略
+     *
+     * 在start()和init()之前调用。
+     */
+    virtual void restoreCounters(std::span<const uint64_t> counters);
+
     /**
      * @brief 设置文件描述符（用于epoll）
      * @param fd 文件描述符
@@ -174,6 +397,22 @@ class Module {
      */
     bool shouldDelete() const;
 
+    /**
+     * @brief 渲染缓存统计
+     */
+    struct RenderStats {
+        uint64_t hits = 0;   ///< 渲染键未变化、跳过渲染的次数
+        uint64_t misses = 0; ///< 实际渲染的次数
+    };
+
+    /**
+     * @brief 获取渲染缓存统计
+     * @return 统计数据，未使用renderOutput()的模块全部为0
+     */
+    const RenderStats &getRenderStats() const {
+        return render_stats_;
+    }
+
     /**
      * @brief 标记模块为待删除
      *
@@ -184,17 +423,10 @@ class Module {
     /**
      * @brief 转换为JSON格式的输出
      * @return JSON格式的字符串，符合i3bar协议
-     */
-    std::string toJson() const;
-
-    /**
-     * @brief 读取Uint64格式的文件内容（静态方法）
-     * @param path 文件路径
-     * @return 文件内容作为uint64_t值
      *
-     * 便捷方法，用于读取/sys/目录下的系统信息文件。
+     * 模块ID作为instance字段输出，点击事件据此按整数路由。
      */
-    static uint64_t readUint64File(const std::string &path);
+    std::string toJson() const;
 
     /**
      * @brief 获取最后更新时间
@@ -209,6 +441,24 @@ class Module {
     bool needsUpdate() const;
 
   protected:
+    /**
+     * @brief 设置start()是否在工作线程中执行
+     * @param async true表示在工作线程中执行
+     *
+     * 应在构造函数中调用，同时用setOutput()设置准备期间显示的占位内容。
+     */
+    void setAsyncStart(bool async);
+
+    /**
+     * @brief 把采样移到工作线程中执行
+     * @param timeout 采样超时，超过后模块的输出加上过时标记并以DEACTIVE颜色显示，
+     *                采样完成后由update()恢复；0表示恢复在事件循环线程中直接update()
+     *
+     * 应在构造函数中调用。适用于可能阻塞的数据源：唤醒独立显卡的sysfs读取、
+     * D-Bus往返、网络文件系统的statvfs等。
+     */
+    void setBlockingSample(std::chrono::milliseconds timeout);
+
     /**
      * @brief 更新最后更新时间
      *
@@ -216,15 +466,113 @@ class Module {
      */
     void updateLastUpdateTime();
 
+    /**
+     * @brief 请求在输出本帧之前调用flush()
+     *
+     * 同一帧内多次请求只会触发一次flush()。
+     */
+    void requestFlush();
+
+    /**
+     * @brief 通过ModuleManager立即更新本模块
+     *
+     * 点击、混音器回调等不经过定时器和模块自身文件描述符的更新应调用本函数而不是
+     * 直接调用update()：与定时更新一样经过隔离检查，计入时间预算、延迟直方图、
+     * 时间线追踪和USDT探针。模块尚未注册时直接调用update()。
+     */
+    void requestUpdate();
+
+    /**
+     * @brief 获取所属的系统对象
+     * @return 系统对象指针，模块尚未通过System::addModule()注册时为nullptr
+     *
+     * 在init()及之后可用，用于注册额外的文件描述符监听等。
+     */
+    System *getSystem() const;
+
+    /**
+     * @brief 渲染键变化时才渲染输出
+     * @param key 本次采样的渲染键
+     * @param render 渲染函数，内部调用setOutput()
+     *
+     * 键与上一次渲染时相同则直接返回并计为命中。任何绕过本函数的setOutput()
+     * （如错误时输出的占位内容）都会使记录的键失效，下一次必然重新渲染。
+     *
+     * @code
+     * const double usage = getUsage();
+     * renderOutput(RenderKey().add(usage, 1).add(getState()), [&] {
+     *     FormatBuffer buffer;
+     *     setOutput(format_.render(buffer, usage), Color::IDLE);
+     * });
+     * @endcode
+     */
+    template <typename Render> void renderOutput(const RenderKey &key, Render &&render) {
+        if (render_key_valid_ && key == render_key_) {
+            ++render_stats_.hits;
+            return;
+        }
+        ++render_stats_.misses;
+        render();
+        render_key_ = key;
+        render_key_valid_ = true;
+    }
+
+    /**
+     * @brief 显示数据源不可用时的占位内容
+     * @param placeholder 占位内容，以DEACTIVE颜色显示
+     *
+     * 与renderOutput()共用渲染缓存，数据源持续不可用时只在第一次设置输出。
+     */
+    void setUnavailable(std::string_view placeholder);
+
+    /**
+     * @brief 采样超时后附加在输出末尾的过时标记
+     */
+    static constexpr std::string_view STALE_MARKER = "\u2004󰔟";
+
+    /**
+     * @brief 模块因反复超出时间预算被隔离时附加在输出末尾的标记
+     */
+    static constexpr std::string_view QUARANTINE_MARKER = "\u2004󰒲";
+
   private:
+    /**
+     * @brief 采样超时时显示过时标记
+     *
+     * 保留原有文本并附加STALE_MARKER，以DEACTIVE颜色显示。下一次setOutput()
+     * （通常是采样完成后的update()）清除标记。
+     */
+    void markStale();
+
+    /**
+     * @brief 模块被隔离时显示隔离标记
+     *
+     * 保留原有文本并附加QUARANTINE_MARKER，以DEACTIVE颜色显示。
+     */
+    void markQuarantined();
+
+    friend class ModuleManager;
+    friend class System;
+
     std::string name_;                                       ///< 模块名称
     std::string output_;                                     ///< 当前输出内容
-    std::string color_;                                      ///< 当前颜色值
+    Color color_ = Color::IDLE;                              ///< 当前颜色
     uint64_t interval_ = 0;                                  ///< 更新间隔（秒）
     uint64_t state_ = 0;                                     ///< 模块状态
+    int refresh_signal_ = 0;                                 ///< 刷新信号偏移
     int fd_ = -1;                                            ///< 文件描述符
     volatile bool should_delete_ = false;                    ///< 删除标记
+    bool async_start_ = false;                               ///< start()是否在工作线程中执行
+    bool stale_ = false;                                     ///< 输出是否带有过时标记
+    std::chrono::milliseconds sample_timeout_{0};            ///< 采样超时，0表示不在工作线程中采样
+    std::chrono::milliseconds update_budget_{0};             ///< update()的时间预算，0表示使用默认值
     std::chrono::steady_clock::time_point last_update_time_; ///< 最后更新时间
+    ModuleManager *manager_ = nullptr;                       ///< 所属模块管理器
+    System *system_ = nullptr;                               ///< 所属系统对象
+    ModuleId id_ = INVALID_MODULE_ID;                        ///< 模块ID
+    RenderKey render_key_;                                   ///< 上一次渲染的键
+    bool render_key_valid_ = false;                          ///< render_key_是否有效
+    RenderStats render_stats_;                               ///< 渲染缓存统计
 };
 
 /**
@@ -240,53 +588,122 @@ class Module {
  * - 自动清理标记为删除的模块
  * - 支持STL风格的迭代器接口
  *
+ * 数据布局：
+ * 每个模块在注册时获得一个ModuleId。定时调度、事件分发和帧拼装所需的热字段
+ * （脏标记、下次到期时刻、更新间隔、颜色、帧片段偏移、文件描述符）以结构数组
+ * 形式按ID连续存放，多态的Module对象作为冷数据放在其后，只在真正需要更新或
+ * 重新序列化时才被访问。帧拼装时只有脏模块会重新生成JSON片段，其余模块直接
+ * 从片段缓冲区中按偏移拷贝。
+ *
+ * 模块名称在注册时驻留到哈希索引中（名称→首个同名模块ID），
+ * 模块ID同时作为i3bar的instance字段输出，点击事件优先按ID路由，
+ * 整个分发过程不产生内存分配。
+ *
+ * 片段的格式由输出后端（OutputBackend）决定，模块注册时按后端预编译模板，
+ * 重新生成片段只需转换模块文本并拷贝模板。
+ *
+ * 时间预算：
+ * 每次update()都按模块的时间预算计时。连续BUDGET_STRIKES次超出预算的模块被降级：
+ * 定时模块的间隔先逐级加倍（最多MAX_SLOWDOWN级），仍然超出时被隔离，
+ * 隔离期间不再定时更新，输出附加隔离标记。隔离期满后试运行一次，
+ * 在预算内即解除隔离，否则以加倍的时长再次隔离。降级的模块连续RECOVERY_UPDATES次
+ * 在预算内后逐级恢复原来的间隔。文件描述符事件在隔离期间仍然分发，
+ * 否则水平触发的fd会让事件循环空转。
+ *
  * 使用示例：
  * @code
  * ModuleManager manager;
  * auto module = std::make_shared<MyModule>();
  * manager.addModule(module);
- * manager.outputModules(); // 输出所有模块
+ * const std::string &frame = manager.buildFrame(); // 拼装一帧
  * @endcode
  */
 class ModuleManager {
   public:
     /**
-     * @brief 默认构造函数
+     * @brief 模块未设置预算时update()的默认时间预算
+     */
+    static constexpr std::chrono::milliseconds DEFAULT_UPDATE_BUDGET{10};
+
+    /**
+     * @brief 连续超出预算多少次后降级一级
      */
-    ModuleManager() = default;
+    static constexpr uint8_t BUDGET_STRIKES = 3;
+
+    /**
+     * @brief 间隔最多加倍的级数，之后再超出预算则隔离
+     */
+    static constexpr uint8_t MAX_SLOWDOWN = 2;
+
+    /**
+     * @brief 第一次隔离的时长（定时器节拍，即秒），之后每次加倍，最多加倍到16倍
+     */
+    static constexpr uint64_t QUARANTINE_TICKS = 60;
+
+    /**
+     * @brief 降级的模块连续多少次在预算内后恢复一级
+     */
+    static constexpr uint32_t RECOVERY_UPDATES = 30;
+
+    /**
+     * @brief 模块的时间预算统计
+     */
+    struct BudgetStats {
+        std::chrono::milliseconds budget{0}; ///< 生效的预算
+        uint64_t overruns = 0;               ///< 超出预算的update()次数
+        int64_t max_ns = 0;                  ///< 最长一次update()的耗时（纳秒）
+        uint8_t slowdown = 0;                ///< 间隔加倍的级数
+        uint8_t quarantines = 0;             ///< 被隔离的次数
+        bool quarantined = false;            ///< 当前是否处于隔离中
+    };
+
+    /**
+     * @brief 本轮事件处理中最慢的一次update()
+     */
+    struct SlowestUpdate {
+        ModuleId id = INVALID_MODULE_ID; ///< 模块ID，本轮没有update()时为INVALID_MODULE_ID
+        int64_t ns = 0;                  ///< 耗时（纳秒）
+    };
+
+    /**
+     * @brief 默认构造函数，使用i3bar输出后端
+     */
+    ModuleManager();
 
     /**
      * @brief 析构函数
      */
-    ~ModuleManager() = default;
+    ~ModuleManager();
 
     // 删除拷贝构造和赋值操作
     ModuleManager(const ModuleManager &) = delete;
     ModuleManager &operator=(const ModuleManager &) = delete;
 
-    // 允许移动操作
-    ModuleManager(ModuleManager &&) = default;
-    ModuleManager &operator=(ModuleManager &&) = default;
+    // 删除移动操作（模块持有指向管理器的指针）
+    ModuleManager(ModuleManager &&) = delete;
+    ModuleManager &operator=(ModuleManager &&) = delete;
 
     /**
      * @brief 添加模块
      * @param module 要添加的模块共享指针
+     * @return 分配给该模块的ID
      *
      * 模块会被添加到管理器的内部列表中，
-     * 之后可以通过名称或索引访问。
+     * 之后可以通过名称、索引或ID访问。
      */
-    void addModule(std::shared_ptr<Module> module);
+    ModuleId addModule(std::shared_ptr<Module> module);
 
     /**
      * @brief 获取模块总数
-     * @return 模块数量
+     * @return 模块槽位数量（包括已删除模块留下的空槽位）
      */
     size_t getModuleCount() const;
 
     /**
      * @brief 通过索引获取模块
-     * @param index 模块索引
-     * @return 模块共享指针，如果索引无效返回nullptr
+     * @param index 模块索引（即模块ID）
+     * @return 模块共享指针，槽位为空时返回nullptr
+     * @throws std::out_of_range 如果索引无效
      */
     std::shared_ptr<Module> getModule(size_t index) const;
 
@@ -294,28 +711,216 @@ class ModuleManager {
      * @brief 通过名称获取模块
      * @param name 模块名称
      * @return 模块共享指针，如果未找到返回nullptr
+     *
+     * 存在同名模块时返回最先注册的一个。
+     */
+    std::shared_ptr<Module> getModuleByName(std::string_view name) const;
+
+    /**
+     * @brief 通过名称查找模块ID
+     * @param name 模块名称
+     * @return 最先注册的同名模块ID，未找到返回INVALID_MODULE_ID
+     *
+     * 哈希索引查找，O(1)且不分配内存。
+     */
+    ModuleId findModuleId(std::string_view name) const;
+
+    /**
+     * @brief 将点击事件分发给模块
+     * @param id 目标模块ID
+     * @param button 鼠标按钮编号
+     * @return true如果找到目标模块
+     */
+    bool dispatchClick(ModuleId id, uint64_t button);
+
+    /**
+     * @brief 设置模块是否已就绪
+     * @param id 模块ID
+     * @param ready false表示模块仍在启动，不向其分发更新、点击和flush
+     *
+     * 新注册的模块默认已就绪，异步启动的模块由System在start()完成后标记。
+     */
+    void setReady(ModuleId id, bool ready);
+
+    /**
+     * @brief 检查模块是否已就绪
+     * @param id 模块ID
+     * @return true如果模块存在且已完成启动
+     */
+    bool isReady(ModuleId id) const;
+
+    /**
+     * @brief 设置执行阻塞采样的工作线程池
+     * @param workers 线程池，为nullptr时阻塞采样在事件循环线程中同步执行
+     *
+     * 线程池必须比管理器中的采样任务存活更久。
+     */
+    void setWorkerPool(WorkerPool *workers);
+
+    /**
+     * @brief 检查模块是否有采样正在工作线程中进行
+     * @param id 模块ID
+     * @return true如果sample()已提交、尚未完成
+     */
+    bool isSampling(ModuleId id) const;
+
+    /**
+     * @brief 获取距最近一个采样超时的时间
+     * @return 毫秒数（向上取整），没有进行中的采样时为-1，可直接作为epoll_wait的超时
+     */
+    int getSampleWaitTimeout() const;
+
+    /**
+     * @brief 给超时的采样显示过时标记
+     *
+     * 每次epoll_wait返回后调用。每次采样最多标记一次，采样最终完成时由update()恢复。
+     */
+    void expireSamples();
+
+    /**
+     * @brief 设置模块未设置预算时使用的默认时间预算
+     * @param budget 默认预算，必须大于0
+     */
+    void setDefaultUpdateBudget(std::chrono::milliseconds budget);
+
+    /**
+     * @brief 获取默认时间预算
+     */
+    std::chrono::milliseconds getDefaultUpdateBudget() const;
+
+    /**
+     * @brief 获取模块的时间预算统计
+     * @param id 模块ID
+     * @return 统计数据，模块不存在时全部为0
+     */
+    BudgetStats getBudgetStats(ModuleId id) const;
+
+    /**
+     * @brief 解除模块的降级和隔离
+     * @param id 模块ID
+     *
+     * 恢复原来的间隔并清除超出次数，如修改了模块的预算之后。
+     */
+    void resetBudget(ModuleId id);
+
+    /**
+     * @brief 获取模块update()耗时的分布
+     * @param id 模块ID
+     * @return 直方图（纳秒），模块不存在时为空直方图
+     */
+    const Histogram &getUpdateLatency(ModuleId id) const;
+
+    /**
+     * @brief 开始新一轮事件处理，清除最慢update()的记录
+     */
+    void beginIteration();
+
+    /**
+     * @brief 获取本轮事件处理中最慢的一次update()
+     */
+    SlowestUpdate getSlowestUpdate() const;
+
+    /**
+     * @brief 标记模块输出已变化
+     * @param id 模块ID
+     *
+     * 下一次拼装帧时会重新生成该模块的JSON片段。
+     */
+    void markDirty(ModuleId id);
+
+    /**
+     * @brief 处理定时器节拍
+     * @param counter 定时器累计节拍数（秒）
+     *
+     * 扫描间隔与到期时刻数组，更新所有已到期的模块。
+     * 到期时刻按间隔对齐，与原先 counter % interval == 0 的语义一致。
+     */
+    void dispatchTick(uint64_t counter);
+
+    /**
+     * @brief 处理模块文件描述符事件
+     * @param id 产生事件的模块ID
+     */
+    void dispatchEvent(ModuleId id);
+
+    /**
+     * @brief 立即更新所有模块
+     *
+     * 用于从暂停状态恢复等需要完整刷新的场景，定时模块的到期时刻
+     * 从当前节拍重新计算。
+     */
+    void refreshAll();
+
+    /**
+     * @brief 立即更新单个模块
+     * @param id 模块ID
+     *
+     * 与定时更新相同：阻塞采样的模块先在工作线程中采样，完成后才调用update()。
+     */
+    void refreshModule(ModuleId id);
+
+    /**
+     * @brief 更新所有使用指定刷新信号的模块
+     * @param signal 信号偏移（SIGRTMIN+signal）
+     * @return 被更新的模块数
+     */
+    size_t refreshBySignal(int signal);
+
+    /**
+     * @brief 调用所有请求了flush的模块的flush()方法
+     *
+     * 在每轮事件处理之后、输出帧之前调用。
+     */
+    void flushPending();
+
+    /**
+     * @brief 拼装当前帧
+     * @return 符合i3bar协议的一帧JSON（包括结尾的",\n"）
+     *
+     * 没有脏模块时直接返回上一帧，不做任何格式化。
+     */
+    const std::string &buildFrame();
+
+    /**
+     * @brief 设置输出后端
+     * @param backend 输出后端，不能为空
+     *
+     * 为所有已注册模块重新编译模板，下一次buildFrame()按新格式完整重建。
+     */
+    void setBackend(std::unique_ptr<OutputBackend> backend);
+
+    /**
+     * @brief 获取输出后端
+     * @return 输出后端的常量引用
      */
-    std::shared_ptr<Module> getModuleByName(const std::string &name) const;
+    const OutputBackend &getBackend() const;
 
     /**
-     * @brief 输出所有模块的JSON
+     * @brief 是否有模块输出在上一次拼装后发生了变化
+     * @return true如果下一次buildFrame()会生成新的帧
      *
-     * 将所有模块的输出格式化为JSON数组，符合i3bar协议要求。
-     * 输出到标准输出，供i3bar/swaybar等状态栏程序使用。
+     * 帧由System交给OutputWriter写出，没有变化时不必重复提交。
      */
-    void outputModules() const;
+    bool hasFrameChanges() const;
 
     /**
      * @brief 移除标记为删除的模块
      *
      * 清理所有被shouldDelete()标记为删除的模块。
-     * 通常在主循环中定期调用。
+     * 被删除模块的槽位会被清空，其ID不会被复用。
      */
     void removeMarkedModules();
 
+    /**
+     * @brief 移除所有模块
+     *
+     * 按注册顺序销毁模块，用于在系统对象析构前释放模块持有的资源。
+     */
+    void clear();
+
     /**
      * @brief 获取所有模块（只读）
-     * @return 模块向量的常量引用
+     * @return 模块向量的常量引用，已删除模块的槽位为nullptr
      */
     const std::vector<std::shared_ptr<Module>> &getModules() const;
 
@@ -336,5 +941,148 @@ class ModuleManager {
     }
 
   private:
-    std::vector<std::shared_ptr<Module>> modules_; ///< 模块列表
+    friend class Module;
+
+    /**
+     * @brief 模块间隔变化时同步热数据
+     * @param id 模块ID
+     * @param interval 新的更新间隔（秒）
+     */
+    void onIntervalChanged(ModuleId id, uint64_t interval);
+
+    /**
+     * @brief 模块文件描述符变化时同步热数据
+     * @param id 模块ID
+     * @param fd 新的文件描述符
+     */
+    void onFdChanged(ModuleId id, int fd);
+
+    /**
+     * @brief 模块输出变化时同步热数据
+     * @param id 模块ID
+     * @param color 新的颜色
+     */
+    void onOutputChanged(ModuleId id, Color color);
+
+    /**
+     * @brief 模块请求flush时记录标记
+     * @param id 模块ID
+     */
+    void onFlushRequested(ModuleId id);
+
+    /**
+     * @brief 在异常保护下更新单个模块
+     * @param id 模块ID
+     * @param from_event 是否由文件描述符事件触发，隔离中的模块仍然处理这类更新
+     */
+    void updateModule(ModuleId id, bool from_event = false);
+
+    /**
+     * @brief 在异常保护下调用update()并计入时间预算
+     * @param id 模块ID
+     * @param module 模块
+     */
+    void runUpdate(ModuleId id, Module &module);
+
+    /**
+     * @brief 记录一次update()的耗时，按需降级或隔离模块
+     * @param id 模块ID
+     * @param module 模块
+     * @param elapsed 耗时（纳秒）
+     */
+    void chargeBudget(ModuleId id, Module &module, int64_t elapsed);
+
+    /**
+     * @brief 隔离模块
+     * @param id 模块ID
+     * @param module 模块
+     */
+    void quarantine(ModuleId id, Module &module);
+
+    /**
+     * @brief 按降级级数把模块自己的间隔写入热数据
+     * @param id 模块ID
+     */
+    void applyInterval(ModuleId id);
+
+    /**
+     * @brief 把模块的sample()提交到工作线程池
+     * @param id 模块ID
+     *
+     * 上一次采样尚未完成时直接返回。
+     */
+    void startSample(ModuleId id);
+
+    /**
+     * @brief 采样完成后在事件循环线程中调用update()
+     * @param id 模块ID
+     * @param module 提交采样时的模块，槽位已被删除或替换时不再更新
+     */
+    void finishSample(ModuleId id, const std::shared_ptr<Module> &module);
+
+    /**
+     * @brief 按预编译模板生成单个模块的帧片段并追加到缓冲区
+     * @param id 模块ID
+     * @param out 输出缓冲区
+     */
+    void appendFragment(ModuleId id, std::string &out) const;
+
+    /**
+     * @brief 从名称索引中移除模块
+     * @param id 被移除的模块ID
+     *
+     * 如果索引指向该模块，则改为指向下一个同名模块（如果有）。
+     */
+    void unindexName(ModuleId id);
+
+    // 冷数据：多态模块对象
+    std::vector<std::shared_ptr<Module>> modules_; ///< 模块列表（按ID索引）
+
+    // 输出后端和按模块ID索引的预编译模板
+    std::unique_ptr<OutputBackend> backend_;   ///< 输出后端
+    std::vector<ModuleTemplate> templates_;    ///< 模块模板（按ID索引）
+
+    // 名称索引：键指向模块自身持有的名称字符串
+    std::unordered_map<std::string_view, ModuleId> name_index_; ///< 名称→模块ID
+
+    // 热数据：按模块ID索引的结构数组
+    std::vector<uint8_t> dirty_;              ///< 输出是否已变化
+    std::vector<uint64_t> next_deadline_;     ///< 下次定时更新的节拍
+    std::vector<uint64_t> interval_;          ///< 更新间隔（秒），0表示不定时更新
+    std::vector<Color> color_;                ///< 当前颜色
+    std::vector<uint32_t> fragment_offset_;   ///< 片段在片段缓冲区中的偏移
+    std::vector<uint32_t> fragment_size_;     ///< 片段长度，0表示不输出
+    std::vector<int> fd_;                     ///< 文件描述符，-1表示未设置
+    std::vector<uint8_t> flush_pending_;      ///< 是否等待flush
+    std::vector<uint8_t> ready_;              ///< 是否已完成启动
+    std::vector<uint8_t> sampling_;           ///< 是否有采样在工作线程中进行
+    std::vector<int64_t> sample_deadline_;    ///< 进行中采样的超时时刻（steady_clock纳秒），0表示已标记或没有采样
+
+    /**
+     * @brief 单个模块的时间预算状态
+     */
+    struct BudgetState {
+        uint64_t overruns = 0;         ///< 超出预算的次数
+        int64_t max_ns = 0;            ///< 最长一次update()的耗时
+        uint64_t quarantine_until = 0; ///< 隔离结束的节拍，0表示未隔离
+        uint32_t good_updates = 0;     ///< 降级后连续在预算内的次数
+        uint8_t strikes = 0;           ///< 连续超出预算的次数
+        uint8_t slowdown = 0;          ///< 间隔加倍的级数
+        uint8_t quarantines = 0;       ///< 被隔离的次数
+        bool probation = false;        ///< 隔离期满后的试运行
+    };
+
+    std::vector<BudgetState> budget_;         ///< 时间预算状态（按ID索引，只在update()前后访问）
+    std::vector<Histogram> update_latency_;   ///< update()耗时的分布（按ID索引）
+    std::chrono::milliseconds default_budget_ = DEFAULT_UPDATE_BUDGET; ///< 默认时间预算
+    SlowestUpdate slowest_;                   ///< 本轮最慢的update()
+
+    uint64_t tick_ = 0;         ///< 最近一次处理的定时器节拍
+    WorkerPool *workers_ = nullptr;  ///< 执行阻塞采样的线程池
+    size_t samples_in_flight_ = 0;   ///< 进行中的采样数
+    bool frame_dirty_ = true;   ///< 是否存在脏模块
+    bool flush_pending_any_ = false; ///< 是否存在等待flush的模块
+    std::string fragments_;     ///< 所有模块片段的连续缓冲区
+    std::string fragments_tmp_; ///< 重建片段缓冲区时使用的备用缓冲区
+    std::string frame_;         ///< 最近一次拼装的完整帧
 };
\ No newline at end of file
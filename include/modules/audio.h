@@ -1,15 +1,16 @@
 #pragma once
 #include "module.h"
-#include <alsa/asoundlib.h>
+#include <alsa_mixer.h>
 #include <memory>
 #include <string>
 #include <optional>
 
-// 音频模块基类 - 提供ALSA混音器的通用功能
-class AudioModule : public Module {
+// 音频模块基类 - 通过共享的ALSA混音器连接订阅一个元素
+class AudioModule : public Module, public MixerElementListener {
   public:
-    explicit AudioModule(const std::string &name, const std::string &element_name);
-    virtual ~AudioModule();
+    // capture为true时控制录音方向（麦克风），否则控制播放方向
+    AudioModule(const std::string &name, const std::string &element_name, bool capture);
+    virtual ~AudioModule() override;
 
     // 删除拷贝构造和赋值操作
     AudioModule(const AudioModule &) = delete;
@@ -25,83 +26,95 @@ class AudioModule : public Module {
     // 处理点击事件
     virtual void handleClick(uint64_t button) override;
 
+    // 在工作线程中预先加载混音器
+    virtual void start() override;
+
     // 初始化模块
     virtual void init() override;
 
+    // 将一帧内累积的滚动和静音操作一次性写入混音器
+    virtual void flush() override;
+
+    // 滚轮每一格默认调整的音量百分比
+    static constexpr uint64_t DEFAULT_VOLUME_STEP = 5;
+
+    // 设置滚轮每一格调整的音量百分比（映射后的刻度，1～100），由--volume-step=设置
+    void setVolumeStep(uint64_t step);
+
+    // 设置外部音量脚本，非空时滚轮和右键改为调用"<脚本> i|d|t"（旧行为），由--volume-command=设置
+    void setVolumeCommand(const std::string &command);
+
   protected:
     // 获取音量值（子类需要实现具体的获取逻辑）
     virtual int64_t getVolume() = 0;
 
     // 获取音量图标（子类需要实现）
-    virtual std::string getVolumeIcon(int64_t volume) = 0;
+    virtual std::string_view getVolumeIcon(int64_t volume) = 0;
 
     // 格式化输出字符串（子类可以重写）
     virtual std::string formatOutput(int64_t volume);
 
-    // 处理ALSA混音器事件
-    void handleMixerEvents();
+    // 读取订阅元素的映射后音量，静音时为-1，元素不可用时为空
+    std::optional<int64_t> readVolume() const;
 
-    // ALSA混音器句柄
-    std::unique_ptr<snd_mixer_t, decltype(&snd_mixer_close)> mixer_handle_;
+    // 订阅的元素值变化或重新出现
+    virtual void onMixerElementChanged() override;
+
+    // 订阅的元素被移除或声卡断开
+    virtual void onMixerElementLost() override;
 
     // 混音器元素名称
     std::string element_name_;
 
-    // 混音器元素
-    snd_mixer_elem_t *mixer_elem_ = nullptr;
+    // 共享的混音器连接
+    std::shared_ptr<AlsaMixerHub> mixer_;
+
+    // 是否为录音方向
+    bool capture_ = false;
 
-    // ALSA混音器文件描述符
-    int mixer_fd_ = -1;
+    // 每一格滚轮的音量步长（百分比）
+    uint64_t volume_step_ = DEFAULT_VOLUME_STEP;
 
-    // 现代化的ALSA混音器包装器
-    std::unique_ptr<class AlsaMixerWrapper> mixer_wrapper_;
+    // 可选的外部音量脚本
+    std::string volume_command_;
 
-  private:
-    // 初始化ALSA混音器
-    bool initializeMixer();
+    // 等待flush的音量步数（正数增加，负数减少）
+    int64_t pending_steps_ = 0;
 
-    // 清理ALSA资源
-    void cleanupMixer();
+    // 等待flush的静音切换
+    bool pending_mute_toggle_ = false;
 };
 
 // 音量模块 - 控制系统主音量
 class VolumeModule : public AudioModule {
   public:
     VolumeModule();
-    ~VolumeModule() = default;
+    ~VolumeModule() override = default;
 
   protected:
     // 获取音量值
     virtual int64_t getVolume() override;
 
     // 获取音量图标
-    virtual std::string getVolumeIcon(int64_t volume) override;
+    virtual std::string_view getVolumeIcon(int64_t volume) override;
 
     // 格式化输出字符串
     virtual std::string formatOutput(int64_t volume) override;
-
-  private:
-    // 音量图标定义
-    static const std::vector<std::string> volume_icons_;
 };
 
 // 麦克风模块 - 控制麦克风音量
 class MicrophoneModule : public AudioModule {
   public:
     MicrophoneModule();
-    ~MicrophoneModule() = default;
+    ~MicrophoneModule() override = default;
 
   protected:
     // 获取音量值
     virtual int64_t getVolume() override;
 
     // 获取音量图标
-    virtual std::string getVolumeIcon(int64_t volume) override;
+    virtual std::string_view getVolumeIcon(int64_t volume) override;
 
     // 格式化输出字符串
     virtual std::string formatOutput(int64_t volume) override;
-
-  private:
-    // 麦克风图标定义
-    static const std::vector<std::string> microphone_icons_;
 };
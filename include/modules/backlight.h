@@ -1,13 +1,18 @@
 #pragma once
 #include "module.h"
+#include "format.h"
+#include "sample_source.h"
 #include <string>
-#include <vector>
 
 // 背光模块 - 控制屏幕背光亮度
 class BacklightModule : public Module {
   public:
-    BacklightModule();
-    ~BacklightModule();
+    // 默认的背光设备目录
+    static constexpr const char *DEFAULT_DEVICE = "/sys/class/backlight/amdgpu_bl1";
+
+    // device为背光设备目录，由启动时的硬件探测决定
+    explicit BacklightModule(const std::string &device = DEFAULT_DEVICE);
+    ~BacklightModule() override;
 
     // 删除拷贝构造和赋值操作
     BacklightModule(const BacklightModule &) = delete;
@@ -28,19 +33,19 @@ class BacklightModule : public Module {
 
   private:
     // 获取背光亮度百分比
-    uint64_t getBrightnessPercent();
+    Result<uint64_t> getBrightnessPercent();
 
     // 获取背光图标
-    std::string getBrightnessIcon(uint64_t brightness_percent);
+    std::string_view getBrightnessIcon(uint64_t brightness_percent);
 
     // 格式化输出字符串
-    std::string formatOutput(uint64_t brightness_percent);
+    std::string_view formatOutput(FormatBuffer &buffer, uint64_t brightness_percent);
 
-    // 背光亮度文件路径
-    static const std::string BRIGHTNESS_PATH;
+    // 输出模板
+    FormatTemplate format_{"{icon}\u2004{percent:2d}%", {"icon", "percent"}};
 
-    // 最大背光亮度文件路径
-    static const std::string MAX_BRIGHTNESS_PATH;
+    // 背光亮度文件路径
+    std::string brightness_path_;
 
     // inotify文件描述符
     int inotify_fd_ = -1;
@@ -48,6 +53,7 @@ class BacklightModule : public Module {
     // 监视描述符
     int watch_fd_ = -1;
 
-    // 背光图标定义
-    static const std::vector<std::string> brightness_icons_;
+    // 数据源
+    SampleSource brightness_{brightness_path_};
+    SampleSource max_brightness_;
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include "module.h"
+#include "format.h"
+#include "dbus_call.h"
 #include <sdbus-c++/sdbus-c++.h>
 #include <string>
 #include <vector>
@@ -11,6 +13,7 @@ class BatteryModule : public Module {
     ~BatteryModule() override;
 
     // 重写基类方法
+    void start() override;
     void init() override;
     void update() override;
     void handleClick(uint64_t button) override;
@@ -27,12 +30,33 @@ class BatteryModule : public Module {
         PENDING_DISCHARGE = 6
     };
 
+    // 最近一次获取的电池信息
+    struct BatteryInfo {
+        BatteryState state = BatteryState::UNKNOWN;
+        double percentage = 0.0;
+        int64_t time = -1; // 充满或耗尽的剩余秒数，未知时为-1
+        double energy = 0.0;
+        double energy_rate = 0.0;
+    };
+
     // sdbus-c++相关方法
     void setupDBusConnection();
     void setupDBusMonitoring();
-    void getBatteryInfo(
-        BatteryState &state, double &percentage, int64_t &time, double &energy, double &energy_rate
-    );
+
+    // 处理连接上的待处理事件（信号和异步调用的回复）
+    void processEvents();
+
+    // 请求重新获取电池信息，获取正在进行时合并为再获取一次
+    void requestRefresh();
+
+    // 用一次异步的GetAll获取所有属性，不阻塞事件循环
+    Task<> refresh();
+
+    // 从GetAll的结果中提取电池信息
+    void applyProperties(const std::map<std::string, sdbus::Variant> &properties);
+
+    // 按当前显示模式渲染info_
+    void render();
 
     // DBus信号处理方法
     void onPropertiesChanged(
@@ -43,41 +67,46 @@ class BatteryModule : public Module {
     void onDeviceChanged();
 
     // 辅助方法
-    std::string getBatteryIcon(BatteryState state, uint64_t percentage);
-    std::string formatTime(int64_t seconds);
-    std::string formatOutput(
-        BatteryState state, uint64_t percentage, double energy, double energy_rate, int64_t time
+    std::string_view getBatteryIcon(BatteryState state, uint64_t percentage);
+    std::string_view formatOutput(
+        FormatBuffer &buffer, BatteryState state, uint64_t percentage, double energy,
+        double energy_rate, int64_t time
     );
 
     // 静态常量
     static const std::string UPOWER_SERVICE;
     static const std::string DEVICE_INTERFACE;
+    static const std::string PROPERTIES_INTERFACE;
     static const std::string BATTERY_PATH;
 
-    // 充电图标数组
-    static const std::vector<std::string> charging_icons_;
-
-    // 放电图标数组
-    static const std::vector<std::string> discharging_icons_;
-
     // sdbus-c++连接和代理
     std::unique_ptr<sdbus::IConnection> connection_;
     std::unique_ptr<sdbus::IProxy> upowerProxy_;
 
+    // D-Bus连接的文件描述符，未监听时为-1
+    int dbus_fd_ = -1;
+
+    // 电池信息，has_info_为false时还没有成功获取过
+    BatteryInfo info_;
+    bool has_info_ = false;
+
+    // 是否有refresh()正在进行，以及进行期间是否又收到了刷新请求
+    bool refreshing_ = false;
+    bool refresh_again_ = false;
+
     // 显示模式：true显示详细模式（能量信息），false显示简单模式（百分比）
     bool detailed_mode_;
+
+    // 输出模板：简单模式、简单模式带剩余时间、详细模式、详细模式带功率
+    FormatTemplate simple_format_;
+    FormatTemplate simple_time_format_;
+    FormatTemplate detailed_format_;
+    FormatTemplate detailed_rate_format_;
 };
 
 // 静态成员定义
 inline const std::string BatteryModule::UPOWER_SERVICE = "org.freedesktop.UPower";
 inline const std::string BatteryModule::DEVICE_INTERFACE = "org.freedesktop.UPower.Device";
+inline const std::string BatteryModule::PROPERTIES_INTERFACE = "org.freedesktop.DBus.Properties";
 inline const std::string BatteryModule::BATTERY_PATH =
     "/org/freedesktop/UPower/devices/battery_BAT0";
-
-inline const std::vector<std::string> BatteryModule::charging_icons_ = {"󰂆", "󰂇", "󰂈",
-                                                                        "󰂉", "󰂊", "󰂋",
-                                                                        "󰂅"};
-
-inline const std::vector<std::string> BatteryModule::discharging_icons_ = {
-    "󰂎", "󰁺", "󰁻", "󰁼", "󰁽", "󰁾", "󰁿", "󰂀", "󰂁", "󰂂", "󰁹"
-};
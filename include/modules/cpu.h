@@ -1,12 +1,25 @@
 #pragma once
 #include "module.h"
+#include "format.h"
+#include "sample_source.h"
+#include <chrono>
 #include <cstdint>
+#include <string>
 
 // CPU模块 - 显示CPU使用率和功率消耗
 class CpuModule : public Module {
   public:
-    CpuModule();
-    ~CpuModule();
+    // 功率数据的来源
+    enum class PowerInterface {
+        NONE, // 没有功率数据，只显示使用率
+        RAPL, // powercap的RAPL封装域，power_dir为intel-rapl:N目录
+        SVI2, // zenpower驱动的SVI2遥测，power_dir为hwmon目录
+    };
+
+    // 功率接口由启动时的硬件探测决定
+    explicit CpuModule(PowerInterface power = PowerInterface::NONE,
+                       const std::string &power_dir = {});
+    ~CpuModule() override;
 
     // 更新模块状态
     virtual void update() override;
@@ -14,28 +27,41 @@ class CpuModule : public Module {
     // 处理点击事件
     virtual void handleClick(uint64_t button) override;
 
+    // 保存和恢复/proc/stat与能量计数器的基准
+    virtual void saveCounters(std::vector<uint64_t> &counters) const override;
+    virtual void restoreCounters(std::span<const uint64_t> counters) override;
+
   private:
     // 获取CPU使用率
-    double getUsage();
+    Result<double> getUsage();
 
     // 获取CPU功率消耗
-    double getPower();
+    Result<double> getPower();
+
+    // 输出模板
+    FormatTemplate usage_format_{"{icon}\u2004{usage:4.2a}%", {"icon", "usage"}};
+    FormatTemplate power_format_{"{icon}\u2004{power:4.2a}W", {"icon", "power"}};
 
     // 私有数据
     uint64_t prev_idle_ = 0;             // 上一次的空闲时间
     uint64_t prev_total_ = 0;            // 上一次的总时间
     uint64_t prev_energy_ = 0;           // 上一次的能量消耗
+    std::chrono::steady_clock::time_point prev_energy_time_; // 上一次读取能量的时间
     uint64_t rapl_max_energy_range_ = 0; // RAPL 最大能量数值，超过就溢出了
 
     // 定义文件路径常量
-    static constexpr const char *PACKAGE = "/sys/class/powercap/intel-rapl:0/energy_uj";
-    static constexpr const char *CORE = "/sys/class/powercap/intel-rapl:0:0/energy_uj";
-    static constexpr const char *RAPL_MAX_ENERGY_RANGE =
-        "/sys/class/powercap/intel-rapl:0:0/max_energy_range_uj";
-    static constexpr const char *SVI2_P_Core = "/sys/class/hwmon/hwmon3/power1_input";
-    static constexpr const char *SVI2_P_SoC = "/sys/class/hwmon/hwmon3/power2_input";
     static constexpr const char *PROC_STAT = "/proc/stat";
 
-    // 是否使用RAPL接口获取功率
-    static constexpr bool USE_RAPL = true;
+    // 功率数据的来源
+    PowerInterface power_ = PowerInterface::NONE;
+
+    // 数据源不可用时的占位内容
+    static constexpr std::string_view UNAVAILABLE_TEXT = "󰓅\u2004--.-";
+
+    // 数据源
+    SampleSource proc_stat_{PROC_STAT, 256};
+    SampleSource package_;
+    SampleSource rapl_max_energy_range_source_;
+    SampleSource svi2_core_;
+    SampleSource svi2_soc_;
 };
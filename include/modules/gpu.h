@@ -1,33 +1,59 @@
 #pragma once
 #include "module.h"
+#include "format.h"
+#include "sample_source.h"
+#include <chrono>
 #include <cstdint>
+#include <string>
 
 // GPU模块 - 显示显卡使用率和显存占用
+// 读取gpu_busy_percent会唤醒休眠的独立显卡，可能阻塞100毫秒以上，采样在工作线程中进行
 class GpuModule : public Module {
   public:
-    GpuModule();
-    ~GpuModule();
+    // 默认的DRM设备目录
+    static constexpr const char *DEFAULT_DEVICE = "/sys/class/drm/card1/device";
 
-    // 更新模块状态
+    // 采样超时，超过后显示过时标记
+    static constexpr std::chrono::milliseconds SAMPLE_TIMEOUT{500};
+
+    // device为DRM设备目录，由启动时的硬件探测决定
+    explicit GpuModule(const std::string &device = DEFAULT_DEVICE);
+    ~GpuModule() override;
+
+    // 在工作线程中读取数据源
+    virtual void sample() override;
+
+    // 采样完成后渲染（事件循环线程）
     virtual void update() override;
 
     // 处理点击事件
     virtual void handleClick(uint64_t button) override;
 
   private:
-    // 获取GPU使用率
-    uint64_t getGpuUsage();
+    // 一次采样的结果
+    struct Sample {
+        Result<uint64_t> usage{Error{Errc::UNAVAILABLE}};
+        Result<uint64_t> vram{Error{Errc::UNAVAILABLE}};
+    };
 
-    // 获取显存使用量
-    uint64_t getVramUsed();
+    // 按当前显示模式渲染current_
+    void render();
 
-    // 格式化存储单位
-    void formatStorageUnits(char *buffer, uint64_t bytes);
+    // 输出模板
+    FormatTemplate usage_format_{"󰍹\u2004{usage:2d}%", {"usage"}};
+    FormatTemplate vram_format_{"󰍹\u2004{vram:bytes}", {"vram"}};
 
     // 私有数据
     bool show_vram_ = false; // 是否显示显存占用
 
-    // 定义文件路径常量
-    static constexpr const char *GPU_USAGE = "/sys/class/drm/card1/device/gpu_busy_percent";
-    static constexpr const char *VRAM_USED = "/sys/class/drm/card1/device/mem_info_vram_used";
+    // 数据源不可用时的占位内容
+    static constexpr std::string_view UNAVAILABLE_TEXT = "󰍹\u2004--.-";
+
+    // 数据源（只在sample()中访问）
+    SampleSource gpu_usage_;
+    SampleSource vram_used_;
+
+    // sample()写入的暂存区，update()复制到current_后才用于渲染
+    Sample sampled_;
+    Sample current_;
 };
\ No newline at end of file
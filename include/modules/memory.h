@@ -1,12 +1,14 @@
 #pragma once
 #include "module.h"
+#include "format.h"
+#include "sample_source.h"
 #include <cstdint>
 
 // Memory模块 - 显示内存使用情况
 class MemoryModule : public Module {
   public:
     MemoryModule();
-    ~MemoryModule();
+    ~MemoryModule() override;
 
     // 更新模块状态
     virtual void update() override;
@@ -15,11 +17,17 @@ class MemoryModule : public Module {
     virtual void handleClick(uint64_t button) override;
 
   private:
+    // 内存使用情况
+    struct Usage {
+        uint64_t used; // 已用内存（字节）
+        double ratio;  // 使用比例（0～1）
+    };
+
     // 获取内存使用情况
-    void getUsage(uint64_t &used, double &percent);
+    Result<Usage> getUsage();
 
-    // 格式化存储单位
-    std::string formatStorageUnits(double bytes);
+    // 输出模板
+    FormatTemplate format_{"󰍛\u2004{used:bytes}", {"used"}};
 
     // 私有数据
     uint64_t prev_used_ = 0;    // 上一次的已用内存
@@ -27,4 +35,7 @@ class MemoryModule : public Module {
 
     // 定义文件路径常量
     static constexpr const char *MEMINFO = "/proc/meminfo";
+
+    // 数据源
+    SampleSource meminfo_{MEMINFO, 4096};
 };
\ No newline at end of file
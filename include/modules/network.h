@@ -1,13 +1,17 @@
 #pragma once
 #include "module.h"
+#include "format.h"
+#include "sample_source.h"
+#include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
 
 // 网络模块 - 显示网络状态和流量
 class NetworkModule : public Module {
   public:
     NetworkModule();
-    ~NetworkModule();
+    ~NetworkModule() override;
 
     // 更新模块状态
     virtual void update() override;
@@ -15,34 +19,55 @@ class NetworkModule : public Module {
     // 处理点击事件
     virtual void handleClick(uint64_t button) override;
 
+    // 保存和恢复流量计数器的基准
+    virtual void saveCounters(std::vector<uint64_t> &counters) const override;
+    virtual void restoreCounters(std::span<const uint64_t> counters) override;
+
   private:
-    // 获取无线网络状态
-    void getWirelessStatus(const std::string &ifname, int64_t &link, int64_t &level);
+    // 无线网络状态
+    struct Signal {
+        int64_t link;  // 链路质量（%）
+        int64_t level; // 信号级别（dB）
+    };
+
+    // 流量和主设备
+    struct Traffic {
+        uint64_t rx = 0;    // 每秒接收字节数
+        uint64_t tx = 0;    // 每秒发送字节数
+        std::string master; // 主设备名称，没有可用接口时为空
+    };
+
+    // 获取无线网络状态，接口不在列表中时为0
+    Result<Signal> getWirelessStatus(const std::string &ifname);
 
     // 获取网络速度和主设备
-    void getNetworkSpeedAndMasterDev(uint64_t &rx, uint64_t &tx, std::string &master);
+    Result<Traffic> getNetworkSpeedAndMasterDev();
 
-    // 格式化以太网输出
-    void formatEtherOutput(
-        std::ostringstream &output, const std::string &ifname, uint64_t rx, uint64_t tx
-    );
+    // 更新以太网输出
+    void updateEtherOutput(const std::string &ifname, uint64_t rx, uint64_t tx);
 
-    // 格式化无线网络输出
-    void formatWirelessOutput(
-        std::ostringstream &output, const std::string &ifname, uint64_t rx, uint64_t tx
-    );
+    // 更新无线网络输出
+    void updateWirelessOutput(const std::string &ifname, uint64_t rx, uint64_t tx);
 
-    // 格式化存储单位
-    void formatStorageUnits(std::ostringstream &output, uint64_t bytes);
+    // 输出模板
+    FormatTemplate traffic_format_{"{icon}\u2004{rx:bytes}\u2004{tx:bytes}", {"icon", "rx", "tx"}};
+    FormatTemplate speed_format_{"{icon}\u2004{speed}M", {"icon", "speed"}};
+    FormatTemplate signal_format_{"{icon}\u2004{link}%\u2004{level}dB", {"icon", "link", "level"}};
 
     // 私有数据
     bool show_details_ = false; // 是否显示详细信息
     uint64_t prev_rx_ = 0;      // 上一次接收字节数
     uint64_t prev_tx_ = 0;      // 上一次发送字节数
+    std::chrono::steady_clock::time_point prev_time_; // 上一次读取流量的时间
 
     // 定义文件路径常量
     static constexpr const char *WIRELESS_STATUS = "/proc/net/wireless";
     static constexpr const char *NET_DEV = "/proc/net/dev";
-    static constexpr const char *CARRIER_PATH_TEMPLATE = "/sys/class/net/%s/carrier";
-    static constexpr const char *SPEED_PATH_TEMPLATE = "/sys/class/net/%s/speed";
+    static constexpr const char *CARRIER_PATH_TEMPLATE = "/sys/class/net/%.*s/carrier";
+    static constexpr const char *SPEED_PATH_TEMPLATE = "/sys/class/net/%.*s/speed";
+
+    // 数据源
+    SampleSource net_dev_{NET_DEV, 16384};
+    SampleSource wireless_{WIRELESS_STATUS, 4096};
+    std::unique_ptr<SampleSource> speed_; // 当前以太网接口的speed，接口变化时重新创建
 };
\ No newline at end of file
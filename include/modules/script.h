@@ -0,0 +1,135 @@
+#pragma once
+#include "module.h"
+#include <sys/types.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 脚本模块 - 运行用户脚本并显示其输出（VPN、构建状态等自定义指示器）
+//
+// 两种运行方式：
+// - 常驻模式：启动一次子进程，从非阻塞管道逐行读取输出，每一行都是一次完整更新；
+//   点击事件以i3bar JSON（{"name":...,"button":N}）写入子进程的标准输入；
+//   子进程退出后按指数退避（1秒起，最长60秒）重新启动
+// - 定时模式：按间隔运行脚本（兼容i3blocks），输出第一行为文本、第三行为颜色；
+//   点击时通过BLOCK_BUTTON环境变量传递按钮并立即重新运行；
+//   超时先发送SIGTERM，1秒后仍未退出则发送SIGKILL，失败时保留上一次的输出
+//
+// 每一行可以是纯文本，也可以是i3bar的JSON块（使用full_text、color、urgent和markup字段）。
+class ScriptModule : public Module {
+  public:
+    // 运行方式
+    enum class Mode {
+        PERSIST, // 常驻子进程，流式读取输出
+        INTERVAL // 按间隔运行，每次运行一个新进程
+    };
+
+    // command按空白拆分为参数列表，不经过shell
+    ScriptModule(const std::string &name, const std::string &command, Mode mode,
+                 uint64_t interval = 0, uint64_t timeout = 0);
+    ~ScriptModule() override;
+
+    // 删除拷贝和移动操作，文件描述符监听回调保存了this指针
+    ScriptModule(const ScriptModule &) = delete;
+    ScriptModule &operator=(const ScriptModule &) = delete;
+    ScriptModule(ScriptModule &&) = delete;
+    ScriptModule &operator=(ScriptModule &&) = delete;
+
+    // 更新模块状态（常驻模式下负责重启，定时模式下启动一次运行）
+    virtual void update() override;
+
+    // 处理点击事件
+    virtual void handleClick(uint64_t button) override;
+
+    // 初始化模块
+    virtual void init() override;
+
+    // 默认配置文件路径：$XDG_CONFIG_HOME/seedstatus/scripts.conf
+    static std::string defaultConfigPath();
+
+    // 从配置文件加载脚本模块，文件不存在时返回空列表
+    //
+    // 每行格式为"名称 方式 [signal=N] 命令..."，方式为persist或"间隔[:超时]"（秒），
+    // 间隔为0时只在启动、点击、SIGRTMIN+N和控制套接字的refresh命令时运行，
+    // 空行和以#开头的行被忽略，例如：
+    //   vpn persist ~/.bin/status/vpn --follow
+    //   build 30:10 ~/.bin/status/ci-status
+    //   mail 0 signal=4 ~/.bin/status/unread
+    static std::vector<std::shared_ptr<ScriptModule>> loadConfig(const std::string &path);
+
+  private:
+    // 启动子进程
+    void spawnChild();
+
+    // 读取子进程的标准输出，读到EAGAIN或EOF为止
+    void readOutput();
+
+    // 处理子进程退出
+    void onChildExit(int status);
+
+    // 处理定时模式的超时
+    void onTimeout();
+
+    // 关闭与子进程通信的管道
+    void closePipes();
+
+    // 应用一行常驻模式的输出
+    void applyLine(const std::string &line);
+
+    // 应用一次定时模式运行的完整输出
+    void applyRunOutput();
+
+    // 设置输出（与缓存相同时不标记为脏）
+    void setCachedOutput(const std::string &text, Color color);
+
+    // 设置超时定时器，seconds为0时解除
+    void armTimeout(uint64_t seconds);
+
+    // 启动参数
+    std::vector<std::string> argv_;
+
+    // 运行方式
+    Mode mode_;
+
+    // 定时模式的运行间隔（秒）
+    uint64_t run_interval_;
+
+    // 定时模式的超时（秒）
+    uint64_t timeout_;
+
+    // 子进程ID，未运行时为-1
+    pid_t pid_ = -1;
+
+    // 子进程标准输出的读端
+    int stdout_fd_ = -1;
+
+    // 子进程标准输入的写端（仅常驻模式）
+    int stdin_fd_ = -1;
+
+    // 定时模式的超时定时器
+    int timeout_fd_ = -1;
+
+    // 是否已经发送过SIGTERM
+    bool term_sent_ = false;
+
+    // 尚未组成完整行的输出
+    std::string line_buffer_;
+
+    // 定时模式一次运行的全部输出
+    std::string run_output_;
+
+    // 等待传给下一次运行的点击按钮（定时模式）
+    uint64_t pending_button_ = 0;
+
+    // 下一次重启的等待时间（秒）
+    uint64_t restart_delay_ = 1;
+
+    // 子进程启动时间，用于判断是否重置退避
+    std::chrono::steady_clock::time_point started_at_;
+
+    // 上一次显示的文本和颜色
+    std::string cached_text_;
+    Color cached_color_ = Color::DEACTIVE;
+    bool has_output_ = false;
+};
@@ -2,12 +2,13 @@
 #include "module.h"
 #include <unistd.h>
 #include <system.h>
+#include <click_parser.h>
 
 // Stdin模块 - 处理来自标准输入的事件（如点击事件）
 class StdinModule : public Module {
   public:
-    StdinModule(System *system = nullptr);
-    ~StdinModule();
+    StdinModule();
+    ~StdinModule() override;
 
     // 更新模块状态
     virtual void update() override;
@@ -22,9 +23,12 @@ class StdinModule : public Module {
     // 设置文件描述符为非阻塞模式
     void setNonBlocking(int fd);
 
-    // 读取并解析输入
+    // 读取并解析输入，读到EAGAIN为止
     void parseInput();
 
-    // System实例指针
-    System *system_;
+    // 将一个点击事件分发给目标模块
+    void dispatchClick(const ClickEvent &event);
+
+    // 流式点击事件解析器，保存跨读取的残留数据
+    ClickEventParser parser_;
 };
\ No newline at end of file
@@ -1,10 +1,17 @@
 #pragma once
 #include "module.h"
+#include "format.h"
+#include "sample_source.h"
+#include <string>
 
 // Temp模块显示系统温度
 class TempModule : public Module {
   public:
-    TempModule();
+    // 默认的温度输入文件
+    static constexpr const char *DEFAULT_INPUT = "/sys/class/hwmon/hwmon5/temp1_input";
+
+    // input为hwmon的temp*_input文件，由启动时的硬件探测决定
+    explicit TempModule(const std::string &input = DEFAULT_INPUT);
     ~TempModule() override;
 
     // 更新模块信息
@@ -15,11 +22,17 @@ class TempModule : public Module {
 
   private:
     // 获取系统温度
-    double getTemperature() const;
+    Result<double> getTemperature();
 
-    // 获取温度对应的图标
-    std::string getTemperatureIcon(double temp) const;
+    // 获取温度对应的图标在icons::TEMPERATURE中的索引
+    size_t getTemperatureIconIndex(double temp) const;
 
     // 获取温度对应的颜色
     Color getTemperatureColor(double temp) const;
+
+    // 输出模板
+    FormatTemplate format_{"{icon}\u2004{temp:4.2a}", {"icon", "temp"}};
+
+    // 数据源
+    SampleSource temp_input_;
 };
\ No newline at end of file
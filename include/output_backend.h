@@ -0,0 +1,92 @@
+#pragma once
+#include "module.h"
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @file output_backend.h
+ * @brief 输出后端
+ *
+ * 同一套模块可以输出到不同的状态栏程序：
+ * - i3bar：i3bar/swaybar的JSON协议（默认），支持点击事件
+ * - plain：纯UTF-8文本，每帧一行，可以配合xsetroot用于dwm
+ * - lemonbar：lemonbar格式字符串，颜色使用%{F...}，点击动作输出"click <模块ID> <按钮>"，
+ *   可以直接转发给控制套接字
+ * - tmux：tmux状态栏格式（#[fg=...]），配合status-right的#()使用
+ *
+ * 模块注册时，后端为每个模块预编译一份模板：模块名称、ID以及每种颜色对应的
+ * 前缀和后缀都提前拼好，每帧只需转换模块文本并拷贝模板，切换后端不增加
+ * 每帧的格式化开销。
+ *
+ * 模块输出的文本都是Pango标记。i3bar原样输出；其它后端把
+ * <span color/foreground='...'>转换为各自的颜色语法（plain直接去掉），
+ * 其余标签被去掉，实体（&amp;等）被还原，再按后端的规则转义。
+ */
+
+/**
+ * @brief 预编译的模块模板
+ *
+ * 片段 = prefix[颜色] + 转换后的文本 + suffix，suffix以一个分隔字符结尾，
+ * 拼装帧时去掉最后一个片段的分隔字符。
+ */
+struct ModuleTemplate {
+    std::array<std::string, COLOR_COUNT> prefix; ///< 按颜色索引的前缀
+    std::string suffix;                          ///< 后缀（包括分隔字符）
+};
+
+/**
+ * @brief 输出后端接口
+ */
+class OutputBackend {
+  public:
+    virtual ~OutputBackend() = default;
+
+    /**
+     * @brief 后端名称（与--backend=的取值相同）
+     */
+    virtual std::string_view name() const = 0;
+
+    /**
+     * @brief 启动时输出一次的协议头，没有时为空
+     */
+    virtual std::string header() const = 0;
+
+    /**
+     * @brief 后端是否通过标准输入接收i3bar格式的点击事件
+     */
+    virtual bool acceptsClicks() const = 0;
+
+    /**
+     * @brief 为模块预编译模板
+     * @param module 模块（已注册，ID有效）
+     * @return 模块模板
+     */
+    virtual ModuleTemplate compile(const Module &module) const = 0;
+
+    /**
+     * @brief 把模块的Pango文本转换为后端格式并追加到缓冲区
+     * @param markup 模块输出的Pango文本
+     * @param color 模块颜色，</span>之后恢复为该颜色
+     * @param out 输出缓冲区
+     */
+    virtual void appendText(std::string_view markup, Color color, std::string &out) const = 0;
+
+    /**
+     * @brief 帧开头
+     */
+    virtual std::string_view frameBegin() const = 0;
+
+    /**
+     * @brief 帧结尾（包括换行符）
+     */
+    virtual std::string_view frameEnd() const = 0;
+};
+
+/**
+ * @brief 按名称创建输出后端
+ * @param name i3bar、plain、lemonbar或tmux
+ * @return 输出后端，名称无效时返回nullptr
+ */
+std::unique_ptr<OutputBackend> makeOutputBackend(std::string_view name);
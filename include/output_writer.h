@@ -0,0 +1,139 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+/**
+ * @file output_writer.h
+ * @brief 不阻塞事件循环的标准输出写入器
+ *
+ * 原先每一帧都用std::cout同步写出。i3bar停止读取时（进程被暂停、挂了调试器、
+ * 合成器卡顿），管道写满后事件循环会阻塞在write()中，点击、D-Bus消息和定时器
+ * 全部停滞，D-Bus连接甚至可能因此被断开。
+ *
+ * 标准输出的打开文件描述与i3bar以及通常与stderr共享，设置O_NONBLOCK会让
+ * 其它写入者也收到EAGAIN，因此描述符保持阻塞：每次写出前用poll()确认可写，
+ * 每次最多写出PIPE_BUF字节，管道有空闲缓冲区时这样的写出不会阻塞。
+ * OutputWriter只保留两份数据：
+ * - 正在写出的帧（已经写出一部分，必须写完，否则i3bar会读到半个JSON）
+ * - 最新的一帧完整帧（等待前一帧写完后再写出）
+ *
+ * 写出过程中又提交新帧时，尚未开始写出的旧帧直接被替换并计入丢帧数，
+ * i3bar恢复读取后只会看到最新状态。只有存在未写完的数据时才注册EPOLLOUT，
+ * 管道畅通时不会产生额外的唤醒。
+ *
+ * 只有管道（i3bar、swaybar等状态栏的标准用法）和套接字才有这样的保证。标准输出
+ * 是终端或普通文件时，poll()报告可写并不保证能写下PIPE_BUF字节，单次写出仍可能
+ * 阻塞（终端被Ctrl-S暂停、磁盘I/O缓慢）；这两种情况只用于手动调试和记录输出，
+ * 不做额外处理。
+ */
+
+class System;
+
+/**
+ * @brief 不阻塞事件循环的标准输出写入器
+ */
+class OutputWriter {
+  public:
+    /**
+     * @brief 输出统计
+     */
+    struct Stats {
+        uint64_t frames_submitted = 0; ///< 提交的帧数
+        uint64_t frames_written = 0;   ///< 完整写出的帧数
+        uint64_t frames_dropped = 0;   ///< 被更新的帧替换而未写出的帧数
+        uint64_t bytes_written = 0;    ///< 写出的字节数
+        uint64_t stalls = 0;           ///< 写出时管道已满的次数
+        size_t pending_bytes = 0;      ///< 尚未写出的字节数
+    };
+
+    /**
+     * @brief 构造函数
+     * @param system 系统对象，用于注册EPOLLOUT监听
+     */
+    explicit OutputWriter(System &system);
+
+    // 删除拷贝和移动操作，监听回调保存了this指针
+    OutputWriter(const OutputWriter &) = delete;
+    OutputWriter &operator=(const OutputWriter &) = delete;
+    OutputWriter(OutputWriter &&) = delete;
+    OutputWriter &operator=(OutputWriter &&) = delete;
+
+    /**
+     * @brief 接管输出描述符
+     * @param fd 输出描述符，默认为标准输出
+     * @return true如果描述符有效，false如果失败
+     *
+     * 不修改描述符的文件状态标志。
+     */
+    bool initialize(int fd = STDOUT_FILENO);
+
+    /**
+     * @brief 写出必须完整送达的数据（如i3bar协议头）
+     * @param data 数据
+     *
+     * 数据追加到正在写出的缓冲区之后，永远不会被丢弃。
+     * 只应在提交第一帧之前调用。
+     */
+    void write(std::string_view data);
+
+    /**
+     * @brief 提交一帧
+     * @param frame 完整的一帧
+     *
+     * 输出通畅时立即写出；否则替换等待中的帧，等描述符可写后再写出。
+     */
+    void submitFrame(std::string_view frame);
+
+    /**
+     * @brief 是否还有尚未写出的数据
+     * @return true如果有数据等待写出
+     */
+    bool hasPending() const;
+
+    /**
+     * @brief 获取输出统计
+     * @return 统计信息
+     */
+    Stats getStats() const;
+
+  private:
+    /**
+     * @brief 尽可能多地写出缓冲区中的数据
+     *
+     * poll()报告不可写时注册EPOLLOUT，全部写完后注销。
+     */
+    void flush();
+
+    /**
+     * @brief 处理EPOLLOUT事件
+     * @param events epoll事件掩码
+     */
+    void onWritable(uint32_t events);
+
+    /**
+     * @brief 注册或注销EPOLLOUT监听
+     * @param enable true表示注册
+     * @return false如果描述符不支持epoll（此时退回阻塞写出）
+     */
+    bool setWatching(bool enable);
+
+    /**
+     * @brief 读取端已关闭或写出失败，丢弃所有数据并停止系统
+     * @param error errno
+     */
+    void fail(int error);
+
+    System &system_;                 ///< 系统对象
+    int fd_ = -1;                    ///< 输出描述符
+    bool watching_ = false;          ///< 是否已注册EPOLLOUT
+    bool failed_ = false;            ///< 输出是否已失败
+    std::string inflight_;           ///< 正在写出的数据
+    size_t inflight_offset_ = 0;     ///< inflight_中已写出的字节数
+    bool inflight_frame_ = false;    ///< inflight_中是否包含一帧
+    std::string pending_;            ///< 等待写出的最新一帧
+    bool has_pending_ = false;       ///< pending_是否有效
+    Stats stats_;                    ///< 输出统计
+};
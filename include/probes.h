@@ -0,0 +1,40 @@
+#pragma once
+
+/**
+ * @file probes.h
+ * @brief 热路径上的USDT静态探针
+ *
+ * 生产环境中的桌面不方便带着调试参数重启状态栏。用-DSEEDSTATUS_ENABLE_USDT=ON构建时，
+ * 事件循环的关键位置编译进systemtap风格的静态探针（sys/sdt.h），bpftrace、perf和
+ * bcc可以随时附加到正在运行的进程上：
+ *
+ * @code
+ * bpftrace -e 'usdt:/usr/bin/seedstatus:seedstatus:frame_emit { @bytes = hist(arg0); }'
+ * @endcode
+ *
+ * 探针只是一条nop指令和ELF注记，没有附加时不改变执行路径；参数都是已经计算好的整数或
+ * 字符串指针，不为探针额外求值。未启用该选项时探针宏展开为空。
+ * tools/bpftrace/下的脚本给出各模块update()的延迟分布和唤醒来源统计。
+ *
+ * 探针（提供者为seedstatus）：
+ * - loop_wakeup(nfds)                         epoll_wait返回，nfds为就绪的事件数
+ * - event_dispatch(source, index)             分发一个epoll事件，source为0模块、1定时器、2监听，
+ *                                             index为模块ID或监听槽位
+ * - update_begin(id, name)                    模块update()开始，name为模块名称（C字符串）
+ * - update_end(id, name, ns)                  模块update()结束，ns为耗时（纳秒）
+ * - timer_tick(expirations, counter)          秒级定时器到期，expirations为本次到期的次数
+ * - frame_emit(bytes)                         提交一帧，bytes为帧大小
+ * - click(id, button)                         模块收到点击
+ */
+
+#ifdef SEEDSTATUS_ENABLE_USDT
+#include <sys/sdt.h>
+
+#define SEEDSTATUS_PROBE1(name, a1) STAP_PROBE1(seedstatus, name, a1)
+#define SEEDSTATUS_PROBE2(name, a1, a2) STAP_PROBE2(seedstatus, name, a1, a2)
+#define SEEDSTATUS_PROBE3(name, a1, a2, a3) STAP_PROBE3(seedstatus, name, a1, a2, a3)
+#else
+#define SEEDSTATUS_PROBE1(name, a1) ((void)0)
+#define SEEDSTATUS_PROBE2(name, a1, a2) ((void)0)
+#define SEEDSTATUS_PROBE3(name, a1, a2, a3) ((void)0)
+#endif
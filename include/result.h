@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+
+/**
+ * @file result.h
+ * @brief 不抛异常的采样结果
+ *
+ * 采样路径（读取sysfs/procfs）原先用异常表示失败：设备不存在时每次更新都要
+ * 抛出std::runtime_error、拼接错误信息并展开栈。Result<T>按std::expected的接口
+ * 保存一个值或一个错误码（C++20中还没有std::expected），失败是普通的返回值：
+ *
+ * @code
+ * Result<uint64_t> usage = source.readUint64();
+ * if (!usage) {
+ *     setUnavailable("󰍹 --");
+ *     return;
+ * }
+ * render(*usage);
+ * @endcode
+ */
+
+/**
+ * @brief 错误类别
+ */
+enum class Errc : uint8_t {
+    NOT_FOUND,   ///< 数据源不存在（ENOENT、ENODEV等）
+    IO,          ///< 打开或读取失败
+    PARSE,       ///< 内容无法解析
+    UNAVAILABLE  ///< 之前失败过，尚未到重新探测的时间，本次没有访问数据源
+};
+
+/**
+ * @brief 错误
+ */
+struct Error {
+    Errc code;         ///< 错误类别
+    int sys_errno = 0; ///< 系统调用的errno，不是系统调用失败时为0
+};
+
+/**
+ * @brief 获取错误类别的名称
+ * @param code 错误类别
+ * @return "not found"、"io"、"parse"或"unavailable"
+ */
+constexpr const char *errcName(Errc code) {
+    switch (code) {
+    case Errc::NOT_FOUND:
+        return "not found";
+    case Errc::IO:
+        return "io";
+    case Errc::PARSE:
+        return "parse";
+    case Errc::UNAVAILABLE:
+        return "unavailable";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * @brief 值或错误
+ * @tparam T 值的类型，必须可以默认构造
+ */
+template <typename T> class Result {
+  public:
+    Result(const T &value) : value_(value), has_value_(true) {}
+    Result(T &&value) : value_(std::move(value)), has_value_(true) {}
+    Result(Error error) : error_(error) {}
+
+    /**
+     * @brief 是否包含值
+     */
+    bool hasValue() const {
+        return has_value_;
+    }
+
+    explicit operator bool() const {
+        return hasValue();
+    }
+
+    /**
+     * @brief 获取值，调用前必须确认hasValue()
+     */
+    const T &value() const {
+        return value_;
+    }
+
+    const T &operator*() const {
+        return value();
+    }
+
+    const T *operator->() const {
+        return &value();
+    }
+
+    /**
+     * @brief 获取值，失败时返回默认值
+     * @param fallback 默认值
+     */
+    T valueOr(T fallback) const {
+        return hasValue() ? value() : std::move(fallback);
+    }
+
+    /**
+     * @brief 获取错误，调用前必须确认!hasValue()
+     */
+    Error error() const {
+        return error_;
+    }
+
+  private:
+    // 采样值都是数值或视图，直接并列存放，不使用std::variant
+    T value_{};              ///< 值
+    Error error_{Errc::IO};  ///< 错误
+    bool has_value_ = false; ///< 是否包含值
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include "result.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file sample_source.h
+ * @brief 带负缓存的采样数据源
+ *
+ * 模块每秒读取sysfs/procfs文件。原先每次都用std::ifstream重新打开文件，
+ * 文件不存在（没有RAPL的台式机、hwmon编号不同）时抛出异常，模块在update()中
+ * 捕获后重建占位字符串，每个模块每秒都要付出一次栈展开和若干次分配。
+ *
+ * SampleSource只打开一次文件，之后每次用pread()从偏移0重新读取，
+ * sysfs和procfs在每次从头读取时都会生成最新的内容。失败时关闭文件并按
+ * 1秒、2秒、4秒……直至5分钟的间隔安排重新探测，在此之前的读取直接返回
+ * Errc::UNAVAILABLE，不进行任何系统调用。数据源在失败和恢复时各记录一次日志，
+ * 永久不存在的设备在首次探测之后几乎没有开销。
+ */
+
+/**
+ * @brief 采样数据源
+ */
+class SampleSource {
+  public:
+    /**
+     * @brief 首次失败后的重新探测间隔
+     */
+    static constexpr std::chrono::seconds MIN_BACKOFF{1};
+
+    /**
+     * @brief 重新探测间隔的上限
+     */
+    static constexpr std::chrono::seconds MAX_BACKOFF{300};
+
+    /**
+     * @brief 构造函数，不访问文件，首次read()时才打开
+     * @param path 文件路径
+     * @param capacity 读取缓冲区大小，内容超出时被截断
+     */
+    explicit SampleSource(std::string path, size_t capacity = 64);
+
+    /**
+     * @brief 析构函数，关闭文件
+     */
+    ~SampleSource();
+
+    // 删除拷贝构造和赋值操作
+    SampleSource(const SampleSource &) = delete;
+    SampleSource &operator=(const SampleSource &) = delete;
+
+    /**
+     * @brief 读取文件的全部内容
+     * @return 指向内部缓冲区的内容，下一次读取前有效，末尾总有一个'\0'
+     */
+    Result<std::string_view> read();
+
+    /**
+     * @brief 读取文件中的第一个无符号整数
+     * @return 整数值
+     */
+    Result<uint64_t> readUint64();
+
+    /**
+     * @brief 获取文件路径
+     */
+    const std::string &getPath() const;
+
+  private:
+    /**
+     * @brief 记录失败，关闭文件并安排下一次探测
+     * @param error 错误
+     * @return error
+     */
+    Error fail(Error error);
+
+    std::string path_;                                   ///< 文件路径
+    std::vector<char> buffer_;                           ///< 读取缓冲区（多一个字节存放'\0'）
+    int fd_ = -1;                                        ///< 文件描述符
+    std::chrono::seconds backoff_{0};                    ///< 当前重新探测间隔，0表示未失败
+    std::chrono::steady_clock::time_point retry_at_;     ///< 下一次允许探测的时间
+};
+
+/**
+ * @brief 解析文本开头的无符号整数（跳过前导空白）
+ * @param text 文本
+ * @return 整数值，没有数字时为Errc::PARSE
+ */
+Result<uint64_t> parseUint64(std::string_view text);
@@ -0,0 +1,94 @@
+#pragma once
+#include "module.h"
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file snapshot.h
+ * @brief 最近一帧的持久化快照
+ *
+ * i3/sway重新加载配置时会重启状态栏命令，新进程在第一秒内只能显示占位内容，
+ * 速率类模块（CPU使用率、网络流量、功率）也需要两次采样才有数值。
+ *
+ * System定期（以及退出时）把每个模块的输出、颜色和计算速率所需的计数器写入
+ * $XDG_RUNTIME_DIR/seedstatus.snapshot（先写临时文件再rename）。启动时如果快照
+ * 来自同一次开机且足够新，模块在首次更新之前先显示快照中的内容，计数器作为
+ * 差值的基准，第一帧就是上一帧的内容加上新的采样，重启几乎没有可见的间隙。
+ *
+ * 时间戳使用steady_clock（CLOCK_MONOTONIC），同一次开机内的不同进程之间可以直接比较，
+ * 因此快照同时记录boot_id。
+ */
+class Snapshot {
+  public:
+    /**
+     * @brief 一个模块的快照
+     */
+    struct Entry {
+        std::string name;               ///< 模块名称
+        std::string output;             ///< 输出内容
+        Color color = Color::IDLE;      ///< 输出颜色
+        std::vector<uint64_t> counters; ///< Module::saveCounters()保存的计数器
+    };
+
+    /**
+     * @brief 快照的有效期，超过后不再使用
+     */
+    static constexpr std::chrono::seconds MAX_AGE{30};
+
+    /**
+     * @brief 定期保存的间隔（秒）
+     */
+    static constexpr uint64_t SAVE_INTERVAL = 5;
+
+    /**
+     * @brief 获取默认快照路径
+     * @return $XDG_RUNTIME_DIR/seedstatus.snapshot，环境变量未设置时为空
+     */
+    static std::string defaultPath();
+
+    /**
+     * @brief 保存所有模块的快照
+     * @param path 快照路径
+     * @param boot_id 当前的boot_id
+     * @param manager 模块管理器
+     * @return true如果写入成功
+     *
+     * 尚未就绪或采样正在工作线程中进行的模块只保存输出，不调用saveCounters()。
+     */
+    static bool save(const std::string &path, const std::string &boot_id,
+                     const ModuleManager &manager);
+
+    /**
+     * @brief 读取快照
+     * @param path 快照路径
+     * @param boot_id 当前的boot_id
+     * @return 快照，文件不存在、格式错误、来自另一次开机或超过MAX_AGE时为空
+     */
+    static std::optional<Snapshot> load(const std::string &path, const std::string &boot_id);
+
+    /**
+     * @brief 查找模块的快照
+     * @param name 模块名称
+     * @param occurrence 同名模块中的序号（从0开始，按注册顺序）
+     * @return 快照条目，没有时为nullptr
+     */
+    const Entry *find(std::string_view name, size_t occurrence) const;
+
+    /**
+     * @brief 获取快照的年龄
+     */
+    std::chrono::steady_clock::duration getAge() const;
+
+    /**
+     * @brief 获取条目数量
+     */
+    size_t size() const;
+
+  private:
+    std::chrono::steady_clock::time_point saved_at_; ///< 保存时间
+    std::vector<Entry> entries_;                     ///< 按模块ID顺序排列的条目
+};
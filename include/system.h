@@ -1,10 +1,25 @@
 #pragma once
 #include "module.h"
 #include "timer.h"
+#include "launcher.h"
+#include "control.h"
+#include "output_writer.h"
+#include "output_backend.h"
+#include "hardware.h"
+#include "snapshot.h"
+#include "worker_pool.h"
+#include "task.h"
+#include "telemetry.h"
+#include "trace.h"
 #include <sys/epoll.h>
+#include <chrono>
 #include <vector>
 #include <memory>
+#include <string>
+#include <functional>
+#include <unordered_map>
 #include <unistd.h>
+#include <csignal>
 
 /**
  * @file system.h
@@ -17,8 +32,15 @@
  * - epoll事件循环管理
  * - 模块的初始化、更新和销毁
  * - 定时器管理
- * - 信号处理集成
- * - i3bar协议输出
+ * - 信号处理集成（signalfd）
+ * - 状态栏输出（i3bar、纯文本、lemonbar、tmux；写出前确认管道可写，读取端停止读取时只保留最新一帧）
+ * - 并行启动：协议头和占位帧立即输出，耗时的模块准备在工作线程中进行
+ * - 阻塞采样：可能阻塞的模块采样在工作线程池中进行，超时显示过时标记
+ * - 协程任务：模块用Task等待D-Bus回复、定时器和fd，不阻塞事件循环
+ * - 时间预算：反复超出预算的模块被自动降级或隔离，看门狗记录拖慢帧的模块
+ * - 运行统计：事件循环和模块的延迟分布与开销计数，收到SIGUSR1时输出到stderr
+ * - 时间线追踪：可选记录事件循环活动，导出为Chrome trace event格式（--trace）
+ * - 快照：定期保存最近一帧和速率计数器，重启后立即恢复
  *
  * 设计特点：
  * - 基于事件驱动的架构
@@ -55,6 +77,28 @@
  */
 class System {
   public:
+    /**
+     * @brief i3bar隐藏状态栏时发送的信号（协议头中的stop_signal）
+     *
+     * 不使用默认的SIGSTOP，以便进程自己暂停定时器而不是被内核冻结。
+     */
+    static constexpr int STOP_SIGNAL = SIGUSR2;
+
+    /**
+     * @brief i3bar重新显示状态栏时发送的信号（协议头中的cont_signal）
+     */
+    static constexpr int CONT_SIGNAL = SIGCONT;
+
+    /**
+     * @brief 输出运行统计报告的信号
+     */
+    static constexpr int TELEMETRY_SIGNAL = SIGUSR1;
+
+    /**
+     * @brief 一轮事件处理超过该时长时，看门狗记录拖慢这一帧的模块
+     */
+    static constexpr std::chrono::milliseconds FRAME_WATCHDOG{50};
+
     /**
      * @brief 构造函数
      *
@@ -79,12 +123,52 @@ class System {
      *
      * 执行系统初始化操作，包括：
      * - 创建epoll实例
-     * - 初始化所有模块
      * - 输出i3bar协议头
-     * 必须在调用run()之前调用此方法。
+     * - 初始化所有模块（异步启动的模块只启动工作线程，先显示占位内容）
+     * - 输出第一帧
+     * 必须在调用run()之前调用此方法。启动各阶段的耗时输出到标准错误。
      */
     bool initialize();
 
+    /**
+     * @brief 设置输出后端
+     * @param backend 输出后端，不能为空
+     *
+     * 必须在initialize()之前调用，默认为i3bar。不接收i3bar点击事件的后端
+     * 不会创建Stdin模块。
+     */
+    void setOutputBackend(std::unique_ptr<OutputBackend> backend);
+
+    /**
+     * @brief 忽略硬件探测缓存
+     * @param reprobe 为true时启动时重新探测硬件并更新缓存
+     *
+     * 必须在initialize()之前调用。同一次开机内更换了硬件（如插入USB声卡）时使用。
+     */
+    void setReprobeHardware(bool reprobe);
+
+    /**
+     * @brief 设置音量和麦克风模块滚轮每一格调整的音量百分比
+     * @param step 百分比（1～100）
+     *
+     * 必须在initialize()之前调用，默认为AudioModule::DEFAULT_VOLUME_STEP。
+     */
+    void setVolumeStep(uint64_t step);
+
+    /**
+     * @brief 设置外部音量脚本
+     * @param command 脚本命令，非空时滚轮和右键改为调用"<脚本> i|d|t"，不直接修改混音器
+     *
+     * 必须在initialize()之前调用，默认为空。
+     */
+    void setVolumeCommand(std::string command);
+
+    /**
+     * @brief 获取启动时探测到的硬件
+     * @return 硬件信息的引用，initialize()之前为空
+     */
+    const HardwareProfile &getHardware() const;
+
     /**
      * @brief 运行主事件循环
      *
@@ -92,6 +176,9 @@ class System {
      * - 模块文件描述符的I/O事件
      * - 定时器事件
      * - 信号事件
+     * - 工作线程池的完成通知
+     *
+     * 有采样在工作线程中进行时，epoll_wait的超时设为最近的采样超时时刻。
      *
      * 此方法会阻塞，直到调用stop()方法或收到终止信号。
      */
@@ -101,8 +188,10 @@ class System {
      * @brief 添加模块到系统
      * @param module 要添加的模块共享指针
      *
-     * 将模块添加到系统中，并自动调用其init()方法。
+     * 将模块添加到系统中，并自动调用其start()和init()方法。
      * 模块会被注册到模块管理器中，并可以参与事件循环。
+     * 异步启动的模块（Module::isAsyncStart()）在工作线程中执行start()，
+     * 完成后由事件循环调用init()，此前模块只显示占位内容。
      */
     void addModule(std::shared_ptr<Module> module);
 
@@ -113,7 +202,8 @@ class System {
      * @return true如果添加成功，false如果失败
      *
      * 将文件描述符添加到epoll实例中进行监控。
-     * 当fd有可读事件时，会自动调用关联模块的update()方法。
+     * epoll事件数据中保存模块ID（module为nullptr时表示定时器），
+     * 当fd有可读事件时，会通过ModuleManager调用关联模块的update()方法。
      */
     bool addToEpoll(int fd, std::shared_ptr<Module> module);
 
@@ -127,6 +217,43 @@ class System {
      */
     bool removeFromEpoll(int fd);
 
+    /**
+     * @brief 文件描述符事件处理函数
+     *
+     * 参数为epoll返回的事件掩码（EPOLLIN、EPOLLERR等）。
+     */
+    using FdHandler = std::function<void(uint32_t events)>;
+
+    /**
+     * @brief 监听任意文件描述符
+     * @param fd 要监听的文件描述符
+     * @param events epoll事件掩码（如EPOLLIN，需要边沿触发时自行加上EPOLLET）
+     * @param handler 事件处理函数，在事件循环线程中调用
+     * @return true如果添加成功，false如果失败
+     *
+     * 用于不直接对应某个模块的事件源，例如多个模块共享的ALSA混音器连接、
+     * 子进程的pidfd等。一个模块可以通过getSystem()注册任意多个监听。
+     */
+    bool watchFd(int fd, uint32_t events, FdHandler handler);
+
+    /**
+     * @brief 修改已监听文件描述符的事件掩码
+     * @param fd 文件描述符
+     * @param events 新的epoll事件掩码
+     * @return true如果修改成功，false如果失败
+     */
+    bool modifyWatch(int fd, uint32_t events);
+
+    /**
+     * @brief 停止监听文件描述符
+     * @param fd 文件描述符
+     * @return true如果该fd之前处于监听状态
+     *
+     * 可以在事件处理函数内部调用，本轮尚未处理的该fd事件会被忽略。
+     * 应在关闭fd之前调用。
+     */
+    bool unwatchFd(int fd);
+
     /**
      * @brief 获取模块管理器
      * @return 模块管理器的引用
@@ -135,6 +262,50 @@ class System {
      */
     ModuleManager &getModuleManager();
 
+    /**
+     * @brief 获取外部程序启动服务
+     * @return 启动服务的引用
+     *
+     * 模块启动外部程序时应使用此服务，而不是system()。
+     */
+    Launcher &getLauncher();
+
+    /**
+     * @brief 获取标准输出写入器
+     * @return 写入器的引用
+     *
+     * 用于查询丢帧等输出统计。
+     */
+    OutputWriter &getOutputWriter();
+
+    /**
+     * @brief 获取工作线程池
+     * @return 线程池的引用
+     *
+     * 模块可以提交自己的阻塞操作，完成回调在事件循环线程中执行。
+     */
+    WorkerPool &getWorkerPool();
+
+    /**
+     * @brief 获取协程任务调度器
+     * @return 调度器的引用
+     *
+     * 模块用spawn()启动Task，等待D-Bus回复、定时或fd可读时不阻塞事件循环。
+     */
+    TaskScheduler &getTaskScheduler();
+
+    /**
+     * @brief 获取运行统计
+     * @return 统计的引用
+     */
+    const Telemetry &getTelemetry() const;
+
+    /**
+     * @brief 把追踪缓冲区写入追踪文件
+     * @return true如果已启用追踪且写入成功
+     */
+    bool flushTrace() const;
+
     /**
      * @brief 获取定时器
      * @return 定时器的引用
@@ -152,10 +323,109 @@ class System {
     void stop();
 
   private:
+    /**
+     * @brief epoll事件来源
+     *
+     * 编码在epoll_event.data.u64的高32位，低32位为模块ID或监听槽位。
+     */
+    enum class EventSource : uint32_t {
+        MODULE = 0, ///< 模块文件描述符，低32位为模块ID
+        TIMER = 1,  ///< 秒级定时器
+        WATCH = 2,  ///< watchFd()注册的监听，低32位为槽位
+    };
+
+    /**
+     * @brief 编码epoll事件数据
+     */
+    static uint64_t makeEventData(EventSource source, uint32_t index);
+
+    /**
+     * @brief watchFd()注册的一个监听
+     */
+    struct FdWatch {
+        int fd = -1;       ///< 文件描述符，-1表示槽位空闲
+        FdHandler handler; ///< 事件处理函数
+    };
+
     int epoll_fd_ = -1;             ///< epoll文件描述符
+    std::vector<FdWatch> watches_;  ///< 监听槽位（按槽位索引）
+    std::unordered_map<int, uint32_t> watch_slots_; ///< fd→监听槽位
+    std::vector<uint32_t> free_watch_slots_;         ///< 可复用的槽位
+    std::vector<uint32_t> released_watch_slots_;     ///< 本轮事件处理后才可复用的槽位
+    WorkerPool workers_;            ///< 执行阻塞操作的工作线程池
+    TaskScheduler tasks_{*this};    ///< 协程任务调度器
+    Telemetry telemetry_;           ///< 运行统计
+    Launcher launcher_{*this};      ///< 外部程序启动服务
+    ControlServer control_{*this};  ///< 本地控制套接字
+    OutputWriter output_{*this};    ///< 标准输出写入器，读取端停止读取时不阻塞事件循环
     ModuleManager module_manager_;  ///< 模块管理器
     Timer timer_;                   ///< 定时器
-    volatile bool running_ = false; ///< 运行状态标志
+    bool running_ = false;          ///< 运行状态标志
+    bool paused_ = false;           ///< 状态栏是否被i3bar隐藏（收到STOP_SIGNAL）
+    bool reprobe_hardware_ = false; ///< 是否忽略硬件探测缓存
+    uint64_t volume_step_ = 0;      ///< 音量步长（百分比），0表示使用模块默认值
+    std::string volume_command_;    ///< 外部音量脚本，为空时直接修改混音器
+    HardwareProfile hardware_;      ///< 启动时探测到的硬件
+
+    /**
+     * @brief 一个完成了start()的异步启动模块
+     */
+    struct StartResult {
+        std::shared_ptr<Module> module;               ///< 模块
+        std::chrono::steady_clock::duration elapsed{}; ///< start()的耗时
+        std::string error;                            ///< start()抛出的异常信息，成功时为空
+    };
+
+    std::chrono::steady_clock::time_point startup_begin_ =
+        std::chrono::steady_clock::now();   ///< 启动计时的起点
+    size_t starts_pending_ = 0;              ///< 尚未就绪的异步启动模块数
+    std::string snapshot_path_;              ///< 快照路径，为空时不保存
+    uint64_t last_saved_counter_ = 0;        ///< 上一次定期保存快照时的定时器计数
+    std::optional<Snapshot> snapshot_;       ///< 启动时读取的快照，模块注册完毕后释放
+
+    /**
+     * @brief 用快照中的内容初始化刚注册的模块
+     * @param module 已注册、尚未start()的模块
+     *
+     * 设置快照中的输出作为首次更新前的内容，并恢复计数器基准。
+     */
+    void restoreFromSnapshot(Module &module);
+
+    /**
+     * @brief 保存快照（定期和退出时调用）
+     */
+    void saveSnapshot();
+
+    /**
+     * @brief 通过signalfd接收信号
+     * @return true如果设置成功，false如果失败
+     *
+     * 阻塞SIGINT、SIGTERM、STOP_SIGNAL、CONT_SIGNAL以及所有实时信号
+     * （SIGRTMIN+N用于按模块的刷新信号立即更新模块），改为从signalfd读取，
+     * 信号在事件循环中同步处理，不存在异步信号安全问题。
+     * SIGPIPE被忽略，i3bar退出后写出返回EPIPE，由OutputWriter停止系统。
+     * 必须在创建任何线程（包括工作线程池）之前调用，线程会继承信号掩码。
+     */
+    bool setupSignals();
+
+    /**
+     * @brief 读取并处理signalfd中的所有信号
+     */
+    void handleSignals();
+
+    /**
+     * @brief 暂停采样和输出
+     *
+     * 解除秒级定时器并停止输出帧，状态栏隐藏期间不消耗CPU。
+     */
+    void suspend();
+
+    /**
+     * @brief 恢复采样和输出
+     *
+     * 恢复秒级定时器，立即刷新所有模块并输出完整的一帧。
+     */
+    void resume();
 
     /**
      * @brief 创建epoll实例
@@ -168,7 +438,8 @@ class System {
     /**
      * @brief 初始化所有模块
      *
-     * 调用所有模块的init()方法，执行模块特定的初始化操作。
+     * 先获取硬件信息（缓存或重新探测），只创建有对应硬件的模块，
+     * 再调用模块的init()方法，执行模块特定的初始化操作。
      */
     void initializeModules();
 
@@ -182,12 +453,58 @@ class System {
     void handleEvents(struct epoll_event *events, int nfds);
 
     /**
-     * @brief 输出i3bar协议头
+     * @brief 在工作线程池中执行模块的start()
+     * @param module 已注册、尚未就绪的模块
      *
-     * 输出i3bar协议要求的头部信息，包括版本和点击事件支持等。
+     * 完成后由事件循环调用handleStartResult()。
+     */
+    void beginAsyncStart(std::shared_ptr<Module> module);
+
+    /**
+     * @brief 完成模块启动：init()、注册文件描述符、首次update()并标记就绪
+     * @param module 已完成start()的模块
+     */
+    void finishStart(const std::shared_ptr<Module> &module);
+
+    /**
+     * @brief 处理工作线程完成的启动结果（在事件循环线程中调用）
+     * @param result 启动结果
+     */
+    void handleStartResult(const StartResult &result);
+
+    /**
+     * @brief 输出一条启动跟踪记录
+     * @param event 事件描述
+     *
+     * 格式为"Startup: <event> after <毫秒> ms"，时间从System构造开始计算。
+     */
+    void traceStartup(const std::string &event) const;
+
+    /**
+     * @brief 输出协议头
+     *
+     * 输出后端要求的头部信息（i3bar的版本、stop/cont信号和点击事件支持等），
+     * 其它后端没有协议头。
      */
     void outputProtocolHeader();
 
+    /**
+     * @brief 输出当前帧
+     *
+     * 没有模块输出变化时不提交，避免无意义的写出和丢帧计数。
+     *
+     * @return 提交的帧大小（字节），没有提交时为0
+     */
+    size_t outputFrame();
+
+    /**
+     * @brief 检查本轮事件处理的耗时
+     * @param start epoll_wait返回的时刻
+     *
+     * 超过FRAME_WATCHDOG时记录本轮最慢的模块update()。
+     */
+    void checkWatchdog(std::chrono::steady_clock::time_point start);
+
     /**
      * @brief 文件描述符RAII包装器
      *
@@ -263,5 +580,6 @@ class System {
         int fd_; ///< 文件描述符
     };
 
-    FdWrapper epoll_fd_wrapper_; ///< epoll文件描述符包装器
+    FdWrapper epoll_fd_wrapper_;  ///< epoll文件描述符包装器
+    FdWrapper signal_fd_wrapper_; ///< signalfd包装器
 };
\ No newline at end of file
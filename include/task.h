@@ -0,0 +1,536 @@
+#pragma once
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @file task.h
+ * @brief 在epoll事件循环中运行的C++20协程
+ *
+ * 多步I/O的模块逻辑写成回调很别扭：D-Bus调用后等待回复、启动辅助程序后读取输出、
+ * 发送netlink请求后等待dump，每一步都要拆成一个回调并手动保存中间状态。
+ * Task<T>让模块把这类逻辑写成顺序代码，由现有的事件循环驱动，不阻塞、不需要线程：
+ *
+ * @code
+ * Task<> MyModule::refresh() {
+ *     co_await sleepFor(std::chrono::milliseconds(250));
+ *     const uint32_t events = co_await readable(fd_);
+ *     auto reply = co_await dbusCall<std::string>(proxy, "org.example.Iface", "Get");
+ *     setOutput(...);
+ * }
+ *
+ * void MyModule::init() {
+ *     getSystem()->getTaskScheduler().spawn(refresh(), getName());
+ * }
+ * @endcode
+ *
+ * - Task是惰性的：创建后不执行，被co_await或交给TaskScheduler::spawn()时才开始
+ * - 子任务完成时通过对称转移直接恢复父任务，不经过事件循环
+ * - 协程帧从FramePool按大小分级的空闲链表分配，反复创建的短任务不产生堆分配
+ * - 所有协程都在事件循环线程中创建和恢复，FramePool因此不加锁
+ *
+ * 等待中的协程帧被销毁时（如System关闭时TaskScheduler销毁所有根任务），
+ * 帧中挂起的等待对象在析构函数中注销定时器、fd监听或取消D-Bus调用，不会留下悬空的句柄。
+ *
+ * GCC 12为协程生成的状态机会误报-Wswitch-default和-Wzero-as-null-pointer-constant，
+ * 定义协程的地方需要用#pragma GCC diagnostic局部关闭这两个警告。
+ */
+
+class TaskScheduler;
+
+/**
+ * @brief 协程帧的内存池
+ *
+ * 帧按GRANULARITY向上取整分级，每级一个空闲链表，释放的帧留在链表中供下一次复用。
+ * 超过MAX_POOLED_SIZE的帧直接使用全局operator new。只能在事件循环线程中使用。
+ */
+class FramePool {
+  public:
+    /**
+     * @brief 大小分级的粒度（字节）
+     */
+    static constexpr size_t GRANULARITY = 64;
+
+    /**
+     * @brief 使用内存池的最大帧大小（字节）
+     */
+    static constexpr size_t MAX_POOLED_SIZE = 1024;
+
+    /**
+     * @brief 分配统计
+     */
+    struct Stats {
+        uint64_t allocations = 0;      ///< 分配的帧数
+        uint64_t pool_hits = 0;        ///< 从空闲链表取得的帧数
+        uint64_t heap_allocations = 0; ///< 调用全局operator new的次数
+        uint64_t cached_blocks = 0;    ///< 空闲链表中的帧数
+    };
+
+    /**
+     * @brief 分配协程帧
+     * @param size 帧大小
+     * @return 内存地址，失败时抛出std::bad_alloc
+     */
+    static void *allocate(size_t size);
+
+    /**
+     * @brief 释放协程帧
+     * @param ptr allocate()返回的地址
+     * @param size 分配时的大小
+     */
+    static void deallocate(void *ptr, size_t size) noexcept;
+
+    /**
+     * @brief 获取分配统计
+     */
+    static Stats getStats();
+};
+
+/**
+ * @brief 所有Task的promise的公共部分
+ */
+class TaskPromiseBase {
+  public:
+    static void *operator new(size_t size) {
+        return FramePool::allocate(size);
+    }
+
+    static void operator delete(void *ptr, size_t size) noexcept {
+        FramePool::deallocate(ptr, size);
+    }
+
+    /**
+     * @brief 结束时恢复等待者；没有等待者的根任务交给TaskScheduler回收
+     */
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            TaskPromiseBase &promise = handle.promise();
+            if (promise.continuation_) {
+                return promise.continuation_;
+            }
+            if (promise.scheduler_) {
+                // 之后不能再访问promise，帧可能已被销毁
+                finishRoot(*promise.scheduler_, handle, promise.exception_);
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+
+    void unhandled_exception() noexcept {
+        exception_ = std::current_exception();
+    }
+
+    /**
+     * @brief 获取运行本任务的调度器
+     * @return 调度器，任务尚未交给spawn()或被其它任务co_await时为nullptr
+     */
+    TaskScheduler *getScheduler() const {
+        return scheduler_;
+    }
+
+  protected:
+    template <typename T> friend class Task;
+    friend class TaskScheduler;
+
+    /**
+     * @brief 通知调度器根任务结束（在task.cpp中实现，避免头文件依赖TaskScheduler）
+     */
+    static void finishRoot(TaskScheduler &scheduler, std::coroutine_handle<> handle,
+                           std::exception_ptr exception) noexcept;
+
+    /**
+     * @brief 异常时重新抛出
+     */
+    void rethrowIfFailed() const {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+    std::coroutine_handle<> continuation_; ///< co_await本任务的父任务
+    TaskScheduler *scheduler_ = nullptr;   ///< 调度器，子任务从父任务继承
+    std::exception_ptr exception_;         ///< 协程体抛出的异常
+};
+
+template <typename T = void> class Task;
+
+/**
+ * @brief 有返回值的Task的promise
+ */
+template <typename T> class TaskPromise : public TaskPromiseBase {
+  public:
+    Task<T> get_return_object() noexcept;
+
+    template <typename U> void return_value(U &&value) {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    /**
+     * @brief 取出结果，协程体抛出异常时重新抛出
+     */
+    T result() {
+        rethrowIfFailed();
+        return std::move(*value_);
+    }
+
+  private:
+    std::optional<T> value_; ///< co_return的值
+};
+
+/**
+ * @brief 无返回值的Task的promise
+ */
+template <> class TaskPromise<void> : public TaskPromiseBase {
+  public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    /**
+     * @brief 协程体抛出异常时重新抛出
+     */
+    void result() {
+        rethrowIfFailed();
+    }
+};
+
+/**
+ * @brief 协程任务
+ * @tparam T co_return的类型
+ *
+ * 只能移动。Task对象拥有协程帧，析构时销毁尚未完成的帧（连同其中挂起的子任务）。
+ */
+template <typename T> class [[nodiscard]] Task {
+  public:
+    using promise_type = TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle handle) noexcept : handle_(handle) {}
+
+    Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    /**
+     * @brief 等待子任务完成
+     *
+     * 子任务继承父任务的调度器，完成后通过对称转移直接恢复父任务。
+     */
+    auto operator co_await() && noexcept {
+        return Awaiter{handle_};
+    }
+
+    /**
+     * @brief 放弃对协程帧的所有权
+     * @return 协程句柄，调用者负责销毁
+     */
+    Handle release() noexcept {
+        return std::exchange(handle_, {});
+    }
+
+  private:
+    /**
+     * @brief co_await子任务时的等待对象
+     */
+    struct Awaiter {
+        Handle handle;
+
+        bool await_ready() const noexcept {
+            return !handle || handle.done();
+        }
+
+        template <typename Promise>
+            requires std::derived_from<Promise, TaskPromiseBase>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> parent) noexcept {
+            handle.promise().continuation_ = parent;
+            handle.promise().scheduler_ = parent.promise().getScheduler();
+            return handle;
+        }
+
+        T await_resume() {
+            return handle.promise().result();
+        }
+    };
+
+    Handle handle_; ///< 协程句柄
+};
+
+template <typename T> Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+/**
+ * @brief 等待一段时间
+ *
+ * 所有睡眠共用TaskScheduler的一个timerfd，按到期时刻排序。
+ */
+class SleepAwaiter {
+  public:
+    explicit SleepAwaiter(std::chrono::steady_clock::duration duration) : duration_(duration) {}
+
+    /**
+     * @brief 析构函数，协程在等待中被销毁时注销定时器
+     */
+    ~SleepAwaiter();
+
+    SleepAwaiter(const SleepAwaiter &) = delete;
+    SleepAwaiter &operator=(const SleepAwaiter &) = delete;
+
+    bool await_ready() const noexcept {
+        return duration_ <= std::chrono::steady_clock::duration::zero();
+    }
+
+    template <typename Promise>
+        requires std::derived_from<Promise, TaskPromiseBase>
+    bool await_suspend(std::coroutine_handle<Promise> handle) {
+        return suspend(handle, handle.promise().getScheduler());
+    }
+
+    void await_resume() const noexcept {}
+
+  private:
+    friend class TaskScheduler;
+
+    /**
+     * @brief 注册定时器
+     * @return false如果没有调度器（此时立即继续执行）
+     */
+    bool suspend(std::coroutine_handle<> handle, TaskScheduler *scheduler);
+
+    using TimerMap = std::multimap<std::chrono::steady_clock::time_point, SleepAwaiter *>;
+
+    std::chrono::steady_clock::duration duration_; ///< 睡眠时长
+    TaskScheduler *scheduler_ = nullptr;           ///< 注册了定时器的调度器
+    std::coroutine_handle<> handle_;               ///< 等待中的协程
+    TimerMap::iterator timer_;                     ///< 定时器表中的位置
+    bool pending_ = false;                         ///< 是否仍在等待
+};
+
+/**
+ * @brief 等待文件描述符就绪
+ *
+ * 通过System::watchFd()注册一次性的监听，就绪后注销并恢复协程，
+ * co_await的结果为epoll返回的事件掩码。fd不能同时以其它方式被监听。
+ */
+class ReadableAwaiter {
+  public:
+    ReadableAwaiter(int fd, uint32_t events) : fd_(fd), events_(events) {}
+
+    /**
+     * @brief 析构函数，协程在等待中被销毁时注销监听
+     */
+    ~ReadableAwaiter();
+
+    ReadableAwaiter(const ReadableAwaiter &) = delete;
+    ReadableAwaiter &operator=(const ReadableAwaiter &) = delete;
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    template <typename Promise>
+        requires std::derived_from<Promise, TaskPromiseBase>
+    bool await_suspend(std::coroutine_handle<Promise> handle) {
+        return suspend(handle, handle.promise().getScheduler());
+    }
+
+    /**
+     * @return epoll事件掩码，注册监听失败时为EPOLLERR
+     */
+    uint32_t await_resume() const noexcept {
+        return revents_;
+    }
+
+  private:
+    friend class TaskScheduler;
+
+    /**
+     * @brief 注册监听
+     * @return false如果注册失败（此时立即以EPOLLERR继续执行）
+     */
+    bool suspend(std::coroutine_handle<> handle, TaskScheduler *scheduler);
+
+    /**
+     * @brief fd就绪时由监听回调调用
+     */
+    void onReady(uint32_t revents);
+
+    int fd_;                             ///< 文件描述符
+    uint32_t events_;                    ///< 等待的事件
+    uint32_t revents_ = 0;               ///< 就绪的事件
+    TaskScheduler *scheduler_ = nullptr; ///< 注册了监听的调度器
+    std::coroutine_handle<> handle_;     ///< 等待中的协程
+    bool pending_ = false;               ///< 是否仍在等待
+};
+
+/**
+ * @brief 等待一段时间
+ * @param duration 时长，不大于0时不挂起
+ */
+inline SleepAwaiter sleepFor(std::chrono::steady_clock::duration duration) {
+    return SleepAwaiter(duration);
+}
+
+/**
+ * @brief 等待文件描述符可读
+ * @param fd 文件描述符
+ * @param events epoll事件掩码，默认为EPOLLIN（0x001）
+ */
+inline ReadableAwaiter readable(int fd, uint32_t events = 0x001) {
+    return ReadableAwaiter(fd, events);
+}
+
+class System;
+
+/**
+ * @brief 根任务的调度器
+ *
+ * 由System持有。spawn()接管根任务并立即运行到第一个挂起点，任务结束后回收其帧，
+ * 未捕获的异常记录到标准错误。睡眠共用一个timerfd，fd等待使用System::watchFd()，
+ * 恢复都发生在事件循环线程中。
+ */
+class TaskScheduler {
+  public:
+    /**
+     * @brief 运行统计
+     */
+    struct Stats {
+        uint64_t spawned = 0;  ///< spawn()的根任务数
+        uint64_t finished = 0; ///< 已结束的根任务数
+        uint64_t failed = 0;   ///< 以异常结束的根任务数
+        size_t running = 0;    ///< 尚未结束的根任务数
+        size_t timers = 0;     ///< 等待中的睡眠数
+    };
+
+    /**
+     * @brief 构造函数
+     * @param system 系统对象，用于注册timerfd和fd监听
+     */
+    explicit TaskScheduler(System &system);
+
+    /**
+     * @brief 析构函数，等同于shutdown()
+     */
+    ~TaskScheduler();
+
+    // 删除拷贝和移动操作，等待对象保存了调度器的指针
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+    TaskScheduler(TaskScheduler &&) = delete;
+    TaskScheduler &operator=(TaskScheduler &&) = delete;
+
+    /**
+     * @brief 创建timerfd并注册到事件循环
+     * @return true如果成功
+     */
+    bool initialize();
+
+    /**
+     * @brief 运行根任务
+     * @param task 任务，运行到第一个挂起点后返回
+     * @param name 任务名称（通常为模块名称），用于日志
+     */
+    void spawn(Task<> task, std::string name);
+
+    /**
+     * @brief 销毁所有尚未结束的根任务
+     *
+     * 必须在任务引用的模块销毁之前调用。
+     */
+    void shutdown();
+
+    /**
+     * @brief 获取运行统计
+     */
+    Stats getStats() const;
+
+  private:
+    friend class TaskPromiseBase;
+    friend class SleepAwaiter;
+    friend class ReadableAwaiter;
+
+    /**
+     * @brief 一个根任务
+     */
+    struct Root {
+        std::coroutine_handle<> handle; ///< 协程句柄
+        std::string name;               ///< 任务名称
+    };
+
+    /**
+     * @brief 根任务结束时回收协程帧
+     */
+    void finishRoot(std::coroutine_handle<> handle, std::exception_ptr exception) noexcept;
+
+    /**
+     * @brief 注册睡眠
+     */
+    SleepAwaiter::TimerMap::iterator addTimer(std::chrono::steady_clock::time_point deadline,
+                                              SleepAwaiter *awaiter);
+
+    /**
+     * @brief 注销睡眠
+     */
+    void cancelTimer(SleepAwaiter::TimerMap::iterator timer);
+
+    /**
+     * @brief 按最早的到期时刻设置timerfd，没有睡眠时解除
+     */
+    void armTimer();
+
+    /**
+     * @brief timerfd到期时恢复所有到期的睡眠
+     */
+    void handleTimer();
+
+    System &system_;                  ///< 系统对象
+    int timer_fd_ = -1;               ///< 所有睡眠共用的timerfd
+    std::chrono::steady_clock::time_point armed_at_; ///< timerfd当前的到期时刻
+    SleepAwaiter::TimerMap timers_;   ///< 等待中的睡眠（按到期时刻排序）
+    std::vector<Root> roots_;         ///< 尚未结束的根任务
+    Stats stats_;                     ///< 运行统计
+};
@@ -0,0 +1,217 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+/**
+ * @file telemetry.h
+ * @brief 事件循环和模块的延迟与开销统计
+ *
+ * 状态栏常驻运行，它本身的开销也应当可以观察。Telemetry记录：
+ * - 每个模块update()的耗时（由ModuleManager记录）
+ * - 每轮事件处理从epoll_wait返回到帧提交的延迟
+ * - 帧大小、帧间隔和帧率
+ * - 从sysfs/procfs读取的字节数和计数的系统调用数（累计值和每个节拍的分布）
+ *
+ * 分布用HDR风格的对数线性直方图记录：每个2的幂区间再等分为16个子桶，
+ * 相对误差不超过1/16，记录一次只是几次位运算和一次自增。计时使用steady_clock
+ * （CLOCK_MONOTONIC，经vDSO不进入内核）。直方图只在事件循环线程中记录，不加锁；
+ * 可能在工作线程中累加的计数器使用relaxed原子操作。开销足够低，始终开启。
+ *
+ * 收到SIGUSR1时把完整报告写到stderr，控制套接字的stats命令返回单行摘要。
+ */
+
+class ModuleManager;
+
+/**
+ * @brief 对数线性直方图
+ */
+class Histogram {
+  public:
+    /**
+     * @brief 每个2的幂区间的子桶数的对数
+     */
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+
+    /**
+     * @brief 可区分的最大值的位数，更大的值计入最后一个桶（纳秒计约18分钟）
+     */
+    static constexpr unsigned MAX_BITS = 40;
+
+    /**
+     * @brief 桶的数量
+     */
+    static constexpr size_t BUCKETS = size_t{MAX_BITS - SUB_BUCKET_BITS + 1} << SUB_BUCKET_BITS;
+
+    /**
+     * @brief 记录一个值
+     * @param value 值
+     */
+    void record(uint64_t value) {
+        ++counts_[bucketIndex(value)];
+        ++count_;
+        sum_ += value;
+        if (value < min_) {
+            min_ = value;
+        }
+        if (value > max_) {
+            max_ = value;
+        }
+    }
+
+    /**
+     * @brief 获取记录的值的个数
+     */
+    uint64_t getCount() const {
+        return count_;
+    }
+
+    /**
+     * @brief 获取最小值，没有记录时为0
+     */
+    uint64_t getMin() const {
+        return count_ == 0 ? 0 : min_;
+    }
+
+    /**
+     * @brief 获取最大值（精确值）
+     */
+    uint64_t getMax() const {
+        return max_;
+    }
+
+    /**
+     * @brief 获取平均值，没有记录时为0
+     */
+    double getMean() const;
+
+    /**
+     * @brief 获取分位数
+     * @param quantile 分位（0～1）
+     * @return 该分位所在桶的上界，不超过最大值；没有记录时为0
+     */
+    uint64_t getPercentile(double quantile) const;
+
+    /**
+     * @brief 清空所有记录
+     */
+    void reset();
+
+  private:
+    /**
+     * @brief 值所在的桶
+     */
+    static size_t bucketIndex(uint64_t value) {
+        constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+        constexpr uint64_t LIMIT = (uint64_t{1} << MAX_BITS) - 1;
+        if (value < SUB_BUCKETS) {
+            return value;
+        }
+        if (value > LIMIT) {
+            value = LIMIT;
+        }
+        // 最高位决定区间，其后SUB_BUCKET_BITS位决定子桶
+        const unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+        return ((uint64_t{shift} + 1) << SUB_BUCKET_BITS) + ((value >> shift) - SUB_BUCKETS);
+    }
+
+    /**
+     * @brief 桶中最大的值
+     */
+    static uint64_t bucketUpperBound(size_t index);
+
+    std::array<uint64_t, BUCKETS> counts_{};            ///< 各桶的计数
+    uint64_t count_ = 0;                                ///< 记录的值的个数
+    uint64_t sum_ = 0;                                  ///< 值的总和
+    uint64_t min_ = std::numeric_limits<uint64_t>::max(); ///< 最小值
+    uint64_t max_ = 0;                                  ///< 最大值
+};
+
+/**
+ * @brief 事件循环的统计
+ *
+ * 由System持有，记录循环级别的分布；模块update()的分布在ModuleManager中。
+ */
+class Telemetry {
+  public:
+    /**
+     * @brief 累加从sysfs/procfs读取的字节数（可在任何线程中调用）
+     * @param bytes 字节数
+     */
+    static void addBytesRead(uint64_t bytes) {
+        bytes_read_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 累加计数的系统调用数（可在任何线程中调用）
+     * @param count 系统调用数
+     *
+     * 只计数采样数据源的open/pread/close、epoll_wait和标准输出的write，
+     * 不是进程全部的系统调用。
+     */
+    static void addSyscalls(uint64_t count = 1) {
+        syscalls_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 获取累计读取的字节数
+     */
+    static uint64_t getBytesRead() {
+        return bytes_read_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 获取累计计数的系统调用数
+     */
+    static uint64_t getSyscalls() {
+        return syscalls_.load(std::memory_order_relaxed);
+    }
+
+    Telemetry();
+
+    /**
+     * @brief 记录一轮事件处理
+     * @param start epoll_wait返回的时刻
+     * @param frame_bytes 本轮提交的帧大小，没有提交帧时为0
+     */
+    void recordIteration(std::chrono::steady_clock::time_point start, size_t frame_bytes);
+
+    /**
+     * @brief 记录一个定时器节拍内的读取字节数和系统调用数
+     */
+    void recordTick();
+
+    /**
+     * @brief 生成完整的多行报告
+     * @param modules 模块管理器，提供各模块update()的分布
+     */
+    std::string report(const ModuleManager &modules) const;
+
+    /**
+     * @brief 生成单行摘要（控制套接字的回复）
+     * @param modules 模块管理器
+     * @return 以空格分隔的"键=值"，分布为"p50/p90/p99/最大值"
+     */
+    std::string summary(const ModuleManager &modules) const;
+
+  private:
+    static inline std::atomic<uint64_t> bytes_read_{0}; ///< 累计读取的字节数
+    static inline std::atomic<uint64_t> syscalls_{0};   ///< 累计计数的系统调用数
+
+    std::chrono::steady_clock::time_point started_;    ///< 开始统计的时刻
+    std::chrono::steady_clock::time_point last_frame_; ///< 上一帧提交的时刻
+    uint64_t frames_ = 0;                              ///< 提交的帧数
+    uint64_t tick_bytes_base_ = 0;                     ///< 上一个节拍时的累计字节数
+    uint64_t tick_syscalls_base_ = 0;                  ///< 上一个节拍时的累计系统调用数
+
+    Histogram loop_latency_;   ///< epoll_wait返回到帧提交的延迟（纳秒）
+    Histogram frame_bytes_;    ///< 帧大小（字节）
+    Histogram frame_interval_; ///< 相邻两帧的间隔（纳秒）
+    Histogram tick_bytes_;     ///< 每个节拍读取的字节数
+    Histogram tick_syscalls_;  ///< 每个节拍的系统调用数
+};
@@ -1,11 +1,9 @@
 #pragma once
-#include "module.h"
-#include <vector>
+#include <cstdint>
 #include <sys/timerfd.h>
-#include <memory>
 #include <unistd.h>
 
-// Timer类负责管理时间更新的模块
+// Timer类负责产生秒级节拍，到期模块的调度由ModuleManager完成
 class Timer {
   public:
     Timer();
@@ -25,20 +23,11 @@ class Timer {
     // 获取定时器文件描述符
     int getFd() const;
 
-    // 添加需要按时间间隔更新的模块
-    void addIntervalModule(std::shared_ptr<Module> module);
+    // 处理定时器事件，返回本次到期的次数
+    uint64_t handleTimerEvent();
 
-    // 移除模块
-    void removeModule(const std::shared_ptr<Module> &module);
-
-    // 处理定时器事件，更新需要更新的模块
-    void handleTimerEvent();
-
-    // 更新定时器
-    void update();
-
-    // 检查某个模块是否需要在当前计数器值更新
-    bool shouldUpdate(uint64_t counter, std::shared_ptr<Module> module);
+    // 更新定时器，返回本次到期的次数
+    uint64_t update();
 
     // 获取当前计数器值
     uint64_t getCounter() const;
@@ -46,11 +35,17 @@ class Timer {
     // 设置定时器间隔
     bool setInterval(uint64_t seconds);
 
+    // 暂停定时器（解除timerfd），暂停期间不产生节拍也不唤醒进程
+    bool pause();
+
+    // 恢复定时器，一个间隔后产生下一个节拍
+    bool resume();
+
   private:
     int timer_fd_ = -1;
-    volatile uint64_t counter_ = 0;
+    uint64_t counter_ = 0;
+    uint64_t interval_ = 1;
     int epoll_fd_ = -1;
-    std::vector<std::shared_ptr<Module>> interval_modules_;
 
     // 创建定时器文件描述符
     int createTimerFd();
@@ -0,0 +1,174 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+/**
+ * @file trace.h
+ * @brief 事件循环活动的时间线追踪
+ *
+ * 状态栏卡顿时，统计分布（telemetry.h）只能说明"有多慢"，说明不了"那一帧里发生了什么"。
+ * 启用追踪（--trace）后，事件循环把每轮迭代、按来源区分的epoll唤醒、每次update()、
+ * handleClick()、flush()、sample()、帧输出以及D-Bus和ALSA事件分发记录为带时间戳的事件，
+ * 导出为Chrome trace event格式的JSON，可以直接在chrome://tracing或Perfetto UI中查看。
+ *
+ * 事件写入固定容量的环形缓冲区：写入者用原子自增领取槽位，写完字段后发布槽位的序号，
+ * 不加锁，工作线程中的sample()也可以安全记录。缓冲区写满后覆盖最旧的事件。
+ * 缓冲区在启用时一次性分配并逐页写入，之后记录事件不分配内存也不触发缺页，
+ * 开启追踪不会明显改变它所测量的时序。未启用时每个记录点只是一次relaxed原子读取。
+ *
+ * 收到SIGUSR1、控制套接字的trace命令以及退出时把缓冲区写入追踪文件。
+ */
+
+/**
+ * @brief 追踪事件的种类
+ */
+enum class TraceKind : uint8_t {
+    ITERATION, ///< 一轮事件处理（epoll_wait返回到帧输出）
+    WAKEUP,    ///< epoll唤醒（瞬时事件），参数为来源和索引
+    UPDATE,    ///< 模块update()，参数为模块ID
+    SAMPLE,    ///< 工作线程中的模块sample()，参数为模块ID
+    CLICK,     ///< 模块handleClick()，参数为模块ID
+    FLUSH,     ///< 模块flush()，参数为模块ID
+    OUTPUT,    ///< 拼装并提交一帧
+    DBUS,      ///< D-Bus连接的事件分发，参数为模块ID
+    ALSA,      ///< ALSA混音器的事件分发，参数为fd
+    COUNT,     ///< 种类数量
+};
+
+/**
+ * @brief 追踪记录器
+ *
+ * 全局唯一，所有方法都是静态的，记录点不需要持有System的引用。
+ */
+class Trace {
+  public:
+    /**
+     * @brief 默认的缓冲区容量（事件数，必须是2的幂）
+     */
+    static constexpr size_t DEFAULT_CAPACITY = size_t{1} << 16;
+
+    /**
+     * @brief 启用追踪
+     * @param path 追踪文件路径，为空时使用defaultPath()
+     * @param capacity 缓冲区容量（事件数），向上取整为2的幂
+     *
+     * 必须在创建工作线程之前、事件循环线程中调用。
+     */
+    static void enable(std::string path, size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief 是否已启用追踪
+     */
+    static bool isEnabled() {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 获取当前时刻（steady_clock纳秒）
+     */
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch()
+        )
+                                         .count());
+    }
+
+    /**
+     * @brief 记录一个有持续时间的事件
+     * @param kind 种类
+     * @param arg 参数（模块ID等）
+     * @param start 开始时刻（now()）
+     * @param end 结束时刻（now()）
+     */
+    static void complete(TraceKind kind, uint32_t arg, uint64_t start, uint64_t end);
+
+    /**
+     * @brief 记录一个瞬时事件
+     * @param kind 种类
+     * @param arg 参数
+     * @param arg2 第二个参数
+     */
+    static void instant(TraceKind kind, uint32_t arg, uint32_t arg2 = 0);
+
+    /**
+     * @brief 把缓冲区中的事件写入追踪文件
+     * @param module_name 把模块ID解析为名称，返回nullptr时只输出ID
+     * @return true如果写入成功
+     *
+     * 在事件循环线程中调用。写入期间其它线程仍可记录事件，正在被覆盖的槽位会被跳过。
+     */
+    static bool flush(const std::function<const std::string *(uint32_t)> &module_name);
+
+    /**
+     * @brief 默认的追踪文件路径
+     * @return $XDG_RUNTIME_DIR/seedstatus-trace.json，未设置时为/tmp/seedstatus-<uid>-trace.json
+     */
+    static std::string defaultPath();
+
+    /**
+     * @brief 获取追踪文件路径
+     */
+    static const std::string &getPath();
+
+  private:
+    /**
+     * @brief 一个事件，占一个槽位
+     */
+    struct Event {
+        std::atomic<uint64_t> sequence{0}; ///< 已发布事件的序号+1，0表示空槽位
+        uint64_t start = 0;                ///< 开始时刻（纳秒）
+        uint64_t duration = 0;             ///< 持续时间（纳秒），瞬时事件为0
+        uint32_t arg = 0;                  ///< 参数
+        uint32_t arg2 = 0;                 ///< 第二个参数
+        uint32_t tid = 0;                  ///< 线程ID
+        TraceKind kind = TraceKind::ITERATION; ///< 种类
+        bool is_instant = false;           ///< 是否为瞬时事件
+    };
+
+    /**
+     * @brief 领取槽位并写入事件
+     */
+    static void record(TraceKind kind, uint32_t arg, uint32_t arg2, uint64_t start,
+                       uint64_t duration, bool is_instant);
+
+    static inline std::atomic<bool> enabled_{false};  ///< 是否已启用
+    static inline std::atomic<uint64_t> next_{0};     ///< 下一个事件的序号
+    static inline std::unique_ptr<Event[]> events_;   ///< 环形缓冲区
+    static inline size_t mask_ = 0;                   ///< 容量-1
+    static inline std::string path_;                  ///< 追踪文件路径
+};
+
+/**
+ * @brief 作用域内的追踪区间
+ *
+ * 构造时记录开始时刻，析构时记录一个完整事件。未启用追踪时不读取时钟。
+ *
+ * @code
+ * TraceSpan span(TraceKind::UPDATE, id);
+ * module.update();
+ * @endcode
+ */
+class TraceSpan {
+  public:
+    TraceSpan(TraceKind kind, uint32_t arg)
+        : start_(Trace::isEnabled() ? Trace::now() : 0), arg_(arg), kind_(kind) {}
+
+    ~TraceSpan() {
+        if (start_ != 0) {
+            Trace::complete(kind_, arg_, start_, Trace::now());
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+  private:
+    uint64_t start_; ///< 开始时刻，0表示未启用
+    uint32_t arg_;   ///< 参数
+    TraceKind kind_; ///< 种类
+};
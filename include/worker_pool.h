@@ -0,0 +1,160 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file worker_pool.h
+ * @brief 执行阻塞操作的工作线程池
+ *
+ * 所有update()原先都在epoll线程中执行。一次缓慢的sysfs读取（amdgpu的
+ * gpu_busy_percent会唤醒休眠的独立显卡，耗时可达100毫秒以上）、一次D-Bus往返
+ * 或挂起的NFS statvfs都会冻结点击和其它所有模块。
+ *
+ * WorkerPool在少量工作线程中执行这类操作。每个任务分为两部分：
+ * - work：在工作线程中执行的阻塞部分
+ * - done：work完成后在事件循环线程中执行的部分（渲染、setOutput()等）
+ *
+ * 完成的任务被压入一个无锁的多生产者单消费者栈，只有栈由空变为非空时才写eventfd，
+ * 一批同时完成的任务只唤醒事件循环一次。事件循环读取eventfd后整体取出栈中的任务，
+ * 按完成顺序依次调用done。渲染和输出始终只在事件循环线程中进行。
+ *
+ * 任务提交使用互斥锁和条件变量（工作线程没有任务时必须阻塞等待），
+ * 这一侧只在事件循环线程提交任务时加锁，不在热路径上。
+ */
+
+/**
+ * @brief 工作线程池
+ */
+class WorkerPool {
+  public:
+    /**
+     * @brief 默认的工作线程数
+     */
+    static constexpr size_t DEFAULT_THREADS = 2;
+
+    /**
+     * @brief 关闭时等待正在执行的任务的时间，超时后分离仍在阻塞的线程
+     */
+    static constexpr std::chrono::milliseconds SHUTDOWN_TIMEOUT{500};
+
+    /**
+     * @brief 任务统计
+     */
+    struct Stats {
+        uint64_t submitted = 0; ///< 提交的任务数
+        uint64_t completed = 0; ///< 已在事件循环中执行完done的任务数
+        uint64_t wakeups = 0;   ///< 事件循环被eventfd唤醒的次数
+    };
+
+    WorkerPool();
+
+    /**
+     * @brief 析构函数，等同于shutdown()
+     */
+    ~WorkerPool();
+
+    // 删除拷贝和移动操作，工作线程持有共享状态
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+    WorkerPool(WorkerPool &&) = delete;
+    WorkerPool &operator=(WorkerPool &&) = delete;
+
+    /**
+     * @brief 创建eventfd并启动工作线程
+     * @param threads 工作线程数
+     * @return true如果成功
+     *
+     * 工作线程继承调用线程的信号掩码，必须在System阻塞信号之后调用。
+     */
+    bool initialize(size_t threads = DEFAULT_THREADS);
+
+    /**
+     * @brief 获取完成通知的eventfd
+     * @return 文件描述符，可读时调用runCompletions()；未初始化时为-1
+     */
+    int getFd() const;
+
+    /**
+     * @brief 提交任务
+     * @param work 在工作线程中执行，抛出的异常被记录后忽略
+     * @param done 在事件循环线程中、work完成后执行，可以为空
+     *
+     * 线程池未初始化时在当前线程中依次执行work和done。
+     */
+    void submit(std::function<void()> work, std::function<void()> done);
+
+    /**
+     * @brief 执行所有已完成任务的done（eventfd可读时在事件循环线程中调用）
+     * @return 本次执行的任务数
+     */
+    size_t runCompletions();
+
+    /**
+     * @brief 停止工作线程
+     *
+     * 尚未开始的任务被丢弃，已完成任务的done不再执行。正在执行的任务最多等待
+     * SHUTDOWN_TIMEOUT，仍未返回的线程（如卡在挂起的NFS上）被分离，进程退出时回收。
+     */
+    void shutdown();
+
+    /**
+     * @brief 获取任务统计
+     */
+    Stats getStats() const;
+
+  private:
+    /**
+     * @brief 一个任务，完成后作为完成栈的节点
+     */
+    struct Job {
+        std::function<void()> work; ///< 工作线程中执行的部分
+        std::function<void()> done; ///< 事件循环线程中执行的部分
+        Job *next = nullptr;        ///< 完成栈中的下一个节点
+    };
+
+    /**
+     * @brief 工作线程与线程池共享的状态
+     *
+     * 由shared_ptr持有，被分离的工作线程在线程池销毁后仍可安全访问。
+     */
+    struct Shared {
+        ~Shared(); // 关闭eventfd
+
+        std::mutex mutex;                     ///< 保护queue、stopping和running
+        std::condition_variable wake;         ///< 有新任务或要求停止
+        std::condition_variable exited;       ///< 有工作线程退出
+        std::deque<std::unique_ptr<Job>> queue; ///< 等待执行的任务
+        bool stopping = false;                ///< 是否要求停止
+        size_t running = 0;                   ///< 尚未退出的工作线程数
+        std::atomic<Job *> completed{nullptr}; ///< 已完成任务的无锁栈（后完成的在栈顶）
+        int event_fd = -1;                    ///< 完成通知的eventfd
+    };
+
+    /**
+     * @brief 工作线程主循环
+     */
+    static void workerLoop(std::shared_ptr<Shared> shared);
+
+    /**
+     * @brief 把完成的任务压入完成栈，栈原先为空时写eventfd
+     */
+    static void pushCompleted(Shared &shared, Job *job);
+
+    /**
+     * @brief 释放完成栈中的所有节点（不执行done）
+     */
+    static void discardCompleted(Shared &shared);
+
+    std::shared_ptr<Shared> shared_ = std::make_shared<Shared>(); ///< 共享状态
+    std::vector<std::thread> threads_;                            ///< 工作线程
+    Stats stats_;                                                 ///< 任务统计
+};
@@ -0,0 +1,600 @@
+#include <alsa_mixer.h>
+#include <system.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+namespace {
+
+// 播放/录音两个方向的ALSA简单元素操作表（参考alsa-utils的volume_mapping.c）
+struct SelemOps {
+    int (*has_switch)(snd_mixer_elem_t *);
+    int (*get_switch)(snd_mixer_elem_t *, snd_mixer_selem_channel_id_t, int *);
+    int (*set_switch_all)(snd_mixer_elem_t *, int);
+    int (*get_raw_range)(snd_mixer_elem_t *, long *, long *);
+    int (*get_raw)(snd_mixer_elem_t *, snd_mixer_selem_channel_id_t, long *);
+    int (*set_raw_all)(snd_mixer_elem_t *, long);
+    int (*get_dB_range)(snd_mixer_elem_t *, long *, long *);
+    int (*get_dB)(snd_mixer_elem_t *, snd_mixer_selem_channel_id_t, long *);
+    int (*set_dB_all)(snd_mixer_elem_t *, long, int);
+};
+
+constexpr SelemOps PLAYBACK_OPS = {
+    .has_switch = snd_mixer_selem_has_playback_switch,
+    .get_switch = snd_mixer_selem_get_playback_switch,
+    .set_switch_all = snd_mixer_selem_set_playback_switch_all,
+    .get_raw_range = snd_mixer_selem_get_playback_volume_range,
+    .get_raw = snd_mixer_selem_get_playback_volume,
+    .set_raw_all = snd_mixer_selem_set_playback_volume_all,
+    .get_dB_range = snd_mixer_selem_get_playback_dB_range,
+    .get_dB = snd_mixer_selem_get_playback_dB,
+    .set_dB_all = snd_mixer_selem_set_playback_dB_all,
+};
+
+constexpr SelemOps CAPTURE_OPS = {
+    .has_switch = snd_mixer_selem_has_capture_switch,
+    .get_switch = snd_mixer_selem_get_capture_switch,
+    .set_switch_all = snd_mixer_selem_set_capture_switch_all,
+    .get_raw_range = snd_mixer_selem_get_capture_volume_range,
+    .get_raw = snd_mixer_selem_get_capture_volume,
+    .set_raw_all = snd_mixer_selem_set_capture_volume_all,
+    .get_dB_range = snd_mixer_selem_get_capture_dB_range,
+    .get_dB = snd_mixer_selem_get_capture_dB,
+    .set_dB_all = snd_mixer_selem_set_capture_dB_all,
+};
+
+// dB范围不超过该值时按dB线性映射，否则按听感（指数）映射
+constexpr long MAX_LINEAR_DB_SCALE = 24;
+
+// 声卡控制设备所在目录
+constexpr const char *SOUND_DEVICE_DIR = "/dev/snd";
+
+bool useLinearDbScale(long db_min, long db_max) {
+    return db_max - db_min <= MAX_LINEAR_DB_SCALE * 100;
+}
+
+// 按方向取整，保证每一步至少改变一个单位
+long roundDirectional(double value, int dir) {
+    if (dir > 0) {
+        return static_cast<long>(std::ceil(value));
+    }
+    if (dir < 0) {
+        return static_cast<long>(std::floor(value));
+    }
+    return std::lround(value);
+}
+
+// 读取归一化音量（0.0～1.0），与alsamixer的映射一致
+double getNormalizedVolume(snd_mixer_elem_t *elem, const SelemOps &ops) {
+    long min = 0, max = 0, value = 0;
+
+    if (ops.get_dB_range(elem, &min, &max) < 0 || min >= max) {
+        if (ops.get_raw_range(elem, &min, &max) < 0 || min == max) {
+            return 0.0;
+        }
+        ops.get_raw(elem, SND_MIXER_SCHN_FRONT_LEFT, &value);
+        return static_cast<double>(value - min) / static_cast<double>(max - min);
+    }
+
+    if (ops.get_dB(elem, SND_MIXER_SCHN_FRONT_LEFT, &value) < 0) {
+        return 0.0;
+    }
+
+    if (useLinearDbScale(min, max)) {
+        return static_cast<double>(value - min) / static_cast<double>(max - min);
+    }
+
+    double normalized = std::pow(10.0, static_cast<double>(value - max) / 6000.0);
+    if (min != SND_CTL_TLV_DB_GAIN_MUTE) {
+        const double min_norm = std::pow(10.0, static_cast<double>(min - max) / 6000.0);
+        normalized = (normalized - min_norm) / (1 - min_norm);
+    }
+    return normalized;
+}
+
+// 写入归一化音量（0.0～1.0）到所有声道
+int setNormalizedVolume(snd_mixer_elem_t *elem, const SelemOps &ops, double volume, int dir) {
+    long min = 0, max = 0;
+
+    if (ops.get_dB_range(elem, &min, &max) < 0 || min >= max) {
+        if (ops.get_raw_range(elem, &min, &max) < 0) {
+            return -EINVAL;
+        }
+        const long value = roundDirectional(volume * static_cast<double>(max - min), dir) + min;
+        return ops.set_raw_all(elem, std::clamp(value, min, max));
+    }
+
+    if (useLinearDbScale(min, max)) {
+        const long value = roundDirectional(volume * static_cast<double>(max - min), dir) + min;
+        return ops.set_dB_all(elem, value, dir);
+    }
+
+    if (min != SND_CTL_TLV_DB_GAIN_MUTE) {
+        const double min_norm = std::pow(10.0, static_cast<double>(min - max) / 6000.0);
+        volume = volume * (1 - min_norm) + min_norm;
+    }
+    if (volume <= 0.0) {
+        return ops.set_dB_all(elem, min, dir);
+    }
+    const long value = roundDirectional(6000.0 * std::log10(volume), dir) + max;
+    return ops.set_dB_all(elem, value, dir);
+}
+
+// 按声卡名称索引的共享连接，不延长连接的生命周期
+std::map<std::string, std::weak_ptr<AlsaMixerHub>> &hubRegistry() {
+    static std::map<std::string, std::weak_ptr<AlsaMixerHub>> registry;
+    return registry;
+}
+
+using MixerHandle = std::unique_ptr<snd_mixer_t, decltype(&snd_mixer_close)>;
+
+// 工作线程中预先加载、尚未被接管的句柄
+struct PreloadedMixers {
+    std::mutex mutex;                           ///< 保护handles，加载期间一直持有
+    std::map<std::string, MixerHandle> handles; ///< 声卡名称→句柄
+};
+
+PreloadedMixers &preloadedMixers() {
+    static PreloadedMixers preloaded;
+    return preloaded;
+}
+
+// 查找索引为0的简单元素
+snd_mixer_elem_t *findSimpleElement(snd_mixer_t *handle, const std::string &name) {
+    snd_mixer_selem_id_t *sid;
+    snd_mixer_selem_id_alloca(&sid);
+    snd_mixer_selem_id_set_index(sid, 0);
+    snd_mixer_selem_id_set_name(sid, name.c_str());
+    return snd_mixer_find_selem(handle, sid);
+}
+
+} // namespace
+
+std::shared_ptr<AlsaMixerHub> AlsaMixerHub::acquire(System &system, const std::string &card) {
+    auto &registry = hubRegistry();
+    if (auto hub = registry[card].lock()) {
+        return hub;
+    }
+
+    // 构造函数为私有，不能使用make_shared
+    std::shared_ptr<AlsaMixerHub> hub(new AlsaMixerHub(system, card));
+    registry[card] = hub;
+    return hub;
+}
+
+void AlsaMixerHub::preload(const std::string &card) {
+    PreloadedMixers &preloaded = preloadedMixers();
+
+    // 加载期间持有锁，同时预先加载同一声卡的其它线程等待后直接返回
+    std::lock_guard<std::mutex> lock(preloaded.mutex);
+    if (preloaded.handles.count(card)) {
+        return;
+    }
+
+    snd_mixer_t *raw_handle = nullptr;
+    int err;
+    if ((err = snd_mixer_open(&raw_handle, 0)) < 0) {
+        std::cerr << "无法预先打开混音器 " << card << ": " << snd_strerror(err) << std::endl;
+        return;
+    }
+
+    MixerHandle handle(raw_handle, &snd_mixer_close);
+    if ((err = snd_mixer_attach(raw_handle, card.c_str())) < 0 ||
+        (err = snd_mixer_selem_register(raw_handle, nullptr, nullptr)) < 0 ||
+        (err = snd_mixer_load(raw_handle)) < 0) {
+        std::cerr << "混音器 " << card << " 预先加载失败: " << snd_strerror(err) << std::endl;
+        return;
+    }
+
+    preloaded.handles.emplace(card, std::move(handle));
+}
+
+snd_mixer_t *AlsaMixerHub::takePreloaded(const std::string &card) {
+    PreloadedMixers &preloaded = preloadedMixers();
+    std::lock_guard<std::mutex> lock(preloaded.mutex);
+
+    const auto it = preloaded.handles.find(card);
+    if (it == preloaded.handles.end()) {
+        return nullptr;
+    }
+    snd_mixer_t *handle = it->second.release();
+    preloaded.handles.erase(it);
+    return handle;
+}
+
+void AlsaMixerHub::releasePreloaded() {
+    PreloadedMixers &preloaded = preloadedMixers();
+    std::lock_guard<std::mutex> lock(preloaded.mutex);
+
+    for (const auto &[card, handle] : preloaded.handles) {
+        std::cerr << "关闭未被使用的预加载混音器 " << card << std::endl;
+    }
+    preloaded.handles.clear();
+}
+
+AlsaMixerHub::AlsaMixerHub(System &system, const std::string &card)
+    : system_(system), card_(card), handle_(nullptr, &snd_mixer_close) {
+    watchDevices();
+    open();
+}
+
+AlsaMixerHub::~AlsaMixerHub() {
+    close();
+
+    if (inotify_fd_ != -1) {
+        system_.unwatchFd(inotify_fd_);
+        ::close(inotify_fd_);
+    }
+}
+
+void AlsaMixerHub::subscribe(const std::string &element, MixerElementListener *listener) {
+    Subscription *subscription = findSubscription(element);
+    if (!subscription) {
+        subscriptions_.push_back(std::make_unique<Subscription>());
+        subscription = subscriptions_.back().get();
+        subscription->name = element;
+
+        // 连接已经打开时立即查找并绑定元素
+        if (handle_) {
+            snd_mixer_elem_t *elem = findSimpleElement(handle_.get(), element);
+            if (elem) {
+                bindElement(elem);
+            } else {
+                std::cerr << "未找到 " << element << " 控制元素" << std::endl;
+            }
+        }
+    }
+
+    if (std::find(subscription->listeners.begin(), subscription->listeners.end(), listener) ==
+        subscription->listeners.end()) {
+        subscription->listeners.push_back(listener);
+    }
+}
+
+void AlsaMixerHub::unsubscribe(const std::string &element, MixerElementListener *listener) {
+    Subscription *subscription = findSubscription(element);
+    if (!subscription) {
+        return;
+    }
+
+    auto &listeners = subscription->listeners;
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+bool AlsaMixerHub::hasElement(const std::string &element) const {
+    return findElement(element) != nullptr;
+}
+
+std::optional<int64_t> AlsaMixerHub::getVolume(const std::string &element, bool capture) const {
+    snd_mixer_elem_t *elem = findElement(element);
+    if (!elem) {
+        return std::nullopt;
+    }
+
+    const SelemOps &ops = capture ? CAPTURE_OPS : PLAYBACK_OPS;
+
+    int unmuted = 1;
+    if (ops.has_switch(elem)) {
+        ops.get_switch(elem, SND_MIXER_SCHN_FRONT_LEFT, &unmuted);
+    }
+
+    if (!unmuted) {
+        return -1; // 静音
+    }
+
+    return std::lround(getNormalizedVolume(elem, ops) * 100.0);
+}
+
+bool AlsaMixerHub::changeVolume(const std::string &element, bool capture, int64_t delta_percent) {
+    snd_mixer_elem_t *elem = findElement(element);
+    if (!elem || delta_percent == 0) {
+        return false;
+    }
+
+    const SelemOps &ops = capture ? CAPTURE_OPS : PLAYBACK_OPS;
+    const double current = getNormalizedVolume(elem, ops);
+    const double target =
+        std::clamp(current + static_cast<double>(delta_percent) / 100.0, 0.0, 1.0);
+
+    const int err = setNormalizedVolume(elem, ops, target, delta_percent > 0 ? 1 : -1);
+    if (err < 0) {
+        std::cerr << element << ": 设置音量失败: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool AlsaMixerHub::toggleMute(const std::string &element, bool capture) {
+    snd_mixer_elem_t *elem = findElement(element);
+    if (!elem) {
+        return false;
+    }
+
+    const SelemOps &ops = capture ? CAPTURE_OPS : PLAYBACK_OPS;
+    if (!ops.has_switch(elem)) {
+        return false;
+    }
+
+    int unmuted = 1;
+    ops.get_switch(elem, SND_MIXER_SCHN_FRONT_LEFT, &unmuted);
+    const int err = ops.set_switch_all(elem, !unmuted);
+    if (err < 0) {
+        std::cerr << element << ": 切换静音失败: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool AlsaMixerHub::open() {
+    snd_mixer_t *raw_handle = takePreloaded(card_);
+    int err;
+
+    if (raw_handle) {
+        // 接管预先加载的句柄，加载期间出现的元素没有经过mixerCallback，按订阅逐个绑定
+        handle_.reset(raw_handle);
+        snd_mixer_set_callback(raw_handle, &AlsaMixerHub::mixerCallback);
+        snd_mixer_set_callback_private(raw_handle, this);
+        for (const auto &subscription : subscriptions_) {
+            if (snd_mixer_elem_t *elem = findSimpleElement(raw_handle, subscription->name)) {
+                bindElement(elem);
+            }
+        }
+    } else {
+        if ((err = snd_mixer_open(&raw_handle, 0)) < 0) {
+            std::cerr << "无法打开混音器: " << snd_strerror(err) << std::endl;
+            return false;
+        }
+
+        handle_.reset(raw_handle);
+
+        // 加载前设置回调，加载过程中出现的元素也通过mixerCallback绑定
+        snd_mixer_set_callback(raw_handle, &AlsaMixerHub::mixerCallback);
+        snd_mixer_set_callback_private(raw_handle, this);
+
+        loading_ = true;
+        if ((err = snd_mixer_attach(raw_handle, card_.c_str())) < 0 ||
+            (err = snd_mixer_selem_register(raw_handle, nullptr, nullptr)) < 0 ||
+            (err = snd_mixer_load(raw_handle)) < 0) {
+            loading_ = false;
+            std::cerr << "混音器初始化失败: " << snd_strerror(err) << std::endl;
+            for (auto &subscription : subscriptions_) {
+                subscription->elem = nullptr;
+            }
+            handle_.reset();
+            return false;
+        }
+        loading_ = false;
+    }
+
+    // 注册全部poll描述符，而不仅是第一个
+    const int count = snd_mixer_poll_descriptors_count(raw_handle);
+    if (count > 0) {
+        poll_fds_.resize(static_cast<size_t>(count));
+        const int filled =
+            snd_mixer_poll_descriptors(raw_handle, poll_fds_.data(), static_cast<unsigned>(count));
+        poll_fds_.resize(static_cast<size_t>(std::max(filled, 0)));
+    }
+
+    for (const auto &pfd : poll_fds_) {
+        const int fd = pfd.fd;
+        uint32_t events = 0;
+        if (pfd.events & POLLIN) {
+            events |= EPOLLIN;
+        }
+        if (pfd.events & POLLOUT) {
+            events |= EPOLLOUT;
+        }
+        if (!system_.watchFd(fd, events, [this, fd](uint32_t revents) {
+                handleMixerEvents(fd, revents);
+            })) {
+            std::cerr << "混音器 " << card_ << ": 无法监听描述符 " << fd << std::endl;
+        }
+    }
+
+    std::cerr << "混音器 " << card_ << " 已打开，注册了 " << poll_fds_.size() << " 个描述符"
+              << std::endl;
+
+    // 通知已绑定元素的订阅者刷新显示
+    for (const auto &subscription : subscriptions_) {
+        if (subscription->elem) {
+            notifyListeners(*subscription, true);
+        }
+    }
+
+    return true;
+}
+
+void AlsaMixerHub::close() {
+    if (!handle_) {
+        return;
+    }
+
+    for (const auto &pfd : poll_fds_) {
+        system_.unwatchFd(pfd.fd);
+    }
+    poll_fds_.clear();
+
+    // 先解除元素回调，关闭句柄时不再回调到订阅记录
+    for (const auto &subscription : subscriptions_) {
+        if (subscription->elem) {
+            snd_mixer_elem_set_callback(subscription->elem, nullptr);
+            snd_mixer_elem_set_callback_private(subscription->elem, nullptr);
+        }
+    }
+    handle_.reset();
+
+    for (const auto &subscription : subscriptions_) {
+        if (subscription->elem) {
+            subscription->elem = nullptr;
+            notifyListeners(*subscription, false);
+        }
+    }
+}
+
+void AlsaMixerHub::handleMixerEvents(int fd, uint32_t events) {
+    if (!handle_) {
+        return;
+    }
+
+    TraceSpan span(TraceKind::ALSA, static_cast<uint32_t>(fd));
+
+    // 按ALSA要求传回完整的描述符数组，只有触发事件的描述符带有revents
+    revents_fds_.assign(poll_fds_.begin(), poll_fds_.end());
+    for (auto &pfd : revents_fds_) {
+        pfd.revents = pfd.fd == fd ? static_cast<short>(events & 0xffff) : 0;
+    }
+
+    unsigned short revents = 0;
+    int err = snd_mixer_poll_descriptors_revents(
+        handle_.get(), revents_fds_.data(), static_cast<unsigned>(revents_fds_.size()), &revents
+    );
+    if (err < 0) {
+        revents = static_cast<unsigned short>(events & 0xffff);
+    }
+
+    if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+        std::cerr << "混音器 " << card_ << " 已断开，等待设备重新出现" << std::endl;
+        close();
+        return;
+    }
+
+    if (revents & POLLIN) {
+        // 元素回调在这里被调用，只有发生变化的元素的订阅者会被通知
+        err = snd_mixer_handle_events(handle_.get());
+        if (err < 0) {
+            std::cerr << "混音器 " << card_ << " 事件处理失败: " << snd_strerror(err)
+                      << std::endl;
+            close();
+        }
+    }
+}
+
+void AlsaMixerHub::watchDevices() {
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ == -1) {
+        std::cerr << "无法创建inotify: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    // 控制设备节点创建后udev才会修改权限，因此同时监听属性变化
+    if (inotify_add_watch(inotify_fd_, SOUND_DEVICE_DIR, IN_CREATE | IN_ATTRIB) == -1 ||
+        !system_.watchFd(inotify_fd_, EPOLLIN, [this](uint32_t) { handleDeviceEvents(); })) {
+        std::cerr << "无法监听 " << SOUND_DEVICE_DIR << ": " << strerror(errno) << std::endl;
+        ::close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+}
+
+void AlsaMixerHub::handleDeviceEvents() {
+    alignas(struct inotify_event) char buf[4096];
+    bool control_changed = false;
+
+    for (;;) {
+        const ssize_t n = read(inotify_fd_, buf, sizeof(buf));
+        if (n <= 0) {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < n;) {
+            const auto *event = reinterpret_cast<const struct inotify_event *>(buf + offset);
+            if (event->len > 0 && std::strncmp(event->name, "controlC", 8) == 0) {
+                control_changed = true;
+            }
+            offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+        }
+    }
+
+    // 连接断开期间出现了新的控制设备，尝试重新打开
+    if (control_changed && !handle_) {
+        open();
+    }
+}
+
+AlsaMixerHub::Subscription *AlsaMixerHub::bindElement(snd_mixer_elem_t *elem) {
+    const char *name = snd_mixer_selem_get_name(elem);
+    if (!name || snd_mixer_selem_get_index(elem) != 0) {
+        return nullptr;
+    }
+
+    Subscription *subscription = findSubscription(name);
+    if (!subscription) {
+        return nullptr;
+    }
+
+    subscription->elem = elem;
+    snd_mixer_elem_set_callback_private(elem, subscription);
+    snd_mixer_elem_set_callback(elem, &AlsaMixerHub::elementCallback);
+    return subscription;
+}
+
+void AlsaMixerHub::notifyListeners(const Subscription &subscription, bool available) {
+    // 复制一份订阅者列表，回调中可能取消订阅
+    const auto listeners = subscription.listeners;
+    for (MixerElementListener *listener : listeners) {
+        if (available) {
+            listener->onMixerElementChanged();
+        } else {
+            listener->onMixerElementLost();
+        }
+    }
+}
+
+AlsaMixerHub::Subscription *AlsaMixerHub::findSubscription(const std::string &element) const {
+    for (const auto &subscription : subscriptions_) {
+        if (subscription->name == element) {
+            return subscription.get();
+        }
+    }
+    return nullptr;
+}
+
+snd_mixer_elem_t *AlsaMixerHub::findElement(const std::string &element) const {
+    if (!handle_) {
+        return nullptr;
+    }
+    const Subscription *subscription = findSubscription(element);
+    return subscription ? subscription->elem : nullptr;
+}
+
+int AlsaMixerHub::mixerCallback(snd_mixer_t *mixer, unsigned int mask, snd_mixer_elem_t *elem) {
+    if (!(mask & SND_CTL_EVENT_MASK_ADD)) {
+        return 0;
+    }
+
+    auto *hub = static_cast<AlsaMixerHub *>(snd_mixer_get_callback_private(mixer));
+    if (!hub) {
+        return 0;
+    }
+
+    // 加载期间由open()统一通知，运行期间新出现的元素立即通知
+    Subscription *subscription = hub->bindElement(elem);
+    if (subscription && !hub->loading_) {
+        notifyListeners(*subscription, true);
+    }
+    return 0;
+}
+
+int AlsaMixerHub::elementCallback(snd_mixer_elem_t *elem, unsigned int mask) {
+    auto *subscription = static_cast<Subscription *>(snd_mixer_elem_get_callback_private(elem));
+    if (!subscription) {
+        return 0;
+    }
+
+    if (mask == SND_CTL_EVENT_MASK_REMOVE) {
+        subscription->elem = nullptr;
+        notifyListeners(*subscription, false);
+        return 0;
+    }
+
+    if (mask & (SND_CTL_EVENT_MASK_VALUE | SND_CTL_EVENT_MASK_INFO)) {
+        notifyListeners(*subscription, true);
+    }
+    return 0;
+}
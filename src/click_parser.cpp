@@ -0,0 +1,275 @@
+#include <click_parser.h>
+#include <charconv>
+
+namespace {
+
+// 对象内部的简单游标，只识别点击事件需要的JSON子集
+class Cursor {
+  public:
+    explicit Cursor(std::string_view text) : text_(text) {}
+
+    bool atEnd() const {
+        return pos_ >= text_.size();
+    }
+
+    char peek() const {
+        return atEnd() ? '\0' : text_[pos_];
+    }
+
+    void skipWhitespace() {
+        while (!atEnd() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' ||
+                            text_[pos_] == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (peek() != c) {
+            return false;
+        }
+        ++pos_;
+        return true;
+    }
+
+    // 读取字符串，返回引号之间的原始内容
+    bool readString(std::string_view &out) {
+        if (!consume('"')) {
+            return false;
+        }
+        const size_t start = pos_;
+        bool escape = false;
+        while (!atEnd()) {
+            const char c = text_[pos_++];
+            if (escape) {
+                escape = false;
+            } else if (c == '\\') {
+                escape = true;
+            } else if (c == '"') {
+                out = text_.substr(start, pos_ - 1 - start);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 读取数字、true/false/null等裸值
+    bool readScalar(std::string_view &out) {
+        skipWhitespace();
+        const size_t start = pos_;
+        while (!atEnd() && text_[pos_] != ',' && text_[pos_] != '}' && text_[pos_] != ']' &&
+               text_[pos_] != ' ' && text_[pos_] != '\n') {
+            ++pos_;
+        }
+        out = text_.substr(start, pos_ - start);
+        return !out.empty();
+    }
+
+    // 跳过任意值（包括嵌套的对象和数组）
+    bool skipValue() {
+        skipWhitespace();
+        const char c = peek();
+        if (c == '"') {
+            std::string_view ignored;
+            return readString(ignored);
+        }
+        if (c != '{' && c != '[') {
+            std::string_view ignored;
+            return readScalar(ignored);
+        }
+
+        int depth = 0;
+        bool in_string = false;
+        bool escape = false;
+        while (!atEnd()) {
+            const char ch = text_[pos_++];
+            if (in_string) {
+                if (escape) {
+                    escape = false;
+                } else if (ch == '\\') {
+                    escape = true;
+                } else if (ch == '"') {
+                    in_string = false;
+                }
+            } else if (ch == '"') {
+                in_string = true;
+            } else if (ch == '{' || ch == '[') {
+                ++depth;
+            } else if ((ch == '}' || ch == ']') && --depth == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    std::string_view text_;
+    size_t pos_ = 0;
+};
+
+uint32_t parseModifier(std::string_view name) {
+    if (name == "Shift")
+        return MODIFIER_SHIFT;
+    if (name == "Control")
+        return MODIFIER_CONTROL;
+    if (name == "Lock")
+        return MODIFIER_LOCK;
+    if (name == "Mod1")
+        return MODIFIER_MOD1;
+    if (name == "Mod2")
+        return MODIFIER_MOD2;
+    if (name == "Mod3")
+        return MODIFIER_MOD3;
+    if (name == "Mod4")
+        return MODIFIER_MOD4;
+    if (name == "Mod5")
+        return MODIFIER_MOD5;
+    return 0;
+}
+
+} // namespace
+
+ClickEventParser::ClickEventParser() {
+    buffer_.reserve(4096);
+}
+
+void ClickEventParser::append(const char *data, size_t size) {
+    // 丢弃已交付的前缀，未完成的对象移动到缓冲区开头
+    if (consumed_ > 0) {
+        buffer_.erase(0, consumed_);
+        scan_pos_ -= consumed_;
+        if (object_start_ != NO_OBJECT) {
+            object_start_ -= consumed_;
+        }
+        consumed_ = 0;
+    }
+
+    buffer_.append(data, size);
+}
+
+bool ClickEventParser::next(ClickEvent &event) {
+    while (scan_pos_ < buffer_.size()) {
+        const char c = buffer_[scan_pos_++];
+
+        // 对象之外：跳过数组的'['、分隔逗号和空白
+        if (object_start_ == NO_OBJECT) {
+            if (c == '{') {
+                object_start_ = scan_pos_ - 1;
+                depth_ = 1;
+                in_string_ = false;
+                escape_ = false;
+            } else {
+                consumed_ = scan_pos_;
+            }
+            continue;
+        }
+
+        if (in_string_) {
+            if (escape_) {
+                escape_ = false;
+            } else if (c == '\\') {
+                escape_ = true;
+            } else if (c == '"') {
+                in_string_ = false;
+            }
+            continue;
+        }
+
+        if (c == '"') {
+            in_string_ = true;
+        } else if (c == '{' || c == '[') {
+            ++depth_;
+        } else if ((c == '}' || c == ']') && --depth_ == 0) {
+            const std::string_view object(
+                buffer_.data() + object_start_, scan_pos_ - object_start_
+            );
+            object_start_ = NO_OBJECT;
+            consumed_ = scan_pos_;
+
+            if (parseObject(object, event)) {
+                return true;
+            }
+            ++dropped_;
+        }
+    }
+
+    // 对象尚未完整，检查是否超长
+    if (object_start_ != NO_OBJECT && scan_pos_ - object_start_ > MAX_OBJECT_SIZE) {
+        object_start_ = NO_OBJECT;
+        consumed_ = scan_pos_;
+        ++dropped_;
+    }
+
+    return false;
+}
+
+size_t ClickEventParser::pendingBytes() const {
+    return buffer_.size() - consumed_;
+}
+
+uint64_t ClickEventParser::droppedObjects() const {
+    return dropped_;
+}
+
+bool ClickEventParser::parseObject(std::string_view object, ClickEvent &event) {
+    event = ClickEvent{};
+
+    Cursor cursor(object);
+    if (!cursor.consume('{')) {
+        return false;
+    }
+    if (cursor.consume('}')) {
+        return false;
+    }
+
+    do {
+        std::string_view key;
+        if (!cursor.readString(key) || !cursor.consume(':')) {
+            return false;
+        }
+
+        cursor.skipWhitespace();
+        if (key == "name") {
+            if (!cursor.readString(event.name)) {
+                return false;
+            }
+        } else if (key == "instance") {
+            // instance通常是字符串，也兼容数字
+            const bool ok = cursor.peek() == '"' ? cursor.readString(event.instance)
+                                                 : cursor.readScalar(event.instance);
+            if (!ok) {
+                return false;
+            }
+        } else if (key == "button") {
+            std::string_view value;
+            if (!cursor.readScalar(value)) {
+                return false;
+            }
+            const auto [ptr, ec] =
+                std::from_chars(value.data(), value.data() + value.size(), event.button);
+            if (ec != std::errc() || ptr != value.data() + value.size()) {
+                return false;
+            }
+        } else if (key == "modifiers") {
+            if (!cursor.consume('[')) {
+                return false;
+            }
+            if (!cursor.consume(']')) {
+                do {
+                    std::string_view modifier;
+                    if (!cursor.readString(modifier)) {
+                        return false;
+                    }
+                    event.modifiers |= parseModifier(modifier);
+                } while (cursor.consume(','));
+                if (!cursor.consume(']')) {
+                    return false;
+                }
+            }
+        } else if (!cursor.skipValue()) {
+            return false;
+        }
+    } while (cursor.consume(','));
+
+    return cursor.consume('}') && event.button != 0;
+}
@@ -0,0 +1,390 @@
+#include <control.h>
+#include <system.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <charconv>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// 按空白拆分命令
+std::vector<std::string_view> tokenize(std::string_view line) {
+    std::vector<std::string_view> tokens;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r')) {
+            ++pos;
+        }
+        const size_t start = pos;
+        while (pos < line.size() && line[pos] != ' ' && line[pos] != '\t' && line[pos] != '\r') {
+            ++pos;
+        }
+        if (pos > start) {
+            tokens.push_back(line.substr(start, pos - start));
+        }
+    }
+    return tokens;
+}
+
+// 解析无符号整数，必须完整匹配
+bool parseNumber(std::string_view text, uint64_t &value) {
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+// 填充sockaddr_un，路径过长时返回false
+bool makeAddress(const std::string &path, struct sockaddr_un &addr) {
+    addr = {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// $XDG_RUNTIME_DIR未设置时使用的目录
+std::string fallbackDirectory() {
+    return "/tmp/seedstatus-" + std::to_string(getuid());
+}
+
+// 创建只有当前用户可访问的目录；目录已存在时确认它不是符号链接、属于当前用户且权限为0700，
+// 否则可能是其他用户预先放置的，在其中监听的套接字会被冒充
+bool makePrivateDirectory(const std::string &path) {
+    if (mkdir(path.c_str(), 0700) == -1 && errno != EEXIST) {
+        std::cerr << "Failed to create " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (lstat(path.c_str(), &st) == -1) {
+        std::cerr << "Failed to stat " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (!S_ISDIR(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 0077) != 0) {
+        std::cerr << "Refusing to use " << path
+                  << ": not a private directory owned by the current user" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+ControlServer::ControlServer(System &system) : system_(system) {}
+
+ControlServer::~ControlServer() {
+    // 只在System析构时调用，此时epoll实例可能已关闭，直接关闭描述符即可
+    for (const auto &[fd, buffer] : clients_) {
+        close(fd);
+    }
+
+    if (listen_fd_ != -1) {
+        close(listen_fd_);
+        unlink(path_.c_str());
+    }
+}
+
+std::string ControlServer::defaultPath() {
+    if (const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR"); runtime_dir && *runtime_dir) {
+        return std::string(runtime_dir) + "/seedstatus.sock";
+    }
+    return fallbackDirectory() + "/seedstatus.sock";
+}
+
+bool ControlServer::start(const std::string &path) {
+    const std::string socket_path = path.empty() ? defaultPath() : path;
+
+    // /tmp所有人可写，默认路径退回到/tmp时套接字放在私有目录中，其他用户无法抢先监听
+    if (const std::string directory = fallbackDirectory();
+        socket_path.starts_with(directory + '/') && !makePrivateDirectory(directory)) {
+        return false;
+    }
+
+    struct sockaddr_un addr;
+    if (!makeAddress(socket_path, addr)) {
+        std::cerr << "Control socket path too long: " << socket_path << std::endl;
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        std::cerr << "Failed to create control socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 检查是否有另一个实例正在监听
+    if (connect(fd, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr)) == 0 ||
+        errno == EAGAIN) {
+        std::cerr << "Control socket " << socket_path << " is in use by another instance"
+                  << std::endl;
+        close(fd);
+        return false;
+    }
+    close(fd);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        std::cerr << "Failed to create control socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 删除残留的套接字文件，只允许当前用户连接
+    unlink(socket_path.c_str());
+    const mode_t old_umask = umask(0077);
+    const int bound = bind(fd, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr));
+    umask(old_umask);
+
+    if (bound == -1 || listen(fd, static_cast<int>(MAX_CLIENTS)) == -1) {
+        std::cerr << "Failed to listen on " << socket_path << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    if (!system_.watchFd(fd, EPOLLIN, [this](uint32_t) { acceptClients(); })) {
+        close(fd);
+        unlink(socket_path.c_str());
+        return false;
+    }
+
+    listen_fd_ = fd;
+    path_ = socket_path;
+    std::cerr << "Control socket listening on " << path_ << std::endl;
+    return true;
+}
+
+void ControlServer::acceptClients() {
+    for (;;) {
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return; // EAGAIN或错误，等待下一次事件
+        }
+
+        if (clients_.size() >= MAX_CLIENTS) {
+            close(fd);
+            continue;
+        }
+
+        // 只接受当前用户的连接，套接字文件的权限之外再检查一次对端身份
+        struct ucred cred;
+        socklen_t cred_size = sizeof(cred);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_size) == -1 ||
+            cred.uid != getuid()) {
+            close(fd);
+            continue;
+        }
+
+        if (!system_.watchFd(fd, EPOLLIN | EPOLLRDHUP, [this, fd](uint32_t) { handleClient(fd); })) {
+            close(fd);
+            continue;
+        }
+        clients_.emplace(fd, std::string());
+    }
+}
+
+void ControlServer::handleClient(int fd) {
+    const auto it = clients_.find(fd);
+    if (it == clients_.end()) {
+        return;
+    }
+    std::string &buffer = it->second;
+
+    char buf[512];
+    bool closed = false;
+    for (;;) {
+        const ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            buffer.append(buf, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        closed = n == 0 || errno != EAGAIN;
+        break;
+    }
+
+    // 逐行执行命令并回复
+    std::string reply;
+    size_t start = 0;
+    for (size_t newline = buffer.find('\n'); newline != std::string::npos;
+         newline = buffer.find('\n', start)) {
+        reply += execute(std::string_view(buffer).substr(start, newline - start));
+        reply += '\n';
+        start = newline + 1;
+    }
+    buffer.erase(0, start);
+
+    // 连接关闭时执行最后一个没有换行符的命令
+    if (closed && !buffer.empty()) {
+        reply += execute(buffer);
+        reply += '\n';
+        buffer.clear();
+    }
+
+    if (buffer.size() > MAX_LINE_SIZE) {
+        reply += "error line too long\n";
+        closed = true;
+    }
+
+    // 回复很短，一次写不完说明客户端没有读取，直接丢弃
+    if (!reply.empty() && write(fd, reply.data(), reply.size()) == -1 && errno != EPIPE) {
+        std::cerr << "Control socket write failed: " << strerror(errno) << std::endl;
+    }
+
+    if (closed) {
+        closeClient(fd);
+    }
+}
+
+void ControlServer::closeClient(int fd) {
+    system_.unwatchFd(fd);
+    close(fd);
+    clients_.erase(fd);
+}
+
+std::vector<uint32_t> ControlServer::resolveModules(std::string_view selector) const {
+    std::vector<uint32_t> ids;
+    const auto &modules = system_.getModuleManager().getModules();
+
+    uint64_t id = 0;
+    if (parseNumber(selector, id)) {
+        if (id < modules.size() && modules[id]) {
+            ids.push_back(static_cast<uint32_t>(id));
+        }
+        return ids;
+    }
+
+    for (size_t i = 0; i < modules.size(); ++i) {
+        if (modules[i] && (selector == "all" || modules[i]->getName() == selector)) {
+            ids.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    return ids;
+}
+
+std::string ControlServer::execute(std::string_view line) {
+    const std::vector<std::string_view> args = tokenize(line);
+    if (args.empty()) {
+        return "error empty command";
+    }
+
+    ModuleManager &manager = system_.getModuleManager();
+    const std::string_view command = args[0];
+
+    if (command == "list") {
+        std::string reply = "ok";
+        const auto &modules = manager.getModules();
+        for (size_t i = 0; i < modules.size(); ++i) {
+            if (modules[i]) {
+                reply += ' ' + std::to_string(i) + ':' + modules[i]->getName() + ':' +
+                         std::to_string(modules[i]->getInterval()) + ':' +
+                         std::to_string(modules[i]->getRefreshSignal());
+            }
+        }
+        return reply;
+    }
+
+    if (command == "output") {
+        const OutputWriter::Stats stats = system_.getOutputWriter().getStats();
+        return "ok submitted=" + std::to_string(stats.frames_submitted) +
+               " written=" + std::to_string(stats.frames_written) +
+               " dropped=" + std::to_string(stats.frames_dropped) +
+               " bytes=" + std::to_string(stats.bytes_written) +
+               " stalls=" + std::to_string(stats.stalls) +
+               " pending=" + std::to_string(stats.pending_bytes);
+    }
+
+    if (command == "render") {
+        std::string reply = "ok";
+        const auto &modules = manager.getModules();
+        for (size_t i = 0; i < modules.size(); ++i) {
+            if (modules[i]) {
+                const Module::RenderStats &stats = modules[i]->getRenderStats();
+                reply += ' ' + std::to_string(i) + ':' + modules[i]->getName() + ':' +
+                         std::to_string(stats.hits) + ':' + std::to_string(stats.misses);
+            }
+        }
+        return reply;
+    }
+
+    if (command == "stats") {
+        return "ok " + system_.getTelemetry().summary(manager);
+    }
+
+    if (command == "trace") {
+        if (!Trace::isEnabled()) {
+            return "error tracing disabled";
+        }
+        if (!system_.flushTrace()) {
+            return "error failed to write " + Trace::getPath();
+        }
+        return "ok " + Trace::getPath();
+    }
+
+    if (command == "budget" && args.size() == 1) {
+        std::string reply = "ok";
+        const auto &modules = manager.getModules();
+        for (size_t i = 0; i < modules.size(); ++i) {
+            if (modules[i]) {
+                const auto stats = manager.getBudgetStats(static_cast<ModuleId>(i));
+                reply += ' ' + std::to_string(i) + ':' + modules[i]->getName() + ':' +
+                         std::to_string(stats.budget.count()) + ':' +
+                         std::to_string(stats.overruns) + ':' +
+                         std::to_string(stats.max_ns / 1000000) + ':' +
+                         std::to_string(unsigned{stats.slowdown}) + ':' + (stats.quarantined ? '1' : '0');
+            }
+        }
+        return reply;
+    }
+
+    const bool known = command == "refresh" || command == "set-state" || command == "click" ||
+                       command == "interval" || command == "budget";
+    if (!known) {
+        return "error unknown command " + std::string(command);
+    }
+
+    const size_t expected_args = command == "refresh" ? 2 : 3;
+    if (args.size() != expected_args) {
+        return "error usage: " + std::string(command) +
+               (expected_args == 2 ? " <module>" : " <module> <n>");
+    }
+
+    uint64_t value = 0;
+    if (expected_args == 3 && !parseNumber(args[2], value)) {
+        return "error invalid number " + std::string(args[2]);
+    }
+
+    const std::vector<uint32_t> ids = resolveModules(args[1]);
+    if (ids.empty()) {
+        return "error no such module " + std::string(args[1]);
+    }
+
+    const auto &modules = manager.getModules();
+    for (const uint32_t id : ids) {
+        if (command == "refresh") {
+            manager.refreshModule(id);
+        } else if (command == "set-state") {
+            modules[id]->setState(value);
+            manager.refreshModule(id);
+        } else if (command == "click") {
+            manager.dispatchClick(id, value);
+        } else if (command == "budget") {
+            modules[id]->setUpdateBudget(std::chrono::milliseconds(value));
+            manager.resetBudget(id);
+        } else {
+            modules[id]->setInterval(value);
+        }
+    }
+
+    return "ok " + std::to_string(ids.size());
+}
@@ -0,0 +1,380 @@
+#include <escape.h>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define SEEDSTATUS_ESCAPE_SSE2 1
+#if defined(__GNUC__)
+#define SEEDSTATUS_ESCAPE_AVX2 1
+#endif
+#endif
+
+namespace {
+
+// 非法UTF-8字节的替代字符（U+FFFD）
+constexpr std::string_view REPLACEMENT_CHARACTER = "\xEF\xBF\xBD";
+
+// 以text[pos]开头的合法UTF-8序列长度，非法时返回0
+size_t utf8SequenceLength(std::string_view text, size_t pos) {
+    const auto lead = static_cast<unsigned char>(text[pos]);
+    size_t length;
+    uint32_t cp;
+    if (lead < 0x80) {
+        return 1;
+    } else if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        cp = lead & 0x1Fu;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        cp = lead & 0x0Fu;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        cp = lead & 0x07u;
+    } else {
+        return 0;
+    }
+
+    if (pos + length > text.size()) {
+        return 0;
+    }
+    for (size_t i = 1; i < length; ++i) {
+        const auto byte = static_cast<unsigned char>(text[pos + i]);
+        if ((byte & 0xC0) != 0x80) {
+            return 0;
+        }
+        cp = (cp << 6) | (byte & 0x3Fu);
+    }
+
+    // 拒绝过长编码、代理项和超出范围的码点
+    static constexpr uint32_t MIN_CODE_POINT[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (cp < MIN_CODE_POINT[length] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        return 0;
+    }
+    return length;
+}
+
+// JSON中需要逐字节处理的字节：控制字符、"、\、DEL和所有非ASCII字节
+inline bool isJsonSpecial(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\' || c >= 0x7F;
+}
+
+// 处理text[pos]处的一个JSON特殊字节，返回消耗的字节数
+size_t escapeJsonAt(std::string_view text, size_t pos, std::string &out) {
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    const auto c = static_cast<unsigned char>(text[pos]);
+    if (c >= 0x80) {
+        // 连续的非ASCII字符（如相邻的字形）一次校验、一次拷贝
+        size_t end = pos;
+        while (end < text.size() && static_cast<unsigned char>(text[end]) >= 0x80) {
+            const size_t length = utf8SequenceLength(text, end);
+            if (length == 0) {
+                break;
+            }
+            end += length;
+        }
+        if (end == pos) {
+            out += REPLACEMENT_CHARACTER;
+            return 1;
+        }
+        out.append(text, pos, end - pos);
+        return end - pos;
+    }
+
+    switch (c) {
+    case '"':
+        out += "\\\"";
+        break;
+    case '\\':
+        out += "\\\\";
+        break;
+    case '\n':
+        out += "\\n";
+        break;
+    case '\t':
+        out += "\\t";
+        break;
+    default:
+        out += "\\u00";
+        out += HEX[c >> 4];
+        out += HEX[c & 0x0F];
+        break;
+    }
+    return 1;
+}
+
+// Pango中需要逐字节处理的字节：五个标记字符和除\t外的控制字符
+inline bool isPangoSpecial(unsigned char c) {
+    return c == '&' || c == '<' || c == '>' || c == '\'' || c == '"' || (c < 0x20 && c != '\t');
+}
+
+// 处理text[pos]处的一个Pango特殊字节，返回消耗的字节数（总是1）
+size_t escapePangoAt(std::string_view text, size_t pos, std::string &out) {
+    switch (text[pos]) {
+    case '&':
+        out += "&amp;";
+        break;
+    case '<':
+        out += "&lt;";
+        break;
+    case '>':
+        out += "&gt;";
+        break;
+    case '\'':
+        out += "&apos;";
+        break;
+    case '"':
+        out += "&quot;";
+        break;
+    default:
+        break; // 控制字符直接去掉
+    }
+    return 1;
+}
+
+/**
+ * 从pos开始逐字节处理剩余文本，也是标量实现本身
+ *
+ * copied之前的文本已经写入out，[copied, pos)是尚未拷贝的普通字节。
+ */
+template <bool (*IsSpecial)(unsigned char),
+          size_t (*EscapeAt)(std::string_view, size_t, std::string &)>
+void finishScalar(std::string_view text, size_t pos, size_t copied, std::string &out) {
+    while (pos < text.size()) {
+        if (!IsSpecial(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+            continue;
+        }
+        out.append(text.data() + copied, pos - copied);
+        pos += EscapeAt(text, pos, out);
+        copied = pos;
+    }
+    out.append(text.data() + copied, text.size() - copied);
+}
+
+#if SEEDSTATUS_ESCAPE_SSE2
+
+void appendJsonSse2(std::string_view text, std::string &out) {
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i del = _mm_set1_epi8(0x7F);
+
+    size_t pos = 0;
+    size_t copied = 0;
+    while (pos + 16 <= text.size()) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + pos));
+        // 有符号比较：非ASCII字节为负数，和控制字符一起落在"小于0x20"中
+        const __m128i special =
+            _mm_or_si128(_mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpeq_epi8(v, quote)),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, backslash), _mm_cmpeq_epi8(v, del)));
+        const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+        if (mask == 0) {
+            pos += 16;
+            continue;
+        }
+        pos += static_cast<size_t>(__builtin_ctz(mask));
+        out.append(text.data() + copied, pos - copied);
+        pos += escapeJsonAt(text, pos, out);
+        copied = pos;
+    }
+    finishScalar<isJsonSpecial, escapeJsonAt>(text, pos, copied, out);
+}
+
+void appendPangoSse2(std::string_view text, std::string &out) {
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i apos = _mm_set1_epi8('\'');
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i max_control = _mm_set1_epi8(0x1F);
+
+    size_t pos = 0;
+    size_t copied = 0;
+    while (pos + 16 <= text.size()) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + pos));
+        // 无符号比较：min(v, 0x1F) == v 即 v <= 0x1F，\t在命中后由标量代码放行
+        const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(v, max_control), v);
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, lt)),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, gt), _mm_cmpeq_epi8(v, apos))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, quot), control));
+        const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+        if (mask == 0) {
+            pos += 16;
+            continue;
+        }
+        pos += static_cast<size_t>(__builtin_ctz(mask));
+        if (text[pos] == '\t') {
+            ++pos;
+            continue;
+        }
+        out.append(text.data() + copied, pos - copied);
+        pos += escapePangoAt(text, pos, out);
+        copied = pos;
+    }
+    finishScalar<isPangoSpecial, escapePangoAt>(text, pos, copied, out);
+}
+
+#endif
+
+#if SEEDSTATUS_ESCAPE_AVX2
+
+__attribute__((target("avx2"))) void appendJsonAvx2(std::string_view text, std::string &out) {
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i del = _mm256_set1_epi8(0x7F);
+
+    size_t pos = 0;
+    size_t copied = 0;
+    while (pos + 32 <= text.size()) {
+        const __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text.data() + pos));
+        const __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi8(space, v), _mm256_cmpeq_epi8(v, quote)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, backslash), _mm256_cmpeq_epi8(v, del)));
+        const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+        if (mask == 0) {
+            pos += 32;
+            continue;
+        }
+        pos += static_cast<size_t>(__builtin_ctz(mask));
+        out.append(text.data() + copied, pos - copied);
+        pos += escapeJsonAt(text, pos, out);
+        copied = pos;
+    }
+    finishScalar<isJsonSpecial, escapeJsonAt>(text, pos, copied, out);
+}
+
+__attribute__((target("avx2"))) void appendPangoAvx2(std::string_view text, std::string &out) {
+    const __m256i amp = _mm256_set1_epi8('&');
+    const __m256i lt = _mm256_set1_epi8('<');
+    const __m256i gt = _mm256_set1_epi8('>');
+    const __m256i apos = _mm256_set1_epi8('\'');
+    const __m256i quot = _mm256_set1_epi8('"');
+    const __m256i max_control = _mm256_set1_epi8(0x1F);
+
+    size_t pos = 0;
+    size_t copied = 0;
+    while (pos + 32 <= text.size()) {
+        const __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text.data() + pos));
+        const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(v, max_control), v);
+        const __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, amp), _mm256_cmpeq_epi8(v, lt)),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(v, gt), _mm256_cmpeq_epi8(v, apos))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quot), control));
+        const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+        if (mask == 0) {
+            pos += 32;
+            continue;
+        }
+        pos += static_cast<size_t>(__builtin_ctz(mask));
+        if (text[pos] == '\t') {
+            ++pos;
+            continue;
+        }
+        out.append(text.data() + copied, pos - copied);
+        pos += escapePangoAt(text, pos, out);
+        copied = pos;
+    }
+    finishScalar<isPangoSpecial, escapePangoAt>(text, pos, copied, out);
+}
+
+#endif
+
+// 把请求的实现限制在CPU支持的范围内
+EscapeIsa clampIsa(EscapeIsa isa) {
+    const EscapeIsa best = bestEscapeIsa();
+    return static_cast<int>(isa) > static_cast<int>(best) ? best : isa;
+}
+
+} // namespace
+
+EscapeIsa bestEscapeIsa() {
+    static const EscapeIsa best = [] {
+#if SEEDSTATUS_ESCAPE_AVX2
+        if (__builtin_cpu_supports("avx2")) {
+            return EscapeIsa::AVX2;
+        }
+#endif
+#if SEEDSTATUS_ESCAPE_SSE2
+        return EscapeIsa::SSE2;
+#else
+        return EscapeIsa::SCALAR;
+#endif
+    }();
+    return best;
+}
+
+const char *escapeIsaName(EscapeIsa isa) {
+    switch (isa) {
+    case EscapeIsa::SCALAR:
+        return "scalar";
+    case EscapeIsa::SSE2:
+        return "sse2";
+    case EscapeIsa::AVX2:
+        return "avx2";
+    default:
+        return "unknown";
+    }
+}
+
+void appendJsonEscaped(std::string_view text, std::string &out) {
+    appendJsonEscaped(text, out, bestEscapeIsa());
+}
+
+void appendJsonEscaped(std::string_view text, std::string &out, EscapeIsa isa) {
+    // clampIsa()保证不会落到未编译的实现上
+    switch (clampIsa(isa)) {
+    case EscapeIsa::AVX2:
+#if SEEDSTATUS_ESCAPE_AVX2
+        appendJsonAvx2(text, out);
+        return;
+#endif
+        [[fallthrough]];
+    case EscapeIsa::SSE2:
+#if SEEDSTATUS_ESCAPE_SSE2
+        appendJsonSse2(text, out);
+        return;
+#endif
+        [[fallthrough]];
+    case EscapeIsa::SCALAR:
+    default:
+        finishScalar<isJsonSpecial, escapeJsonAt>(text, 0, 0, out);
+        return;
+    }
+}
+
+void appendPangoEscaped(std::string_view text, std::string &out) {
+    appendPangoEscaped(text, out, bestEscapeIsa());
+}
+
+void appendPangoEscaped(std::string_view text, std::string &out, EscapeIsa isa) {
+    // clampIsa()保证不会落到未编译的实现上
+    switch (clampIsa(isa)) {
+    case EscapeIsa::AVX2:
+#if SEEDSTATUS_ESCAPE_AVX2
+        appendPangoAvx2(text, out);
+        return;
+#endif
+        [[fallthrough]];
+    case EscapeIsa::SSE2:
+#if SEEDSTATUS_ESCAPE_SSE2
+        appendPangoSse2(text, out);
+        return;
+#endif
+        [[fallthrough]];
+    case EscapeIsa::SCALAR:
+    default:
+        finishScalar<isPangoSpecial, escapePangoAt>(text, 0, 0, out);
+        return;
+    }
+}
+
+std::string escapePango(std::string_view text) {
+    std::string escaped;
+    appendPangoEscaped(text, escaped);
+    return escaped;
+}
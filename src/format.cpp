@@ -0,0 +1,306 @@
+#include <format.h>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// 向缓冲区写入的游标，空间不足时截断并记录
+struct Cursor {
+    char *pos;
+    char *end;
+    bool truncated = false;
+
+    void append(const char *data, size_t length) {
+        const size_t room = static_cast<size_t>(end - pos);
+        if (length > room) {
+            length = room;
+            truncated = true;
+        }
+        std::memcpy(pos, data, length);
+        pos += length;
+    }
+
+    void fill(char c, size_t count) {
+        const size_t room = static_cast<size_t>(end - pos);
+        if (count > room) {
+            count = room;
+            truncated = true;
+        }
+        std::memset(pos, c, count);
+        pos += count;
+    }
+};
+
+// 解析无符号十进制数，返回解析到的位置
+const char *parseDigits(const char *first, const char *last, unsigned &value) {
+    const auto [ptr, ec] = std::from_chars(first, last, value);
+    return ec == std::errc() ? ptr : first;
+}
+
+// 把[first, first+length)按宽度右对齐写入游标
+void appendPadded(Cursor &out, const char *first, size_t length, size_t width, bool zero_pad) {
+    if (length < width) {
+        // 负数用0填充时，符号必须在填充的0之前
+        if (zero_pad && length > 0 && *first == '-') {
+            out.append(first, 1);
+            out.fill('0', width - length);
+            out.append(first + 1, length - 1);
+            return;
+        }
+        out.fill(zero_pad ? '0' : ' ', width - length);
+    }
+    out.append(first, length);
+}
+
+// 按fixed格式输出浮点数，返回长度
+size_t toFixed(double value, int precision, char *first, char *last) {
+    const auto result = std::to_chars(first, last, value, std::chars_format::fixed, precision);
+    return result.ec == std::errc() ? static_cast<size_t>(result.ptr - first) : 0;
+}
+
+} // namespace
+
+FormatTemplate::FormatTemplate(std::string_view pattern, std::span<const std::string_view> fields) {
+    std::string literal;
+
+    auto flushLiteral = [&]() {
+        if (literal.empty()) {
+            return;
+        }
+        Op op;
+        op.literal = true;
+        op.offset = static_cast<uint32_t>(literals_.size());
+        op.length = static_cast<uint32_t>(literal.size());
+        literals_ += literal;
+        ops_.push_back(op);
+        literal.clear();
+    };
+
+    size_t pos = 0;
+    while (pos < pattern.size()) {
+        const char c = pattern[pos];
+
+        if (c == '}') {
+            if (pos + 1 < pattern.size() && pattern[pos + 1] == '}') {
+                literal += '}';
+                pos += 2;
+                continue;
+            }
+            throw std::invalid_argument("Unmatched '}' in format: " + std::string(pattern));
+        }
+
+        if (c != '{') {
+            literal += c;
+            ++pos;
+            continue;
+        }
+
+        if (pos + 1 < pattern.size() && pattern[pos + 1] == '{') {
+            literal += '{';
+            pos += 2;
+            continue;
+        }
+
+        const size_t close = pattern.find('}', pos);
+        if (close == std::string_view::npos) {
+            throw std::invalid_argument("Unterminated field in format: " + std::string(pattern));
+        }
+
+        const std::string_view body = pattern.substr(pos + 1, close - pos - 1);
+        const size_t colon = body.find(':');
+        const std::string_view name = body.substr(0, colon);
+
+        Op op;
+        const auto it = std::find(fields.begin(), fields.end(), name);
+        if (it == fields.end()) {
+            throw std::invalid_argument("Unknown field '" + std::string(name) +
+                                        "' in format: " + std::string(pattern));
+        }
+        op.field = static_cast<uint16_t>(it - fields.begin());
+        if (colon != std::string_view::npos) {
+            parseSpec(body.substr(colon + 1), op);
+        }
+
+        flushLiteral();
+        ops_.push_back(op);
+        pos = close + 1;
+    }
+    flushLiteral();
+}
+
+void FormatTemplate::parseSpec(std::string_view spec, Op &op) {
+    if (spec.empty()) {
+        return;
+    }
+    if (spec == "bytes") {
+        op.style = Style::BYTES;
+        return;
+    }
+
+    const char *pos = spec.data();
+    const char *last = spec.data() + spec.size();
+
+    if (*pos == '0') {
+        op.zero_pad = true;
+        ++pos;
+    }
+
+    unsigned width = 0;
+    pos = parseDigits(pos, last, width);
+
+    int precision = -1;
+    if (pos < last && *pos == '.') {
+        unsigned digits = 0;
+        const char *after = parseDigits(pos + 1, last, digits);
+        if (after == pos + 1) {
+            throw std::invalid_argument("Missing precision in format spec: " + std::string(spec));
+        }
+        precision = static_cast<int>(digits);
+        pos = after;
+    }
+
+    if (pos + 1 != last || width > 64 || precision > 17) {
+        throw std::invalid_argument("Invalid format spec: " + std::string(spec));
+    }
+
+    switch (*pos) {
+    case 'd':
+        op.style = Style::INTEGER;
+        break;
+    case 'f':
+        op.style = Style::FIXED;
+        break;
+    case 'a':
+        op.style = Style::ADAPTIVE;
+        break;
+    default:
+        throw std::invalid_argument("Invalid format spec: " + std::string(spec));
+    }
+
+    op.width = static_cast<uint8_t>(width);
+    op.precision = static_cast<int8_t>(precision);
+}
+
+std::string_view
+FormatTemplate::render(FormatBuffer &buffer, const FormatValue *values, size_t count) const {
+    Cursor out{buffer.data_, buffer.data_ + FormatBuffer::CAPACITY};
+    char scratch[64];
+
+    for (const Op &op : ops_) {
+        if (op.literal) {
+            out.append(literals_.data() + op.offset, op.length);
+            continue;
+        }
+        if (op.field >= count) {
+            continue;
+        }
+
+        const FormatValue &value = values[op.field];
+        if (value.type_ == FormatValue::Type::STRING) {
+            // 字符串左对齐
+            out.append(value.string_.data(), value.string_.size());
+            if (value.string_.size() < op.width) {
+                out.fill(' ', op.width - value.string_.size());
+            }
+            continue;
+        }
+
+        const double number = value.type_ == FormatValue::Type::DOUBLE ? value.double_
+                              : value.type_ == FormatValue::Type::SIGNED
+                                  ? static_cast<double>(value.signed_)
+                                  : static_cast<double>(value.unsigned_);
+
+        size_t length = 0;
+        switch (op.style) {
+        case Style::BYTES:
+            length = formatBytes(value.type_ == FormatValue::Type::UNSIGNED
+                                     ? value.unsigned_
+                                     : static_cast<uint64_t>(std::max(number, 0.0)),
+                                 scratch, scratch + sizeof(scratch));
+            break;
+        case Style::FIXED:
+            length = toFixed(number, op.precision < 0 ? 6 : op.precision, scratch,
+                             scratch + sizeof(scratch));
+            break;
+        case Style::ADAPTIVE:
+            length = toFixed(number, adaptiveDecimals(number, op.width, op.precision), scratch,
+                             scratch + sizeof(scratch));
+            break;
+        case Style::INTEGER:
+        case Style::DEFAULT:
+        default:
+            if (value.type_ == FormatValue::Type::SIGNED) {
+                length = static_cast<size_t>(
+                    std::to_chars(scratch, scratch + sizeof(scratch), value.signed_).ptr - scratch
+                );
+            } else if (value.type_ == FormatValue::Type::UNSIGNED) {
+                length = static_cast<size_t>(
+                    std::to_chars(scratch, scratch + sizeof(scratch), value.unsigned_).ptr -
+                    scratch
+                );
+            } else if (op.style == Style::INTEGER) {
+                length = toFixed(number, 0, scratch, scratch + sizeof(scratch));
+            } else {
+                length = static_cast<size_t>(
+                    std::to_chars(scratch, scratch + sizeof(scratch), number).ptr - scratch
+                );
+            }
+            break;
+        }
+
+        appendPadded(out, scratch, length, op.width, op.zero_pad);
+    }
+
+    buffer.size_ = static_cast<size_t>(out.pos - buffer.data_);
+    buffer.truncated_ = out.truncated;
+    return buffer.view();
+}
+
+int adaptiveDecimals(double value, unsigned width, int precision) {
+    // 从最多的小数位开始尝试，直到放进宽度为止
+    char scratch[64];
+    int decimals = precision >= 0 ? precision : std::max(static_cast<int>(width) - 2, 0);
+    for (; decimals > 0; --decimals) {
+        if (toFixed(value, decimals, scratch, scratch + sizeof(scratch)) <= width) {
+            break;
+        }
+    }
+    return decimals;
+}
+
+size_t formatBytes(uint64_t bytes, char *first, char *last) {
+    static constexpr char UNITS[] = "KMGTPE";
+    if (last - first < 5) {
+        return 0;
+    }
+
+    // 最小单位为K；按四舍五入后的值判断进位，避免出现"1000K"这样的6个字符
+    double size = static_cast<double>(bytes) / 1024.0;
+    size_t unit = 0;
+    while (size >= 999.5 && unit + 1 < sizeof(UNITS) - 1) {
+        size /= 1024.0;
+        ++unit;
+    }
+
+    char digits[32];
+    size_t length;
+    if (size >= 99.95) {
+        length = toFixed(size, 0, digits, digits + sizeof(digits));
+    } else if (size >= 9.995) {
+        length = toFixed(size, 1, digits, digits + sizeof(digits));
+    } else {
+        length = toFixed(size, 2, digits, digits + sizeof(digits));
+    }
+
+    // 数字部分右对齐到4个字符，再加单位
+    char *pos = first;
+    for (size_t i = length; i < 4; ++i) {
+        *pos++ = ' ';
+    }
+    std::memcpy(pos, digits, length);
+    pos += length;
+    *pos++ = UNITS[unit];
+    return static_cast<size_t>(pos - first);
+}
@@ -0,0 +1,308 @@
+#include <hardware.h>
+#include <alsa/asoundlib.h>
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// 缓存格式版本，HardwareProfile的字段变化时递增
+constexpr std::string_view CACHE_VERSION = "1";
+
+constexpr const char *BOOT_ID_PATH = "/proc/sys/kernel/random/boot_id";
+constexpr const char *POWERCAP_DIR = "/sys/class/powercap";
+constexpr const char *HWMON_DIR = "/sys/class/hwmon";
+constexpr const char *DRM_DIR = "/sys/class/drm";
+constexpr const char *BACKLIGHT_DIR = "/sys/class/backlight";
+constexpr const char *POWER_SUPPLY_DIR = "/sys/class/power_supply";
+
+// CPU温度传感器驱动，按优先级排列
+constexpr std::array<std::string_view, 5> CPU_TEMP_DRIVERS = {
+    "k10temp", "coretemp", "zenpower", "cpu_thermal", "acpitz"
+};
+
+// 背光接口类型，按优先级排列（与内核文档的建议一致）
+constexpr std::array<std::string_view, 3> BACKLIGHT_TYPES = {"firmware", "platform", "raw"};
+
+// 读取文件的第一行，失败时返回空字符串
+std::string readLine(const fs::path &path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// 文件是否可以打开读取（RAPL的energy_uj在较新的内核上只有root可读）
+bool isReadable(const fs::path &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    close(fd);
+    return true;
+}
+
+// 按名称排序列出目录中的条目，目录不存在时为空
+std::vector<fs::path> listDirectory(const char *dir) {
+    std::vector<fs::path> entries;
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator(dir, ec)) {
+        entries.push_back(entry.path());
+    }
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+std::string probeRapl() {
+    // 封装域是intel-rapl:N，子域intel-rapl:N:M只覆盖核心
+    for (const auto &zone : listDirectory(POWERCAP_DIR)) {
+        const std::string name = zone.filename().string();
+        if (name.rfind("intel-rapl:", 0) != 0 || name.find(':', 11) != std::string::npos) {
+            continue;
+        }
+        if (isReadable(zone / "energy_uj") && isReadable(zone / "max_energy_range_uj")) {
+            return zone.string();
+        }
+    }
+    return {};
+}
+
+std::string probeSvi2() {
+    for (const auto &hwmon : listDirectory(HWMON_DIR)) {
+        if (readLine(hwmon / "name") == "zenpower" && isReadable(hwmon / "power1_input") &&
+            isReadable(hwmon / "power2_input")) {
+            return hwmon.string();
+        }
+    }
+    return {};
+}
+
+std::string probeCpuTemp() {
+    const std::vector<fs::path> hwmons = listDirectory(HWMON_DIR);
+    for (const std::string_view driver : CPU_TEMP_DRIVERS) {
+        for (const auto &hwmon : hwmons) {
+            if (readLine(hwmon / "name") == driver && isReadable(hwmon / "temp1_input")) {
+                return (hwmon / "temp1_input").string();
+            }
+        }
+    }
+    return {};
+}
+
+std::string probeGpu() {
+    // 只看cardN，跳过cardN-DP-1之类的连接器
+    for (const auto &card : listDirectory(DRM_DIR)) {
+        const std::string name = card.filename().string();
+        if (name.rfind("card", 0) != 0 || name.find('-') != std::string::npos) {
+            continue;
+        }
+        const fs::path device = card / "device";
+        if (isReadable(device / "gpu_busy_percent") && isReadable(device / "mem_info_vram_used")) {
+            return device.string();
+        }
+    }
+    return {};
+}
+
+std::string probeBacklight() {
+    const std::vector<fs::path> devices = listDirectory(BACKLIGHT_DIR);
+    for (const std::string_view type : BACKLIGHT_TYPES) {
+        for (const auto &device : devices) {
+            if (readLine(device / "type") == type && isReadable(device / "brightness") &&
+                isReadable(device / "max_brightness")) {
+                return device.string();
+            }
+        }
+    }
+    return {};
+}
+
+bool probeBattery() {
+    // scope为Device的是鼠标、耳机等外设的电池，不为系统供电
+    for (const auto &supply : listDirectory(POWER_SUPPLY_DIR)) {
+        if (readLine(supply / "type") == "Battery" && readLine(supply / "scope") != "Device") {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 打开默认混音器，检查音频模块使用的元素
+void probeMixer(HardwareProfile &profile) {
+    snd_mixer_t *raw_handle = nullptr;
+    if (snd_mixer_open(&raw_handle, 0) < 0) {
+        return;
+    }
+    std::unique_ptr<snd_mixer_t, decltype(&snd_mixer_close)> handle(raw_handle, &snd_mixer_close);
+
+    if (snd_mixer_attach(raw_handle, "default") < 0 ||
+        snd_mixer_selem_register(raw_handle, nullptr, nullptr) < 0 ||
+        snd_mixer_load(raw_handle) < 0) {
+        return;
+    }
+
+    snd_mixer_selem_id_t *sid;
+    snd_mixer_selem_id_alloca(&sid);
+    snd_mixer_selem_id_set_index(sid, 0);
+
+    snd_mixer_selem_id_set_name(sid, "Master");
+    snd_mixer_elem_t *master = snd_mixer_find_selem(raw_handle, sid);
+    profile.playback = master && snd_mixer_selem_has_playback_volume(master);
+
+    snd_mixer_selem_id_set_name(sid, "Capture");
+    snd_mixer_elem_t *capture = snd_mixer_find_selem(raw_handle, sid);
+    profile.capture = capture && snd_mixer_selem_has_capture_volume(capture);
+}
+
+// 输出探测结果的摘要
+void logProfile(const HardwareProfile &profile, const char *source) {
+    auto show = [](const std::string &path) { return path.empty() ? "none" : path.c_str(); };
+    std::cerr << "Hardware (" << source << "): rapl=" << show(profile.rapl)
+              << " svi2=" << show(profile.svi2) << " cpu_temp=" << show(profile.cpu_temp)
+              << " gpu=" << show(profile.gpu) << " backlight=" << show(profile.backlight)
+              << " battery=" << profile.battery << " playback=" << profile.playback
+              << " capture=" << profile.capture << std::endl;
+}
+
+} // namespace
+
+HardwareProfile HardwareProbe::load(bool reprobe) {
+    const std::string boot_id = currentBootId();
+    const std::string path = defaultCachePath();
+
+    if (!reprobe && !boot_id.empty() && !path.empty()) {
+        if (auto cached = readCache(path, boot_id)) {
+            logProfile(*cached, "cached");
+            return std::move(*cached);
+        }
+    }
+
+    HardwareProfile profile = probe();
+    profile.boot_id = boot_id;
+    logProfile(profile, "probed");
+
+    if (!boot_id.empty() && !path.empty()) {
+        writeCache(path, profile);
+    }
+    return profile;
+}
+
+HardwareProfile HardwareProbe::probe() {
+    HardwareProfile profile;
+    profile.rapl = probeRapl();
+    profile.svi2 = probeSvi2();
+    profile.cpu_temp = probeCpuTemp();
+    profile.gpu = probeGpu();
+    profile.backlight = probeBacklight();
+    profile.battery = probeBattery();
+    probeMixer(profile);
+    return profile;
+}
+
+std::optional<HardwareProfile>
+HardwareProbe::readCache(const std::string &path, const std::string &boot_id) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+
+    HardwareProfile profile;
+    bool version_ok = false;
+    std::string line;
+    while (std::getline(file, line)) {
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        const std::string_view key = std::string_view(line).substr(0, eq);
+        std::string value = line.substr(eq + 1);
+
+        if (key == "version") {
+            version_ok = value == CACHE_VERSION;
+        } else if (key == "boot_id") {
+            profile.boot_id = std::move(value);
+        } else if (key == "rapl") {
+            profile.rapl = std::move(value);
+        } else if (key == "svi2") {
+            profile.svi2 = std::move(value);
+        } else if (key == "cpu_temp") {
+            profile.cpu_temp = std::move(value);
+        } else if (key == "gpu") {
+            profile.gpu = std::move(value);
+        } else if (key == "backlight") {
+            profile.backlight = std::move(value);
+        } else if (key == "battery") {
+            profile.battery = value == "1";
+        } else if (key == "playback") {
+            profile.playback = value == "1";
+        } else if (key == "capture") {
+            profile.capture = value == "1";
+        }
+    }
+
+    if (!version_ok || profile.boot_id != boot_id) {
+        return std::nullopt;
+    }
+    return profile;
+}
+
+bool HardwareProbe::writeCache(const std::string &path, const HardwareProfile &profile) {
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    if (ec) {
+        std::cerr << "Failed to create cache directory for " << path << ": " << ec.message()
+                  << std::endl;
+        return false;
+    }
+
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        file << "version=" << CACHE_VERSION << '\n'
+             << "boot_id=" << profile.boot_id << '\n'
+             << "rapl=" << profile.rapl << '\n'
+             << "svi2=" << profile.svi2 << '\n'
+             << "cpu_temp=" << profile.cpu_temp << '\n'
+             << "gpu=" << profile.gpu << '\n'
+             << "backlight=" << profile.backlight << '\n'
+             << "battery=" << profile.battery << '\n'
+             << "playback=" << profile.playback << '\n'
+             << "capture=" << profile.capture << '\n';
+        if (!file.flush()) {
+            std::cerr << "Failed to write hardware cache " << temp_path << std::endl;
+            return false;
+        }
+    }
+
+    fs::rename(temp_path, path, ec);
+    if (ec) {
+        std::cerr << "Failed to replace hardware cache " << path << ": " << ec.message()
+                  << std::endl;
+        fs::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+std::string HardwareProbe::defaultCachePath() {
+    if (const char *cache_home = std::getenv("XDG_CACHE_HOME"); cache_home && *cache_home) {
+        return std::string(cache_home) + "/seedstatus/hardware";
+    }
+    if (const char *home = std::getenv("HOME")) {
+        return std::string(home) + "/.cache/seedstatus/hardware";
+    }
+    return {};
+}
+
+std::string HardwareProbe::currentBootId() {
+    return readLine(BOOT_ID_PATH);
+}
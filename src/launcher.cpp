@@ -0,0 +1,291 @@
+#include <launcher.h>
+#include <system.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// 打开子进程的pidfd，内核不支持时返回-1
+int openPidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// 将以~/开头的参数展开为$HOME
+std::string expandHome(const std::string &arg) {
+    if (arg != "~" && arg.rfind("~/", 0) != 0) {
+        return arg;
+    }
+    const char *home = std::getenv("HOME");
+    if (!home) {
+        return arg;
+    }
+    return std::string(home) + arg.substr(1);
+}
+
+} // namespace
+
+Launcher::Launcher(System &system) : system_(system) {}
+
+Launcher::~Launcher() {
+    // 只在System析构时调用，此时epoll实例可能已关闭，直接关闭pidfd即可
+    for (auto &[pid, child] : children_) {
+        if (child.pidfd != -1) {
+            close(child.pidfd);
+        }
+    }
+}
+
+pid_t Launcher::spawn(const std::string &owner, std::vector<std::string> argv,
+                      ExitHandler on_exit) {
+    SpawnOptions options;
+    options.on_exit = std::move(on_exit);
+    return spawn(owner, std::move(argv), std::move(options));
+}
+
+pid_t Launcher::spawn(const std::string &owner, std::vector<std::string> argv,
+                      SpawnOptions options) {
+    reapWithoutPidfd();
+
+    if (argv.empty() || argv[0].empty()) {
+        return -1;
+    }
+
+    if (!acquireToken(owner)) {
+        ++rejected_;
+        std::cerr << "Launcher: " << owner << ": rate limited, not starting " << argv[0]
+                  << std::endl;
+        return -1;
+    }
+
+    std::vector<char *> args;
+    args.reserve(argv.size() + 1);
+    for (auto &arg : argv) {
+        arg = expandHome(arg);
+        args.push_back(arg.data());
+    }
+    args.push_back(nullptr);
+
+    // 追加的环境变量放在前面，与继承的同名变量冲突时优先生效
+    std::vector<char *> envp;
+    if (!options.env.empty()) {
+        for (auto &var : options.env) {
+            envp.push_back(var.data());
+        }
+        for (char **var = environ; *var; ++var) {
+            envp.push_back(*var);
+        }
+        envp.push_back(nullptr);
+    }
+
+    // 标准输入和标准输出默认指向/dev/null，标准错误保留以便调试
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (options.stdin_fd != -1) {
+        posix_spawn_file_actions_adddup2(&actions, options.stdin_fd, STDIN_FILENO);
+    } else {
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    }
+    if (options.stdout_fd != -1) {
+        posix_spawn_file_actions_adddup2(&actions, options.stdout_fd, STDOUT_FILENO);
+    } else {
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    }
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+    // 不让子进程继承epoll、inotify等描述符
+    posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+#endif
+
+    // 重置信号掩码和信号处理，新会话使子进程不随状态栏一起收到终端信号
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    sigfillset(&signals);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_SETSID
+    flags = static_cast<short>(flags | POSIX_SPAWN_SETSID);
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+
+    pid_t pid = -1;
+    const int err = posix_spawnp(
+        &pid, args[0], &actions, &attr, args.data(), envp.empty() ? environ : envp.data()
+    );
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (err != 0) {
+        std::cerr << "Launcher: " << owner << ": failed to start " << argv[0] << ": "
+                  << strerror(err) << std::endl;
+        return -1;
+    }
+
+    Child child;
+    child.owner = owner;
+    child.program = argv[0];
+    child.on_exit = std::move(options.on_exit);
+
+    // 通过pidfd在事件循环中回收子进程
+    child.pidfd = openPidfd(pid);
+    if (child.pidfd != -1 &&
+        !system_.watchFd(child.pidfd, EPOLLIN, [this, pid](uint32_t) { reap(pid); })) {
+        close(child.pidfd);
+        child.pidfd = -1;
+    }
+
+    children_.emplace(pid, std::move(child));
+    ++buckets_[owner].running;
+
+    std::cerr << "Launcher: " << owner << ": started " << argv[0] << " (pid " << pid << ")"
+              << std::endl;
+    return pid;
+}
+
+bool Launcher::signal(pid_t pid, int sig) {
+    if (children_.find(pid) == children_.end()) {
+        return false;
+    }
+
+    // 子进程是新会话的组长，发送给整个进程组
+    if (kill(-pid, sig) == 0) {
+        return true;
+    }
+    return kill(pid, sig) == 0;
+}
+
+void Launcher::detach(pid_t pid) {
+    const auto it = children_.find(pid);
+    if (it != children_.end()) {
+        it->second.on_exit = nullptr;
+    }
+}
+
+std::vector<std::string> Launcher::splitCommand(const std::string &command) {
+    std::vector<std::string> argv;
+    std::istringstream stream(command);
+    std::string arg;
+    while (stream >> arg) {
+        argv.push_back(arg);
+    }
+    return argv;
+}
+
+void Launcher::setRateLimit(const RateLimit &limit) {
+    rate_limit_ = limit;
+}
+
+size_t Launcher::runningCount() const {
+    return children_.size();
+}
+
+uint64_t Launcher::rejectedCount() const {
+    return rejected_;
+}
+
+bool Launcher::acquireToken(const std::string &owner) {
+    const auto now = std::chrono::steady_clock::now();
+    Bucket &bucket = buckets_[owner];
+
+    if (!bucket.initialized) {
+        bucket.tokens = static_cast<double>(rate_limit_.burst);
+        bucket.last_refill = now;
+        bucket.initialized = true;
+    }
+
+    // 按经过的时间补充令牌
+    const std::chrono::duration<double> elapsed = now - bucket.last_refill;
+    bucket.tokens = std::min(
+        static_cast<double>(rate_limit_.burst),
+        bucket.tokens + elapsed.count() * rate_limit_.per_second
+    );
+    bucket.last_refill = now;
+
+    if (bucket.running >= rate_limit_.max_running || bucket.tokens < 1.0) {
+        return false;
+    }
+
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+bool Launcher::reap(pid_t pid) {
+    int status = 0;
+    const pid_t result = waitpid(pid, &status, WNOHANG);
+    if (result == 0) {
+        return false; // 仍在运行
+    }
+    if (result == -1 && errno != ECHILD) {
+        return false;
+    }
+
+    const auto it = children_.find(pid);
+    if (it == children_.end()) {
+        return result == pid;
+    }
+
+    // 先从表中移除，退出回调中可能再次调用spawn()
+    Child child = std::move(it->second);
+    children_.erase(it);
+
+    if (child.pidfd != -1) {
+        system_.unwatchFd(child.pidfd);
+        close(child.pidfd);
+    }
+
+    const auto bucket = buckets_.find(child.owner);
+    if (bucket != buckets_.end() && bucket->second.running > 0) {
+        --bucket->second.running;
+    }
+
+    if (result == pid) {
+        if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+            std::cerr << "Launcher: " << child.owner << ": " << child.program << " (pid " << pid
+                      << ") exited with status " << WEXITSTATUS(status) << std::endl;
+        } else if (WIFSIGNALED(status)) {
+            std::cerr << "Launcher: " << child.owner << ": " << child.program << " (pid " << pid
+                      << ") killed by signal " << WTERMSIG(status) << std::endl;
+        }
+    }
+
+    if (child.on_exit) {
+        try {
+            child.on_exit(pid, status);
+        } catch (const std::exception &e) {
+            std::cerr << "Launcher: " << child.owner << ": exit handler error: " << e.what()
+                      << std::endl;
+        }
+    }
+    return true;
+}
+
+void Launcher::reapWithoutPidfd() {
+    std::vector<pid_t> pids;
+    for (const auto &[pid, child] : children_) {
+        if (child.pidfd == -1) {
+            pids.push_back(pid);
+        }
+    }
+    for (const pid_t pid : pids) {
+        reap(pid);
+    }
+}
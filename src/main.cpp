@@ -3,73 +3,54 @@
  * @brief 程序入口点和主循环
  *
  * 本文件包含程序的主入口点，负责：
- * - 设置信号处理
- * - 初始化系统
+ * - 解析命令行参数（--backend=选择输出后端，--reprobe忽略硬件探测缓存，
+ *   --update-budget=设置模块update()的默认时间预算，--trace记录事件循环时间线，
+ *   --volume-step=和--volume-command=配置音量模块的滚轮操作）
+ * - 初始化系统（包括通过signalfd接管信号）
  * - 运行主事件循环
  * - 处理异常和错误
  *
  * 程序流程：
- * 1. 设置信号处理（SIGINT, SIGTERM）
- * 2. 创建System实例
- * 3. 初始化系统
- * 4. 运行主事件循环
- * 5. 处理异常并退出
+ * 1. 创建System实例并设置输出后端
+ * 2. 初始化系统（SIGINT、SIGTERM及i3bar的stop/cont信号由事件循环通过signalfd处理）
+ * 3. 运行主事件循环
+ * 4. 处理异常并退出
  */
 
 #include <system.h>
+#include <modules/audio.h>
+#include <charconv>
 #include <iostream>
-#include <csignal>
 #include <cstdlib>
-#include <functional>
-
-namespace {
-/**
- * @brief 全局信号处理函数
- *
- * 使用std::function存储信号处理函数，允许使用lambda捕获局部变量。
- */
-static std::function<void(int)> g_signalHandler;
+#include <cstring>
+#include <string_view>
 
-/**
- * @brief 信号处理函数包装器
- * @param signal 收到的信号编号
- *
- * 这是一个静态函数，作为信号处理程序的入口点。
- * 它调用存储在g_signalHandler中的实际处理函数。
- */
-static void signalHandlerWrapper(int signal) {
-    if (g_signalHandler) {
-        g_signalHandler(signal);
-    }
+// 输出命令行用法
+static void printUsage(const char *program) {
+    std::cerr << "Usage: " << program
+              << " [--backend=i3bar|plain|lemonbar|tmux] [--reprobe] [--update-budget=MS]"
+              << " [--trace[=PATH]] [--volume-step=N] [--volume-command=CMD]\n"
+              << "  --backend=NAME  output format (default: i3bar)\n"
+              << "                  i3bar     i3bar/swaybar JSON protocol with click events\n"
+              << "                  plain     one line of UTF-8 text per frame (xsetroot, dwm)\n"
+              << "                  lemonbar  lemonbar format strings, clicks print\n"
+              << "                            \"click <id> <button>\" for the control socket\n"
+              << "                  tmux      tmux status-line format\n"
+              << "  --reprobe       ignore the cached hardware probe and detect hardware again\n"
+              << "  --update-budget=MS\n"
+              << "                  default time budget of one module update (default: "
+              << ModuleManager::DEFAULT_UPDATE_BUDGET.count() << ")\n"
+              << "                  modules that keep exceeding it are slowed down or quarantined\n"
+              << "  --trace[=PATH]  record event loop activity as a Chrome/Perfetto trace\n"
+              << "                  (default: " << Trace::defaultPath() << ")\n"
+              << "                  written on SIGUSR1, the control command \"trace\" and exit\n"
+              << "  --volume-step=N percent changed by one scroll step on volume/microphone\n"
+              << "                  (1-100, default: " << AudioModule::DEFAULT_VOLUME_STEP << ")\n"
+              << "  --volume-command=CMD\n"
+              << "                  run \"CMD i|d|t\" on scroll up/down and right click instead of\n"
+              << "                  changing the ALSA mixer directly\n";
 }
 
-/**
- * @brief 设置信号处理
- * @param handler 信号处理函数
- *
- * 为SIGINT和SIGTERM信号设置处理函数。
- * 这些信号通常由用户发送（Ctrl+C）或系统发送（终止进程）。
- *
- * @throws std::runtime_error 如果设置信号处理失败
- */
-static void setupSignalHandlers(const std::function<void(int)> &handler) {
-    g_signalHandler = handler;
-
-    struct sigaction sa;
-    sa.sa_handler = signalHandlerWrapper;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = 0;
-
-    if (sigaction(SIGINT, &sa, nullptr) == -1) {
-        throw std::runtime_error("Failed to set SIGINT handler");
-    }
-
-    if (sigaction(SIGTERM, &sa, nullptr) == -1) {
-        throw std::runtime_error("Failed to set SIGTERM handler");
-    }
-}
-} // namespace
-
 /**
  * @brief 程序主入口点
  * @return 程序退出代码（0表示成功，非0表示失败）
@@ -77,8 +58,8 @@ static void setupSignalHandlers(const std::function<void(int)> &handler) {
  * 程序的主入口点，负责初始化系统并运行主事件循环。
  *
  * 主要步骤：
- * 1. 创建System实例
- * 2. 设置信号处理
+ * 1. 解析命令行参数
+ * 2. 创建System实例并设置输出后端
  * 3. 初始化系统
  * 4. 运行主事件循环
  * 5. 处理异常并退出
@@ -92,30 +73,76 @@ static void setupSignalHandlers(const std::function<void(int)> &handler) {
  * - EXIT_SUCCESS (0): 程序成功执行
  * - EXIT_FAILURE (1): 程序执行失败
  */
-int main() {
-    try {
-        // 直接创建System实例
-        System system;
+int main(int argc, char *argv[]) {
+    std::unique_ptr<OutputBackend> backend = makeOutputBackend("i3bar");
+    bool reprobe = false;
+    std::chrono::milliseconds update_budget = ModuleManager::DEFAULT_UPDATE_BUDGET;
+    uint64_t volume_step = AudioModule::DEFAULT_VOLUME_STEP;
+    std::string volume_command;
 
-        // 设置信号处理，使用lambda捕获system对象
-        setupSignalHandlers([&system](int signal) {
-            const char *signalName;
-            switch (signal) {
-            case SIGINT:
-                signalName = "SIGINT";
-                break;
-            case SIGTERM:
-                signalName = "SIGTERM";
-                break;
-            default:
-                signalName = "UNKNOWN";
-                break;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        if (arg == "--reprobe") {
+            reprobe = true;
+            continue;
+        }
+        if (arg == "--trace" || arg.rfind("--trace=", 0) == 0) {
+            // 在创建工作线程之前启用，未指定路径时使用默认路径
+            const std::string_view path =
+                arg == "--trace" ? std::string_view{} : arg.substr(std::strlen("--trace="));
+            Trace::enable(std::string(path));
+            continue;
+        }
+        if (arg.rfind("--update-budget=", 0) == 0) {
+            const std::string_view value = arg.substr(std::strlen("--update-budget="));
+            uint32_t ms = 0;
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), ms);
+            if (ec == std::errc() && end == value.data() + value.size() && ms > 0) {
+                update_budget = std::chrono::milliseconds(ms);
+                continue;
             }
+            std::cerr << "Invalid update budget: " << value << std::endl;
+        } else if (arg.rfind("--volume-step=", 0) == 0) {
+            const std::string_view value = arg.substr(std::strlen("--volume-step="));
+            uint64_t step = 0;
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), step);
+            if (ec == std::errc() && end == value.data() + value.size() && step >= 1 &&
+                step <= 100) {
+                volume_step = step;
+                continue;
+            }
+            std::cerr << "Invalid volume step: " << value << std::endl;
+        } else if (arg.rfind("--volume-command=", 0) == 0) {
+            volume_command = arg.substr(std::strlen("--volume-command="));
+            if (!volume_command.empty()) {
+                continue;
+            }
+            std::cerr << "Empty volume command" << std::endl;
+        } else if (arg.rfind("--backend=", 0) == 0) {
+            backend = makeOutputBackend(arg.substr(std::strlen("--backend=")));
+            if (backend) {
+                continue;
+            }
+            std::cerr << "Unknown backend: " << arg.substr(std::strlen("--backend=")) << std::endl;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+        }
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
 
-            std::cerr << "\nReceived signal " << signalName << " (" << signal
-                      << "), shutting down..." << std::endl;
-            system.stop();
-        });
+    try {
+        // 直接创建System实例
+        System system;
+        system.setOutputBackend(std::move(backend));
+        system.setReprobeHardware(reprobe);
+        system.getModuleManager().setDefaultUpdateBudget(update_budget);
+        system.setVolumeStep(volume_step);
+        system.setVolumeCommand(std::move(volume_command));
 
         // 初始化系统
         if (!system.initialize()) {
@@ -1,31 +1,26 @@
 #include <module.h>
+#include <output_backend.h>
+#include <format.h>
+#include <worker_pool.h>
+#include <trace.h>
+#include <probes.h>
 #include <nlohmann/json.hpp>
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
-#include <fstream>
-#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
 
 using json = nlohmann::json;
 
-// 颜色字符串映射
-static constexpr const char *colorStrings[] = {
-    "#6A6862", // DEACTIVE
-    "#729FCF", // COOL
-    "#98BC37", // GOOD
-    "#FCE8C3", // IDLE
-    "#FED06E", // WARNING
-    "#F75341"  // CRITICAL
-};
-
-// 获取颜色的字符串表示
-std::string getColorString(Color color) {
-    const int index = static_cast<int>(color);
-    constexpr int colorCount = sizeof(colorStrings) / sizeof(colorStrings[0]);
-
-    if (index >= 0 && index < colorCount) {
-        return colorStrings[index];
-    }
-    return colorStrings[static_cast<int>(Color::IDLE)]; // 默认返回IDLE颜色
+RenderKey &RenderKey::addBytes(uint64_t bytes) {
+    // formatBytes()固定输出5个字符，正好放进一个int64_t
+    char text[sizeof(int64_t)] = {};
+    formatBytes(bytes, text, text + sizeof(text));
+    int64_t value = 0;
+    std::memcpy(&value, text, sizeof(value));
+    return push(value);
 }
 
 // Module类实现
@@ -33,22 +28,72 @@ Module::Module(const std::string &name) : name_(name) {
     updateLastUpdateTime();
 }
 
-std::string Module::getName() const {
+const std::string &Module::getName() const {
     return name_;
 }
 
-std::string Module::getOutput() const {
+ModuleId Module::getId() const {
+    return id_;
+}
+
+const std::string &Module::getOutput() const {
     return output_;
 }
 
-void Module::setOutput(const std::string &output, Color color) {
+Color Module::getColor() const {
+    return color_;
+}
+
+void Module::setOutput(std::string_view output, Color color) {
     output_ = output;
-    color_ = getColorString(color);
+    color_ = color;
+    stale_ = false;
+    render_key_valid_ = false;
     updateLastUpdateTime();
+
+    if (manager_) {
+        manager_->onOutputChanged(id_, color);
+    }
+}
+
+void Module::setUnavailable(std::string_view placeholder) {
+    // 正常渲染的键不会以INT64_MIN开头
+    renderOutput(RenderKey().add(std::numeric_limits<int64_t>::min()), [&] {
+        setOutput(placeholder, Color::DEACTIVE);
+    });
+}
+
+void Module::markStale() {
+    if (stale_ || output_.empty()) {
+        return;
+    }
+    const std::string text = output_ + std::string(STALE_MARKER);
+    setOutput(text, Color::DEACTIVE);
+    stale_ = true;
+}
+
+void Module::markQuarantined() {
+    if (output_.empty()) {
+        return;
+    }
+    const std::string text = output_ + std::string(QUARANTINE_MARKER);
+    setOutput(text, Color::DEACTIVE);
+}
+
+void Module::setUpdateBudget(std::chrono::milliseconds budget) {
+    update_budget_ = budget;
+}
+
+std::chrono::milliseconds Module::getUpdateBudget() const {
+    return update_budget_;
 }
 
 void Module::setInterval(uint64_t interval) {
     interval_ = interval;
+
+    if (manager_) {
+        manager_->onIntervalChanged(id_, interval);
+    }
 }
 
 uint64_t Module::getInterval() const {
@@ -68,12 +113,86 @@ void Module::handleClick(uint64_t button) {
     // 默认实现不做任何事情
 }
 
+void Module::start() {
+    // 默认实现不做任何事情
+}
+
 void Module::init() {
     // 默认实现不做任何事情
 }
 
+void Module::saveCounters(std::vector<uint64_t> &counters) const {
+    (void)counters;
+    // 默认实现不做任何事情
+}
+
+void Module::restoreCounters(std::span<const uint64_t> counters) {
+    (void)counters;
+    // 默认实现不做任何事情
+}
+
+bool Module::isAsyncStart() const {
+    return async_start_;
+}
+
+void Module::setAsyncStart(bool async) {
+    async_start_ = async;
+}
+
+void Module::sample() {
+    // 默认实现不做任何事情
+}
+
+bool Module::isBlockingSample() const {
+    return sample_timeout_.count() > 0;
+}
+
+std::chrono::milliseconds Module::getSampleTimeout() const {
+    return sample_timeout_;
+}
+
+void Module::setBlockingSample(std::chrono::milliseconds timeout) {
+    sample_timeout_ = timeout;
+}
+
+void Module::flush() {
+    // 默认实现不做任何事情
+}
+
+void Module::requestFlush() {
+    if (manager_) {
+        manager_->onFlushRequested(id_);
+    } else {
+        flush();
+    }
+}
+
+void Module::requestUpdate() {
+    if (manager_) {
+        manager_->refreshModule(id_);
+    } else {
+        update();
+    }
+}
+
+void Module::setRefreshSignal(int signal) {
+    refresh_signal_ = signal;
+}
+
+int Module::getRefreshSignal() const {
+    return refresh_signal_;
+}
+
+System *Module::getSystem() const {
+    return system_;
+}
+
 void Module::setFd(int fd) {
     fd_ = fd;
+
+    if (manager_) {
+        manager_->onFdChanged(id_, fd);
+    }
 }
 
 int Module::getFd() const {
@@ -92,11 +211,12 @@ std::string Module::toJson() const {
     try {
         json j;
         j["name"] = name_;
+        j["instance"] = std::to_string(id_);
         j["separator"] = false;
         j["separator_block_width"] = 0;
         j["markup"] = "pango";
         j["full_text"] = output_;
-        j["color"] = color_;
+        j["color"] = std::string(getColorString(color_));
         return j.dump();
     } catch (const std::exception &e) {
         throw std::runtime_error("Failed to create JSON string: " + std::string(e.what()));
@@ -121,30 +241,69 @@ void Module::updateLastUpdateTime() {
     last_update_time_ = std::chrono::steady_clock::now();
 }
 
-// 读取Uint64格式的文件内容
-uint64_t Module::readUint64File(const std::string &path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open " + path);
-    }
+// ModuleManager类实现
+
+// 计算按间隔对齐的下一个到期节拍
+static uint64_t nextDeadline(uint64_t tick, uint64_t interval) {
+    return interval == 0 ? 0 : (tick / interval + 1) * interval;
+}
+
+ModuleManager::ModuleManager() : backend_(makeOutputBackend("i3bar")) {}
 
-    uint64_t value = 0;
-    file >> value;
+ModuleManager::~ModuleManager() = default;
 
-    if (!file) {
-        throw std::runtime_error("Failed to read from " + path);
+void ModuleManager::setBackend(std::unique_ptr<OutputBackend> backend) {
+    if (!backend) {
+        throw std::invalid_argument("Output backend cannot be null");
     }
+    backend_ = std::move(backend);
 
-    return value;
+    for (size_t i = 0; i < modules_.size(); ++i) {
+        templates_[i] = modules_[i] ? backend_->compile(*modules_[i]) : ModuleTemplate();
+        dirty_[i] = 1;
+    }
+    frame_dirty_ = true;
 }
 
-// ModuleManager类实现
-void ModuleManager::addModule(std::shared_ptr<Module> module) {
+const OutputBackend &ModuleManager::getBackend() const {
+    return *backend_;
+}
+
+ModuleId ModuleManager::addModule(std::shared_ptr<Module> module) {
     if (!module) {
         throw std::invalid_argument("Module cannot be null");
     }
+    if (module->manager_) {
+        throw std::invalid_argument("Module " + module->name_ + " is already registered");
+    }
+    if (modules_.size() >= INVALID_MODULE_ID) {
+        throw std::length_error("Too many modules");
+    }
 
-    modules_.push_back(module);
+    const auto id = static_cast<ModuleId>(modules_.size());
+    module->manager_ = this;
+    module->id_ = id;
+
+    dirty_.push_back(1);
+    next_deadline_.push_back(nextDeadline(tick_, module->interval_));
+    interval_.push_back(module->interval_);
+    color_.push_back(module->color_); // 注册前设置的占位内容的颜色
+    fragment_offset_.push_back(0);
+    fragment_size_.push_back(0);
+    fd_.push_back(module->fd_);
+    flush_pending_.push_back(0);
+    ready_.push_back(1);
+    sampling_.push_back(0);
+    sample_deadline_.push_back(0);
+    budget_.emplace_back();
+    update_latency_.emplace_back();
+    templates_.push_back(backend_->compile(*module));
+    // 驻留名称，已存在同名模块时保留先注册的一个
+    name_index_.try_emplace(std::string_view(module->name_), id);
+    modules_.push_back(std::move(module));
+
+    frame_dirty_ = true;
+    return id;
 }
 
 size_t ModuleManager::getModuleCount() const {
@@ -158,70 +317,552 @@ std::shared_ptr<Module> ModuleManager::getModule(size_t index) const {
     return modules_[index];
 }
 
-std::shared_ptr<Module> ModuleManager::getModuleByName(const std::string &name) const {
-    for (const auto &module : modules_) {
-        if (module->getName() == name) {
-            return module;
+std::shared_ptr<Module> ModuleManager::getModuleByName(std::string_view name) const {
+    const ModuleId id = findModuleId(name);
+    if (id == INVALID_MODULE_ID) {
+        return nullptr;
+    }
+    return modules_[id];
+}
+
+ModuleId ModuleManager::findModuleId(std::string_view name) const {
+    const auto it = name_index_.find(name);
+    return it == name_index_.end() ? INVALID_MODULE_ID : it->second;
+}
+
+bool ModuleManager::dispatchClick(ModuleId id, uint64_t button) {
+    if (id >= modules_.size() || !modules_[id]) {
+        return false;
+    }
+    if (!ready_[id]) {
+        // 模块仍在启动，点击被忽略
+        return true;
+    }
+
+    Module &module = *modules_[id];
+    SEEDSTATUS_PROBE2(click, id, button);
+    TraceSpan span(TraceKind::CLICK, id);
+    try {
+        module.handleClick(button);
+    } catch (const std::exception &e) {
+        std::cerr << "Error handling click in module " << module.getName() << ": " << e.what()
+                  << std::endl;
+    }
+    return true;
+}
+
+void ModuleManager::unindexName(ModuleId id) {
+    const std::string_view name = modules_[id]->name_;
+    const auto it = name_index_.find(name);
+    if (it == name_index_.end() || it->second != id) {
+        return;
+    }
+    name_index_.erase(it);
+
+    // 索引键指向模块自身的名称，必须换成下一个同名模块的字符串
+    for (size_t i = id + 1; i < modules_.size(); ++i) {
+        if (modules_[i] && modules_[i]->name_ == name) {
+            name_index_.emplace(std::string_view(modules_[i]->name_), static_cast<ModuleId>(i));
+            break;
         }
     }
-    return nullptr;
+}
+
+void ModuleManager::setReady(ModuleId id, bool ready) {
+    if (id < ready_.size()) {
+        ready_[id] = ready ? 1 : 0;
+    }
+}
+
+bool ModuleManager::isReady(ModuleId id) const {
+    return id < ready_.size() && modules_[id] && ready_[id];
+}
+
+void ModuleManager::markDirty(ModuleId id) {
+    if (id < dirty_.size()) {
+        dirty_[id] = 1;
+        frame_dirty_ = true;
+    }
+}
+
+void ModuleManager::onIntervalChanged(ModuleId id, uint64_t interval) {
+    // 降级的模块保持加倍，恢复时由applyInterval()按新的间隔重新计算
+    interval_[id] = interval << budget_[id].slowdown;
+    next_deadline_[id] = nextDeadline(tick_, interval_[id]);
+}
+
+void ModuleManager::onFdChanged(ModuleId id, int fd) {
+    fd_[id] = fd;
+}
+
+void ModuleManager::onOutputChanged(ModuleId id, Color color) {
+    color_[id] = color;
+    markDirty(id);
+}
+
+void ModuleManager::onFlushRequested(ModuleId id) {
+    flush_pending_[id] = 1;
+    flush_pending_any_ = true;
+}
+
+void ModuleManager::flushPending() {
+    if (!flush_pending_any_) {
+        return;
+    }
+    flush_pending_any_ = false;
+
+    const size_t count = flush_pending_.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (!flush_pending_[i]) {
+            continue;
+        }
+        flush_pending_[i] = 0;
+
+        Module *module = modules_[i].get();
+        if (!module || !ready_[i]) {
+            continue;
+        }
+        TraceSpan span(TraceKind::FLUSH, static_cast<uint32_t>(i));
+        try {
+            module->flush();
+        } catch (const std::exception &e) {
+            std::cerr << "Error flushing module " << module->getName() << ": " << e.what()
+                      << std::endl;
+        }
+    }
+}
+
+// steady_clock的当前时刻（纳秒）
+static int64_t steadyNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()
+    )
+        .count();
+}
+
+void ModuleManager::updateModule(ModuleId id, bool from_event) {
+    Module *module = modules_[id].get();
+    if (!module || !ready_[id]) {
+        return;
+    }
+
+    BudgetState &budget = budget_[id];
+    if (budget.quarantine_until != 0) {
+        if (tick_ < budget.quarantine_until) {
+            // 隔离期间只处理fd事件，fd不读取会一直可读
+            if (!from_event) {
+                return;
+            }
+        } else {
+            // 隔离期满，试运行一次
+            budget.quarantine_until = 0;
+            budget.probation = true;
+        }
+    }
+
+    if (module->isBlockingSample()) {
+        if (workers_) {
+            startSample(id);
+            return;
+        }
+        // 没有线程池时同步采样
+        TraceSpan span(TraceKind::SAMPLE, id);
+        try {
+            module->sample();
+        } catch (const std::exception &e) {
+            std::cerr << "Error sampling module " << module->getName() << ": " << e.what()
+                      << std::endl;
+        }
+    }
+
+    runUpdate(id, *module);
+}
+
+void ModuleManager::runUpdate(ModuleId id, Module &module) {
+    SEEDSTATUS_PROBE2(update_begin, id, module.getName().c_str());
+    const int64_t start = steadyNow();
+    try {
+        module.update();
+    } catch (const std::exception &e) {
+        std::cerr << "Error updating module " << module.getName() << ": " << e.what()
+                  << std::endl;
+    }
+    const int64_t elapsed = steadyNow() - start;
+    update_latency_[id].record(static_cast<uint64_t>(elapsed));
+    SEEDSTATUS_PROBE3(update_end, id, module.getName().c_str(), elapsed);
+    Trace::complete(TraceKind::UPDATE, id, static_cast<uint64_t>(start),
+                    static_cast<uint64_t>(start + elapsed));
+    chargeBudget(id, module, elapsed);
+}
+
+void ModuleManager::chargeBudget(ModuleId id, Module &module, int64_t elapsed) {
+    if (elapsed > slowest_.ns) {
+        slowest_ = SlowestUpdate{id, elapsed};
+    }
+
+    // update()中模块可能已被标记删除，但槽位要到removeMarkedModules()才清空
+    BudgetState &state = budget_[id];
+    state.max_ns = std::max(state.max_ns, elapsed);
+
+    const std::chrono::milliseconds budget =
+        module.update_budget_.count() > 0 ? module.update_budget_ : default_budget_;
+    const int64_t budget_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(budget).count();
+    const bool probation = std::exchange(state.probation, false);
+
+    if (elapsed <= budget_ns) {
+        state.strikes = 0;
+        if (probation) {
+            std::cerr << "Module " << module.getName() << " back within its " << budget.count()
+                      << " ms update budget, quarantine lifted" << std::endl;
+        }
+        if (state.slowdown > 0 && ++state.good_updates >= RECOVERY_UPDATES) {
+            state.good_updates = 0;
+            --state.slowdown;
+            applyInterval(id);
+        }
+        return;
+    }
+
+    ++state.overruns;
+    state.good_updates = 0;
+    if (state.quarantine_until != 0) {
+        return; // 隔离中的fd事件，已经降到底了
+    }
+    if (probation) {
+        quarantine(id, module);
+        return;
+    }
+    if (++state.strikes < BUDGET_STRIKES) {
+        return;
+    }
+    state.strikes = 0;
+
+    const uint64_t interval = module.getInterval();
+    if (interval > 0 && state.slowdown < MAX_SLOWDOWN) {
+        ++state.slowdown;
+        applyInterval(id);
+        std::cerr << "Module " << module.getName() << " exceeded its " << budget.count()
+                  << " ms update budget " << int{BUDGET_STRIKES} << " times in a row (last "
+                  << elapsed / 1000000 << " ms), interval now " << interval_[id] << " s"
+                  << std::endl;
+        return;
+    }
+    quarantine(id, module);
+}
+
+void ModuleManager::quarantine(ModuleId id, Module &module) {
+    BudgetState &state = budget_[id];
+    const uint64_t ticks = QUARANTINE_TICKS << std::min<uint8_t>(state.quarantines, 4);
+    state.quarantine_until = tick_ + ticks;
+    state.strikes = 0;
+    if (state.quarantines < std::numeric_limits<uint8_t>::max()) {
+        ++state.quarantines;
+    }
+
+    std::cerr << "Module " << module.getName() << " keeps exceeding its update budget, quarantined for "
+              << ticks << " s" << (fd_[id] != -1 ? " (fd events still delivered)" : "")
+              << std::endl;
+    module.markQuarantined();
+}
+
+void ModuleManager::applyInterval(ModuleId id) {
+    const Module *module = modules_[id].get();
+    if (module) {
+        onIntervalChanged(id, module->getInterval());
+    }
+}
+
+void ModuleManager::setDefaultUpdateBudget(std::chrono::milliseconds budget) {
+    if (budget.count() > 0) {
+        default_budget_ = budget;
+    }
+}
+
+std::chrono::milliseconds ModuleManager::getDefaultUpdateBudget() const {
+    return default_budget_;
+}
+
+ModuleManager::BudgetStats ModuleManager::getBudgetStats(ModuleId id) const {
+    BudgetStats stats;
+    if (id >= modules_.size() || !modules_[id]) {
+        return stats;
+    }
+
+    const BudgetState &state = budget_[id];
+    const std::chrono::milliseconds budget = modules_[id]->update_budget_;
+    stats.budget = budget.count() > 0 ? budget : default_budget_;
+    stats.overruns = state.overruns;
+    stats.max_ns = state.max_ns;
+    stats.slowdown = state.slowdown;
+    stats.quarantines = state.quarantines;
+    stats.quarantined = state.quarantine_until != 0;
+    return stats;
+}
+
+void ModuleManager::resetBudget(ModuleId id) {
+    if (id >= modules_.size() || !modules_[id]) {
+        return;
+    }
+
+    const bool quarantined = budget_[id].quarantine_until != 0;
+    budget_[id] = BudgetState{};
+    applyInterval(id);
+    if (quarantined) {
+        // 清除输出中的隔离标记
+        updateModule(id);
+    }
+}
+
+void ModuleManager::beginIteration() {
+    slowest_ = SlowestUpdate{};
+}
+
+const Histogram &ModuleManager::getUpdateLatency(ModuleId id) const {
+    static const Histogram EMPTY;
+    return id < update_latency_.size() ? update_latency_[id] : EMPTY;
+}
+
+ModuleManager::SlowestUpdate ModuleManager::getSlowestUpdate() const {
+    return slowest_;
+}
+
+void ModuleManager::setWorkerPool(WorkerPool *workers) {
+    workers_ = workers;
+}
+
+bool ModuleManager::isSampling(ModuleId id) const {
+    return id < sampling_.size() && sampling_[id];
+}
+
+void ModuleManager::startSample(ModuleId id) {
+    // 同一模块同时只有一次采样，卡住的数据源不会堆积任务
+    if (sampling_[id]) {
+        return;
+    }
+
+    std::shared_ptr<Module> module = modules_[id];
+    sampling_[id] = 1;
+    sample_deadline_[id] = steadyNow() + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             module->getSampleTimeout()
+                                         )
+                                             .count();
+    ++samples_in_flight_;
+
+    workers_->submit(
+        [id, module]() {
+            TraceSpan span(TraceKind::SAMPLE, id);
+            module->sample();
+        },
+        [this, id, module]() { finishSample(id, module); }
+    );
+}
+
+void ModuleManager::finishSample(ModuleId id, const std::shared_ptr<Module> &module) {
+    if (id >= modules_.size() || modules_[id] != module || !sampling_[id]) {
+        return;
+    }
+
+    sampling_[id] = 0;
+    sample_deadline_[id] = 0;
+    --samples_in_flight_;
+
+    if (!ready_[id]) {
+        return;
+    }
+    runUpdate(id, *module);
+}
+
+int ModuleManager::getSampleWaitTimeout() const {
+    if (samples_in_flight_ == 0) {
+        return -1;
+    }
+
+    int64_t earliest = std::numeric_limits<int64_t>::max();
+    for (const int64_t deadline : sample_deadline_) {
+        if (deadline != 0 && deadline < earliest) {
+            earliest = deadline;
+        }
+    }
+    if (earliest == std::numeric_limits<int64_t>::max()) {
+        return -1; // 进行中的采样都已超时，只等待完成
+    }
+
+    const int64_t remaining = earliest - steadyNow();
+    if (remaining <= 0) {
+        return 0;
+    }
+    const int64_t ms = (remaining + 999999) / 1000000;
+    return ms > std::numeric_limits<int>::max() ? std::numeric_limits<int>::max()
+                                                 : static_cast<int>(ms);
+}
+
+void ModuleManager::expireSamples() {
+    if (samples_in_flight_ == 0) {
+        return;
+    }
+
+    const int64_t now = steadyNow();
+    const size_t count = sample_deadline_.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (sample_deadline_[i] == 0 || now < sample_deadline_[i]) {
+            continue;
+        }
+        sample_deadline_[i] = 0;
+
+        Module &module = *modules_[i];
+        std::cerr << "Module " << module.getName() << " sample exceeded "
+                  << module.getSampleTimeout().count() << " ms, showing stale output"
+                  << std::endl;
+        module.markStale();
+    }
+}
+
+void ModuleManager::dispatchTick(uint64_t counter) {
+    tick_ = counter;
+
+    // 只扫描连续的间隔与到期时刻数组，到期时才访问模块对象
+    const size_t count = interval_.size();
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t interval = interval_[i];
+        if (interval == 0 || counter < next_deadline_[i]) {
+            continue;
+        }
+
+        next_deadline_[i] = nextDeadline(counter, interval);
+        updateModule(static_cast<ModuleId>(i));
+    }
+}
+
+void ModuleManager::dispatchEvent(ModuleId id) {
+    if (id < modules_.size()) {
+        updateModule(id, true);
+    }
+}
+
+void ModuleManager::refreshAll() {
+    for (size_t i = 0; i < modules_.size(); ++i) {
+        if (!modules_[i]) {
+            continue;
+        }
+        if (interval_[i] != 0) {
+            next_deadline_[i] = nextDeadline(tick_, interval_[i]);
+        }
+        updateModule(static_cast<ModuleId>(i));
+    }
+}
+
+void ModuleManager::refreshModule(ModuleId id) {
+    if (id < modules_.size()) {
+        updateModule(id);
+    }
+}
+
+size_t ModuleManager::refreshBySignal(int signal) {
+    size_t count = 0;
+    if (signal <= 0) {
+        return count;
+    }
+    for (size_t i = 0; i < modules_.size(); ++i) {
+        if (modules_[i] && modules_[i]->refresh_signal_ == signal) {
+            updateModule(static_cast<ModuleId>(i));
+            ++count;
+        }
+    }
+    return count;
 }
 
 void ModuleManager::removeMarkedModules() {
-    auto it =
-        std::remove_if(modules_.begin(), modules_.end(), [](const std::shared_ptr<Module> &module) {
-            return module->shouldDelete();
-        });
-    modules_.erase(it, modules_.end());
+    for (size_t i = 0; i < modules_.size(); ++i) {
+        auto &module = modules_[i];
+        if (!module || !module->shouldDelete()) {
+            continue;
+        }
+
+        unindexName(static_cast<ModuleId>(i));
+        module->manager_ = nullptr;
+        module->id_ = INVALID_MODULE_ID;
+        module.reset();
+
+        interval_[i] = 0;
+        next_deadline_[i] = 0;
+        fd_[i] = -1;
+        flush_pending_[i] = 0;
+        budget_[i] = BudgetState{};
+        update_latency_[i].reset();
+        if (sampling_[i]) {
+            // 采样完成时发现槽位已空，不再更新
+            sampling_[i] = 0;
+            sample_deadline_[i] = 0;
+            --samples_in_flight_;
+        }
+        dirty_[i] = 1;
+        frame_dirty_ = true;
+    }
+}
+
+void ModuleManager::clear() {
+    for (auto &module : modules_) {
+        if (module) {
+            module->markForDeletion();
+        }
+    }
+    removeMarkedModules();
 }
 
 const std::vector<std::shared_ptr<Module>> &ModuleManager::getModules() const {
     return modules_;
 }
 
-void ModuleManager::outputModules() const {
-    try {
-        std::cout << '[';
-        bool first = true;
-
-        for (const auto &module : modules_) {
-            if (!module)
-                continue;
-
-            std::string output;
-            try {
-                output = module->getOutput();
-            } catch (const std::exception &e) {
-                std::cerr << "Error getting output from module " << module->getName() << ": "
-                          << e.what() << std::endl;
-                continue;
-            }
+void ModuleManager::appendFragment(ModuleId id, std::string &out) const {
+    const Module &module = *modules_[id];
+    if (module.getOutput().empty()) {
+        return;
+    }
+
+    const ModuleTemplate &tmpl = templates_[id];
+    const Color color = color_[id];
+    out += tmpl.prefix[static_cast<size_t>(color)];
+    backend_->appendText(module.getOutput(), color, out);
+    out += tmpl.suffix;
+}
+
+const std::string &ModuleManager::buildFrame() {
+    if (!frame_dirty_) {
+        return frame_;
+    }
+
+    // 脏模块重新生成片段，其余模块从旧缓冲区按偏移整段拷贝
+    fragments_tmp_.clear();
+    const size_t count = modules_.size();
+    for (size_t i = 0; i < count; ++i) {
+        const size_t offset = fragments_tmp_.size();
 
-            if (!output.empty()) {
-                if (!first) {
-                    std::cout << ',';
-                }
-
-                try {
-                    std::cout << module->toJson();
-
-                    // 添加空格分隔符
-                    std::cout << ",{\"full_text\":\" "
-                                 "\",\"separator\":false,\"separator_block_width\":0,"
-                                 "\"markup\":\"pango\"}";
-                    first = false;
-                } catch (const std::exception &e) {
-                    std::cerr << "Error generating JSON for module " << module->getName() << ": "
-                              << e.what() << std::endl;
-                }
+        if (dirty_[i]) {
+            if (modules_[i]) {
+                appendFragment(static_cast<ModuleId>(i), fragments_tmp_);
             }
+            dirty_[i] = 0;
+        } else if (fragment_size_[i] > 0) {
+            fragments_tmp_.append(fragments_, fragment_offset_[i], fragment_size_[i]);
         }
 
-        std::cout << "]," << std::endl;
-        std::cout.flush();
-    } catch (const std::exception &e) {
-        std::cerr << "Error in outputModules: " << e.what() << std::endl;
-    } catch (...) {
-        std::cerr << "Unknown error in outputModules" << std::endl;
+        fragment_offset_[i] = static_cast<uint32_t>(offset);
+        fragment_size_[i] = static_cast<uint32_t>(fragments_tmp_.size() - offset);
+    }
+    fragments_.swap(fragments_tmp_);
+
+    // 每个片段都以一个分隔字符结尾，拼装时去掉最后一个
+    frame_.clear();
+    frame_ += backend_->frameBegin();
+    if (!fragments_.empty()) {
+        frame_.append(fragments_, 0, fragments_.size() - 1);
     }
-}
\ No newline at end of file
+    frame_ += backend_->frameEnd();
+
+    frame_dirty_ = false;
+    return frame_;
+}
+
+bool ModuleManager::hasFrameChanges() const {
+    return frame_dirty_;
+}
@@ -1,195 +1,54 @@
 #include <modules/audio.h>
-#include <alsa/asoundlib.h>
+#include <system.h>
+#include <icons.h>
 #include <iostream>
 #include <sstream>
-#include <stdexcept>
 #include <algorithm>
-#include <system_error>
 #include <iomanip>
-#include <unistd.h>
 #include <optional>
 
-// 现代化的ALSA混音器RAII包装器
-class AlsaMixerWrapper {
-  private:
-    std::unique_ptr<snd_mixer_t, decltype(&snd_mixer_close)> handle_;
-    snd_mixer_elem_t *elem_ = nullptr;
-    std::string element_name_;
-
-  public:
-    explicit AlsaMixerWrapper(const std::string &element_name)
-        : handle_(nullptr, &snd_mixer_close), element_name_(element_name) {}
-
-    bool initialize() {
-        snd_mixer_t *raw_handle = nullptr;
-        int err;
-
-        if ((err = snd_mixer_open(&raw_handle, 0)) < 0) {
-            std::cerr << "无法打开混音器: " << snd_strerror(err) << std::endl;
-            return false;
-        }
-
-        handle_.reset(raw_handle);
-
-        if ((err = snd_mixer_attach(handle_.get(), "default")) < 0 ||
-            (err = snd_mixer_selem_register(handle_.get(), nullptr, nullptr)) < 0 ||
-            (err = snd_mixer_load(handle_.get())) < 0) {
-            std::cerr << "混音器初始化失败: " << snd_strerror(err) << std::endl;
-            return false;
-        }
-
-        snd_mixer_selem_id_t *sid;
-        snd_mixer_selem_id_alloca(&sid);
-        snd_mixer_selem_id_set_index(sid, 0);
-        snd_mixer_selem_id_set_name(sid, element_name_.c_str());
-
-        elem_ = snd_mixer_find_selem(handle_.get(), sid);
-        if (!elem_) {
-            std::cerr << "未找到 " << element_name_ << " 控制元素" << std::endl;
-            return false;
-        }
-
-        return true;
-    }
-
-    std::optional<int64_t> getPlaybackVolume() {
-        if (!handle_ || !elem_)
-            return std::nullopt;
-
-        int unmuted = 1;
-        if (snd_mixer_selem_has_playback_switch(elem_)) {
-            snd_mixer_selem_get_playback_switch(elem_, SND_MIXER_SCHN_FRONT_LEFT, &unmuted);
-        }
-
-        if (!unmuted)
-            return -1; // 静音
-
-        int64_t min, max, volume;
-        snd_mixer_selem_get_playback_volume_range(elem_, &min, &max);
-        snd_mixer_selem_get_playback_volume(elem_, SND_MIXER_SCHN_FRONT_LEFT, &volume);
-
-        if (max > min) {
-            volume = (volume - min) * 100 / (max - min);
-        } else {
-            volume = 0;
-        }
-
-        return volume;
-    }
-
-    std::optional<int64_t> getCaptureVolume() {
-        if (!handle_ || !elem_)
-            return std::nullopt;
-
-        int unmuted = 1;
-        if (snd_mixer_selem_has_capture_switch(elem_)) {
-            snd_mixer_selem_get_capture_switch(elem_, SND_MIXER_SCHN_FRONT_LEFT, &unmuted);
-        }
-
-        if (!unmuted)
-            return -1; // 静音
-
-        int64_t min, max, volume;
-        snd_mixer_selem_get_capture_volume_range(elem_, &min, &max);
-        snd_mixer_selem_get_capture_volume(elem_, SND_MIXER_SCHN_FRONT_LEFT, &volume);
-
-        if (max > min) {
-            volume = (volume - min) * 100 / (max - min);
-        } else {
-            volume = 0;
-        }
-
-        return volume;
-    }
-
-    void handleEvents() {
-        if (handle_) {
-            snd_mixer_handle_events(handle_.get());
-        }
-    }
+// AudioModule基类实现
+AudioModule::AudioModule(const std::string &name, const std::string &element_name, bool capture)
+    : Module(name), element_name_(element_name), capture_(capture) {
+    // 音频模块不基于时间间隔更新，而是基于混音器元素回调
+    setInterval(0);
 
-    bool isValid() const {
-        return handle_ && elem_;
-    }
+    // 加载混音器可能阻塞，在工作线程中进行，期间显示占位图标
+    setAsyncStart(true);
+    setOutput("󰝟", Color::DEACTIVE);
+}
 
-    snd_mixer_t *getHandle() const {
-        return handle_.get();
+AudioModule::~AudioModule() {
+    if (mixer_) {
+        mixer_->unsubscribe(element_name_, this);
     }
-    int getFd() const {
-        if (!handle_)
-            return -1;
-        struct pollfd pfd;
-        if (snd_mixer_poll_descriptors(handle_.get(), &pfd, 1) == 1) {
-            return pfd.fd;
-        }
-        return -1;
-    }
-};
-
-// 音量模块的图标定义
-const std::vector<std::string> VolumeModule::volume_icons_ = {"󰕿", "󰖀", "󰕾", "󰝝"};
-
-// 麦克风模块的图标定义
-const std::vector<std::string> MicrophoneModule::microphone_icons_ = {
-    "󰍮", "󰢳", "󰍬", "󰢴"
-};
-
-// AudioModule基类实现
-AudioModule::AudioModule(const std::string &name, const std::string &element_name)
-    : Module(name), mixer_handle_(nullptr, &snd_mixer_close), element_name_(element_name),
-      mixer_elem_(nullptr), mixer_fd_(-1),
-      mixer_wrapper_(std::make_unique<AlsaMixerWrapper>(element_name)) {
-    // 音频模块默认不基于时间间隔更新，而是基于ALSA事件
-    setInterval(0);
 }
 
-AudioModule::~AudioModule() = default;
+void AudioModule::start() {
+    // 两个音频模块共享同一个预先加载的句柄
+    AlsaMixerHub::preload("default");
+}
 
 void AudioModule::init() {
-    if (!mixer_wrapper_->initialize()) {
-        // 如果初始化失败，设置一个错误输出
-        setOutput("󰝟", Color::DEACTIVE);
-        // 设置一个时间间隔以便稍后重试
-        setInterval(1);
+    System *system = getSystem();
+    if (!system) {
+        std::cerr << getName() << ": System pointer is null, mixer unavailable" << std::endl;
         return;
     }
 
-    // 获取ALSA混音器的文件描述符
-    if (mixer_wrapper_->isValid()) {
-        int fd = mixer_wrapper_->getFd();
-        if (fd >= 0) {
-            mixer_fd_ = fd;
-            setFd(mixer_fd_); // 设置文件描述符，System会将其添加到epoll
-            std::cerr << "AudioModule " << getName() << " registered fd " << mixer_fd_
-                      << " for epoll" << std::endl;
-        } else {
-            std::cerr << "Failed to get poll descriptors for " << getName() << std::endl;
-        }
-    }
+    // 同一声卡的所有音频模块共享一个混音器连接
+    mixer_ = AlsaMixerHub::acquire(*system, "default");
+    mixer_->subscribe(element_name_, this);
 }
 
 void AudioModule::update() {
     try {
-        if (!mixer_wrapper_->isValid()) {
-            // 如果混音器未初始化，尝试重新初始化
-            if (!mixer_wrapper_->initialize()) {
-                setOutput("󰝟", Color::DEACTIVE);
-                setInterval(1); // 设置重试间隔
-                return;
-            }
-        }
-
-        // 处理ALSA混音器事件
-        handleMixerEvents();
-
         // 获取音量值
         int64_t volume = getVolume();
 
         if (volume == -2) {
-            // 设备未激活，需要重新加载
-            cleanupMixer();
+            // 元素不可用，等待混音器重新连接后的回调
             setOutput("󰝟", Color::DEACTIVE);
-            setInterval(1); // 设置重试间隔
         } else if (volume == -1) {
             // 静音状态
             setOutput(getVolumeIcon(volume), Color::IDLE);
@@ -197,52 +56,69 @@ void AudioModule::update() {
             // 正常状态，格式化输出
             std::string output = formatOutput(volume);
             setOutput(output, Color::IDLE);
-            setInterval(0); // 取消时间间隔更新
         }
     } catch (const std::exception &e) {
         std::cerr << "AudioModule update error: " << e.what() << std::endl;
         setOutput("󰝟", Color::DEACTIVE);
-        setInterval(1); // 设置重试间隔
     }
 }
 
-void AudioModule::handleClick(uint64_t button) {
-    (void)button; // 避免未使用参数警告
+std::optional<int64_t> AudioModule::readVolume() const {
+    if (!mixer_) {
+        return std::nullopt;
+    }
+    return mixer_->getVolume(element_name_, capture_);
+}
+
+void AudioModule::onMixerElementChanged() {
+    requestUpdate();
+}
+
+void AudioModule::onMixerElementLost() {
+    // 丢弃尚未写入的操作，设备恢复后不再重放
+    pending_steps_ = 0;
+    pending_mute_toggle_ = false;
+    setOutput("󰝟", Color::DEACTIVE);
+}
 
-    const auto executeCommand = [this](const std::string &cmd) {
-        std::cerr << getName() << ": Executing: " << cmd << std::endl;
-        int result = system((cmd + " &").c_str());
-        std::cerr << getName() << ": Command result: " << result << std::endl;
+void AudioModule::handleClick(uint64_t button) {
+    const auto executeCommand = [this](std::vector<std::string> argv) {
+        if (System *system = getSystem()) {
+            system->getLauncher().spawn(getName(), std::move(argv));
+        }
+    };
+    const auto executeVolumeCommand = [&](const char *action) {
+        std::vector<std::string> argv = Launcher::splitCommand(volume_command_);
+        argv.emplace_back(action);
+        executeCommand(std::move(argv));
     };
 
     switch (button) {
     case 2: // 中键点击 - 打开音量控制
-        if (getName() == "volume") {
-            executeCommand("pavucontrol -t 3");
-        } else if (getName() == "microphone") {
-            executeCommand("pavucontrol -t 4");
-        }
+        executeCommand({"pavucontrol", "-t", capture_ ? "4" : "3"});
         break;
     case 3: // 右键点击 - 切换静音
-        if (getName() == "volume") {
-            executeCommand("~/.bin/wm/volume t");
-        } else if (getName() == "microphone") {
-            executeCommand("~/.bin/wm/volume m t");
+        if (!volume_command_.empty()) {
+            executeVolumeCommand("t");
+        } else {
+            pending_mute_toggle_ = !pending_mute_toggle_;
+            requestFlush();
         }
-        // ALSA事件会自动触发update()，无需轮询
         break;
     case 4: // 上滚 - 增加音量
-        if (getName() == "volume") {
-            executeCommand("~/.bin/wm/volume i");
-        } else if (getName() == "microphone") {
-            executeCommand("~/.bin/wm/volume m i");
+        if (!volume_command_.empty()) {
+            executeVolumeCommand("i");
+        } else {
+            ++pending_steps_;
+            requestFlush();
         }
         break;
     case 5: // 下滚 - 减少音量
-        if (getName() == "volume") {
-            executeCommand("~/.bin/wm/volume d");
-        } else if (getName() == "microphone") {
-            executeCommand("~/.bin/wm/volume m d");
+        if (!volume_command_.empty()) {
+            executeVolumeCommand("d");
+        } else {
+            --pending_steps_;
+            requestFlush();
         }
         break;
     default:
@@ -250,6 +126,42 @@ void AudioModule::handleClick(uint64_t button) {
     }
 }
 
+void AudioModule::flush() {
+    // 一帧内的多次滚动合并为一次混音器写入
+    const int64_t steps = pending_steps_;
+    const bool toggle_mute = pending_mute_toggle_;
+    pending_steps_ = 0;
+    pending_mute_toggle_ = false;
+
+    if (!mixer_ || !mixer_->hasElement(element_name_)) {
+        return;
+    }
+
+    bool changed = false;
+    if (toggle_mute) {
+        changed = mixer_->toggleMute(element_name_, capture_) || changed;
+    }
+    if (steps != 0) {
+        changed = mixer_->changeVolume(
+                      element_name_, capture_, steps * static_cast<int64_t>(volume_step_)
+                  ) ||
+                  changed;
+    }
+
+    // 本地元素值已更新，立即刷新显示，无需等待ALSA事件
+    if (changed) {
+        requestUpdate();
+    }
+}
+
+void AudioModule::setVolumeStep(uint64_t step) {
+    volume_step_ = std::clamp<uint64_t>(step, 1, 100);
+}
+
+void AudioModule::setVolumeCommand(const std::string &command) {
+    volume_command_ = command;
+}
+
 std::string AudioModule::formatOutput(int64_t volume) {
     std::ostringstream output;
     output << getVolumeIcon(volume) << " ";
@@ -265,23 +177,11 @@ std::string AudioModule::formatOutput(int64_t volume) {
     return output.str();
 }
 
-bool AudioModule::initializeMixer() {
-    return mixer_wrapper_->initialize();
-}
-
-void AudioModule::cleanupMixer() {
-    mixer_wrapper_.reset();
-}
-
-void AudioModule::handleMixerEvents() {
-    mixer_wrapper_->handleEvents();
-}
-
 // VolumeModule实现
-VolumeModule::VolumeModule() : AudioModule("volume", "Master") {}
+VolumeModule::VolumeModule() : AudioModule("volume", "Master", false) {}
 
 int64_t VolumeModule::getVolume() {
-    auto volume_opt = mixer_wrapper_->getPlaybackVolume();
+    auto volume_opt = readVolume();
     if (!volume_opt) {
         std::cerr << "Volume: Failed to get volume" << std::endl;
         return -2;
@@ -298,7 +198,7 @@ int64_t VolumeModule::getVolume() {
     return (volume + 1) / 5; // 返回0-20范围的值，用于图标选择
 }
 
-std::string VolumeModule::getVolumeIcon(int64_t volume) {
+std::string_view VolumeModule::getVolumeIcon(int64_t volume) {
     if (volume == -1) {
         return "󰸈"; // 静音图标
     }
@@ -306,10 +206,10 @@ std::string VolumeModule::getVolumeIcon(int64_t volume) {
     // 将0-20映射到图标索引
     size_t icon_index = 0;
     if (volume > 0) {
-        icon_index = std::min(static_cast<size_t>((volume + 4) / 5), volume_icons_.size() - 1);
+        icon_index = std::min(static_cast<size_t>((volume + 4) / 5), icons::VOLUME.size() - 1);
     }
 
-    return volume_icons_[icon_index];
+    return icons::VOLUME[icon_index];
 }
 
 std::string VolumeModule::formatOutput(int64_t volume) {
@@ -331,10 +231,10 @@ std::string VolumeModule::formatOutput(int64_t volume) {
 }
 
 // MicrophoneModule实现
-MicrophoneModule::MicrophoneModule() : AudioModule("microphone", "Capture") {}
+MicrophoneModule::MicrophoneModule() : AudioModule("microphone", "Capture", true) {}
 
 int64_t MicrophoneModule::getVolume() {
-    auto volume_opt = mixer_wrapper_->getCaptureVolume();
+    auto volume_opt = readVolume();
     if (!volume_opt) {
         std::cerr << "Microphone: Failed to get volume" << std::endl;
         return -2;
@@ -351,7 +251,7 @@ int64_t MicrophoneModule::getVolume() {
     return (volume + 1) / 5; // 返回0-20范围的值，用于图标选择
 }
 
-std::string MicrophoneModule::getVolumeIcon(int64_t volume) {
+std::string_view MicrophoneModule::getVolumeIcon(int64_t volume) {
     if (volume == -1) {
         return "󰍭"; // 静音图标
     }
@@ -359,10 +259,10 @@ std::string MicrophoneModule::getVolumeIcon(int64_t volume) {
     // 将0-20映射到图标索引
     size_t icon_index = 0;
     if (volume > 0) {
-        icon_index = std::min(static_cast<size_t>((volume + 4) / 5), microphone_icons_.size() - 1);
+        icon_index = std::min(static_cast<size_t>((volume + 4) / 5), icons::MICROPHONE.size() - 1);
     }
 
-    return microphone_icons_[icon_index];
+    return icons::MICROPHONE[icon_index];
 }
 
 std::string MicrophoneModule::formatOutput(int64_t volume) {
@@ -1,25 +1,17 @@
 #include "modules/backlight.h"
+#include "icons.h"
+#include "system.h"
 #include <sys/inotify.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cerrno>
 #include <cstring>
 #include <algorithm>
-#include <iomanip>
 #include <iostream>
-#include <sstream>
 
-// 静态成员定义
-const std::string BacklightModule::BRIGHTNESS_PATH = "/sys/class/backlight/amdgpu_bl1/brightness";
-const std::string BacklightModule::MAX_BRIGHTNESS_PATH =
-    "/sys/class/backlight/amdgpu_bl1/max_brightness";
-
-const std::vector<std::string> BacklightModule::brightness_icons_ = {"", "", "", "",
-                                                                     "", "", "", "",
-                                                                     "", "", "", "",
-                                                                     "", "", ""};
-
-BacklightModule::BacklightModule() : Module("backlight") {
+BacklightModule::BacklightModule(const std::string &device)
+    : Module("backlight"), brightness_path_(device + "/brightness"),
+      max_brightness_(device + "/max_brightness") {
     // 背光模块默认不基于时间间隔更新，而是基于inotify事件
     setInterval(0);
 }
@@ -36,7 +28,7 @@ BacklightModule::~BacklightModule() {
 
 void BacklightModule::init() {
     // 初始化inotify
-    inotify_fd_ = inotify_init1(IN_NONBLOCK);
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
     if (inotify_fd_ == -1) {
         std::cerr << "Failed to initialize inotify: " << strerror(errno) << std::endl;
         setOutput("󰛨", Color::DEACTIVE);
@@ -45,9 +37,9 @@ void BacklightModule::init() {
     }
 
     // 添加需要监控的文件
-    watch_fd_ = inotify_add_watch(inotify_fd_, BRIGHTNESS_PATH.c_str(), IN_MODIFY);
+    watch_fd_ = inotify_add_watch(inotify_fd_, brightness_path_.c_str(), IN_MODIFY);
     if (watch_fd_ == -1) {
-        std::cerr << "Failed to add watch for " << BRIGHTNESS_PATH << ": " << strerror(errno)
+        std::cerr << "Failed to add watch for " << brightness_path_ << ": " << strerror(errno)
                   << std::endl;
         close(inotify_fd_);
         inotify_fd_ = -1;
@@ -65,59 +57,69 @@ void BacklightModule::init() {
 }
 
 void BacklightModule::update() {
-    try {
-        // 读取inotify事件
-        if (inotify_fd_ != -1) {
-            char buffer[1024];
-            ssize_t len = read(inotify_fd_, buffer, sizeof(buffer));
-            if (len == -1 && errno != EAGAIN) {
-                std::cerr << "Error reading inotify events: " << strerror(errno) << std::endl;
-                return;
-            }
+    // 读取inotify事件
+    if (inotify_fd_ != -1) {
+        char buffer[1024];
+        ssize_t len = read(inotify_fd_, buffer, sizeof(buffer));
+        if (len == -1 && errno != EAGAIN) {
+            std::cerr << "Error reading inotify events: " << strerror(errno) << std::endl;
+            return;
         }
+    }
 
-        // 获取背光亮度百分比
-        uint64_t brightness_percent = getBrightnessPercent();
-
-        // 格式化输出
-        std::string output = formatOutput(brightness_percent);
-
-        // 设置输出
-        setOutput(output, Color::IDLE);
-
-    } catch (const std::exception &e) {
-        std::cerr << "BacklightModule update error: " << e.what() << std::endl;
-        setOutput("󰛨", Color::DEACTIVE);
+    // 获取背光亮度百分比
+    const Result<uint64_t> brightness_percent = getBrightnessPercent();
+    if (!brightness_percent) {
+        // 数据源按退避间隔重新探测，轮询本身几乎没有开销
+        setUnavailable("󰛨");
         setInterval(1); // 设置重试间隔
+        return;
     }
+
+    // 格式化输出
+    FormatBuffer buffer;
+    formatOutput(buffer, *brightness_percent);
+
+    // 设置输出
+    setOutput(buffer.view(), Color::IDLE);
 }
 
 void BacklightModule::handleClick(uint64_t button) {
     switch (button) {
     case 4: // 上滚 - 增加背光
         std::cerr << "Backlight: Increasing brightness" << std::endl;
-        system("~/.bin/wm/backlight i >/dev/null &");
+        if (System *system = getSystem()) {
+            system->getLauncher().spawn(getName(), {"~/.bin/wm/backlight", "i"});
+        }
         break;
     case 5: // 下滚 - 减少背光
         std::cerr << "Backlight: Decreasing brightness" << std::endl;
-        system("~/.bin/wm/backlight d >/dev/null &");
+        if (System *system = getSystem()) {
+            system->getLauncher().spawn(getName(), {"~/.bin/wm/backlight", "d"});
+        }
         break;
     default:
         break;
     }
 }
 
-uint64_t BacklightModule::getBrightnessPercent() {
+Result<uint64_t> BacklightModule::getBrightnessPercent() {
     // 读取当前亮度值
-    uint64_t brightness = readUint64File(BRIGHTNESS_PATH);
-    uint64_t max_brightness = readUint64File(MAX_BRIGHTNESS_PATH);
+    const Result<uint64_t> brightness = brightness_.readUint64();
+    if (!brightness) {
+        return brightness.error();
+    }
+    const Result<uint64_t> max_brightness = max_brightness_.readUint64();
+    if (!max_brightness) {
+        return max_brightness.error();
+    }
 
-    if (max_brightness == 0) {
-        return 0;
+    if (*max_brightness == 0) {
+        return uint64_t{0};
     }
 
     // 计算百分比
-    uint64_t brightness_percent = brightness * 100 / max_brightness;
+    uint64_t brightness_percent = *brightness * 100 / *max_brightness;
     if (brightness_percent > 100) {
         brightness_percent = 100;
     }
@@ -128,30 +130,10 @@ uint64_t BacklightModule::getBrightnessPercent() {
     return brightness_percent;
 }
 
-std::string BacklightModule::getBrightnessIcon(uint64_t brightness_percent) {
-    if (brightness_icons_.empty()) {
-        return "󰛨";
-    }
-
-    // 根据亮度百分比选择图标
-    size_t idx = brightness_icons_.size() * brightness_percent / 101;
-    if (idx >= brightness_icons_.size()) {
-        idx = brightness_icons_.size() - 1;
-    }
-
-    return brightness_icons_[idx];
+std::string_view BacklightModule::getBrightnessIcon(uint64_t brightness_percent) {
+    return pickIcon(icons::BRIGHTNESS, static_cast<double>(brightness_percent));
 }
 
-std::string BacklightModule::formatOutput(uint64_t brightness_percent) {
-    std::ostringstream output;
-    output << getBrightnessIcon(brightness_percent) << "\u2004";
-
-    // 格式化百分比显示
-    if (brightness_percent == 100) {
-        output << std::setw(3) << brightness_percent << "%";
-    } else {
-        output << std::setw(2) << brightness_percent << "%";
-    }
-
-    return output.str();
-}
\ No newline at end of file
+std::string_view BacklightModule::formatOutput(FormatBuffer &buffer, uint64_t brightness_percent) {
+    return format_.render(buffer, getBrightnessIcon(brightness_percent), brightness_percent);
+}
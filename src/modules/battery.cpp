@@ -1,23 +1,58 @@
 #include "modules/battery.h"
+#include "icons.h"
+#include "system.h"
 #include <iostream>
-#include <sstream>
-#include <iomanip>
 #include <system_error>
 #include <cstring>
 
-BatteryModule::BatteryModule() : Module("battery"), detailed_mode_(false) {
+namespace {
+
+// 输出模板的字段，依次为图标颜色、图标、文字颜色、百分比、能量、功率、剩余小时和分钟
+constexpr std::string_view FORMAT_FIELDS[] = {"icon_color", "icon",  "color", "percentage",
+                                              "energy",     "rate",  "hours", "minutes"};
+
+constexpr std::string_view SIMPLE_FORMAT =
+    "<span color='{icon_color}'>{icon}</span>\u2004<span color='{color}'>{percentage}%</span>";
+constexpr std::string_view DETAILED_FORMAT =
+    "<span color='{icon_color}'>{icon}</span>\u2004<span color='{color}'>{energy:.1f}Wh</span>";
+
+} // namespace
+
+BatteryModule::BatteryModule()
+    : Module("battery"), detailed_mode_(false), simple_format_(SIMPLE_FORMAT, FORMAT_FIELDS),
+      simple_time_format_(
+          std::string(SIMPLE_FORMAT) + "\u2004({hours}:{minutes:02d})", FORMAT_FIELDS
+      ),
+      detailed_format_(DETAILED_FORMAT, FORMAT_FIELDS),
+      detailed_rate_format_(std::string(DETAILED_FORMAT) + "\u2004({rate:.1f}W)", FORMAT_FIELDS) {
     // 电池模块默认不基于时间间隔更新，而是基于DBus事件
     setInterval(0);
+
+    // 建立D-Bus连接可能阻塞，在工作线程中进行，期间显示占位图标
+    setAsyncStart(true);
+    setOutput("󱠵", Color::DEACTIVE);
 }
 
 BatteryModule::~BatteryModule() {
-    // sdbus-c++连接会自动清理
+    // sdbus-c++连接会自动清理，只需注销监听
+    if (dbus_fd_ != -1) {
+        if (System *system = getSystem()) {
+            system->unwatchFd(dbus_fd_);
+        }
+    }
+}
+
+void BatteryModule::start() {
+    // 在工作线程中执行，失败时由System记录异常，init()显示占位内容
+    setupDBusConnection();
+    setupDBusMonitoring();
 }
 
 void BatteryModule::init() {
     try {
-        setupDBusConnection();
-        setupDBusMonitoring();
+        if (!connection_ || !upowerProxy_) {
+            throw std::runtime_error("DBus connection not available");
+        }
 
         // 获取DBus文件描述符并添加到epoll
         auto pollData = connection_->getEventLoopPollData();
@@ -27,12 +62,17 @@ void BatteryModule::init() {
             throw std::runtime_error("Failed to get DBus file descriptor");
         }
 
-        // 设置文件描述符，System会将其添加到epoll
-        setFd(dbus_fd);
+        // 连接可读时只处理事件，信号和异步回复各自决定是否需要重新获取
+        System *system = getSystem();
+        if (!system ||
+            !system->watchFd(dbus_fd, EPOLLIN, [this](uint32_t) { processEvents(); })) {
+            throw std::runtime_error("Failed to watch DBus file descriptor");
+        }
+        dbus_fd_ = dbus_fd;
         std::cerr << "BatteryModule registered fd " << dbus_fd << " for epoll" << std::endl;
 
         // 立即更新一次
-        update();
+        requestRefresh();
     } catch (const std::exception &e) {
         std::cerr << "BatteryModule init error: " << e.what() << std::endl;
         setOutput("󱠵", Color::DEACTIVE);
@@ -95,47 +135,138 @@ void BatteryModule::setupDBusMonitoring() {
 }
 
 void BatteryModule::update() {
+    // 初始化、重试、刷新信号和恢复显示时重新获取一次
+    requestRefresh();
+}
+
+void BatteryModule::processEvents() {
+    if (!connection_) {
+        return;
+    }
+
+    TraceSpan span(TraceKind::DBUS, getId());
     try {
-        // 处理所有待处理的DBus事件
-        if (connection_) {
-            while (connection_->processPendingEvent()) {
-                // 处理所有待处理的事件
-            }
+        // 处理所有待处理的DBus事件，信号处理函数和异步回复在这里被调用
+        while (connection_->processPendingEvent()) {
         }
+    } catch (const std::exception &e) {
+        std::cerr << "BatteryModule: Failed to process DBus events: " << e.what() << std::endl;
+    }
+}
 
-        // 获取电池信息
-        BatteryState state = BatteryState::UNKNOWN;
-        double percentage = 0.0;
-        int64_t time = -1;
-        double energy = 0.0;
-        double energy_rate = 0.0;
+void BatteryModule::requestRefresh() {
+    if (!upowerProxy_) {
+        std::cerr << "BatteryModule update error: DBus proxy not available" << std::endl;
+        setOutput("󱠵", Color::DEACTIVE);
+        setInterval(1); // 设置重试间隔
+        return;
+    }
 
-        getBatteryInfo(state, percentage, time, energy, energy_rate);
+    if (refreshing_) {
+        refresh_again_ = true;
+        return;
+    }
 
-        // 格式化输出
-        std::string output =
-            formatOutput(state, static_cast<uint64_t>(percentage), energy, energy_rate, time);
+    if (System *system = getSystem()) {
+        system->getTaskScheduler().spawn(refresh(), getName());
+    }
+}
 
-        // 设置输出
-        setOutput(output, Color::IDLE);
+// GCC为协程生成的状态机代码会误报这两个警告
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wswitch-default"
+#pragma GCC diagnostic ignored "-Wzero-as-null-pointer-constant"
+Task<> BatteryModule::refresh() {
+    refreshing_ = true;
+    try {
+        do {
+            refresh_again_ = false;
+
+            // 一次GetAll代替逐个同步读取属性，等待回复期间事件循环照常运行
+            auto reply = co_await dbusCall<std::map<std::string, sdbus::Variant>>(
+                *upowerProxy_, PROPERTIES_INTERFACE, "GetAll", DEVICE_INTERFACE
+            );
+            if (!reply) {
+                std::cerr << "BatteryModule update error: Failed to get battery properties: "
+                          << reply.error->getMessage() << std::endl;
+                setOutput("󱠵", Color::DEACTIVE);
+                setInterval(1); // 设置重试间隔
+                break;
+            }
 
+            applyProperties(reply.get<0>());
+            setInterval(0); // 恢复后不再需要重试
+            render();
+        } while (refresh_again_);
     } catch (const std::exception &e) {
-        std::cerr << "BatteryModule update error: " << e.what() << std::endl;
+        std::cerr << "BatteryModule update error: Error extracting property value: " << e.what()
+                  << std::endl;
         setOutput("󱠵", Color::DEACTIVE);
-        setInterval(1); // 设置重试间隔
+        setInterval(1);
+    }
+    refreshing_ = false;
+}
+#pragma GCC diagnostic pop
+
+void BatteryModule::applyProperties(const std::map<std::string, sdbus::Variant> &properties) {
+    // 缺少的属性保持默认值
+    auto read = [&](const std::string &name, auto fallback) {
+        const auto it = properties.find(name);
+        return it == properties.end() ? fallback : it->second.get<decltype(fallback)>();
+    };
+
+    BatteryInfo info;
+    info.state = static_cast<BatteryState>(read("State", uint32_t{0}));
+    info.percentage = read("Percentage", 0.0);
+    info.energy = read("Energy", 0.0);
+    info.energy_rate = read("EnergyRate", 0.0);
+
+    // 根据状态获取时间信息
+    switch (info.state) {
+    case BatteryState::CHARGING:
+        info.time = read("TimeToFull", int64_t{-1});
+        break;
+    case BatteryState::DISCHARGING:
+        info.time = read("TimeToEmpty", int64_t{-1});
+        break;
+    case BatteryState::UNKNOWN:
+    case BatteryState::EMPTY:
+    case BatteryState::FULLY_CHARGED:
+    case BatteryState::PENDING_CHARGE:
+    case BatteryState::PENDING_DISCHARGE:
+    default:
+        info.time = -1;
+        break;
     }
+
+    info_ = info;
+    has_info_ = true;
+}
+
+void BatteryModule::render() {
+    if (!has_info_) {
+        return;
+    }
+
+    // 格式化输出
+    FormatBuffer buffer;
+    formatOutput(buffer, info_.state, static_cast<uint64_t>(info_.percentage), info_.energy,
+                 info_.energy_rate, info_.time);
+    setOutput(buffer.view(), Color::IDLE);
 }
 
 void BatteryModule::handleClick(uint64_t button) {
     switch (button) {
     case 2: // 中键 - 打开电源统计
         std::cerr << "Battery: Opening power statistics" << std::endl;
-        system("gnome-power-statistics >/dev/null 2>&1 &");
+        if (System *system = getSystem()) {
+            system->getLauncher().spawn(getName(), {"gnome-power-statistics"});
+        }
         break;
     case 3: // 右键 - 切换显示模式
         std::cerr << "Battery: Toggling display mode" << std::endl;
         detailed_mode_ = !detailed_mode_;
-        update();
+        render(); // 只切换显示，不必重新获取
         break;
     default:
         break;
@@ -157,7 +288,7 @@ void BatteryModule::onPropertiesChanged(
                 name == "EnergyRate" || name == "TimeToFull" || name == "TimeToEmpty") {
                 std::cerr << "BatteryModule: Relevant property changed: " << name << std::endl;
                 // 触发更新
-                update();
+                requestRefresh();
                 break;
             }
         }
@@ -167,156 +298,56 @@ void BatteryModule::onPropertiesChanged(
 void BatteryModule::onDeviceChanged() {
     std::cerr << "BatteryModule: Device state changed" << std::endl;
     // 设备状态变化，触发更新
-    update();
-}
-
-void BatteryModule::getBatteryInfo(
-    BatteryState &state, double &percentage, int64_t &time, double &energy, double &energy_rate
-) {
-    if (!upowerProxy_) {
-        throw std::runtime_error("DBus proxy not available");
-    }
-
-    try {
-        // 获取电池状态
-        auto stateVar = upowerProxy_->getProperty("State").onInterface(DEVICE_INTERFACE);
-        uint32_t state_uint = stateVar.get<uint32_t>();
-        state = static_cast<BatteryState>(state_uint);
-
-        // 获取电池信息
-        auto percentageVar = upowerProxy_->getProperty("Percentage").onInterface(DEVICE_INTERFACE);
-        percentage = percentageVar.get<double>();
-
-        auto energyVar = upowerProxy_->getProperty("Energy").onInterface(DEVICE_INTERFACE);
-        energy = energyVar.get<double>();
-
-        auto energyRateVar = upowerProxy_->getProperty("EnergyRate").onInterface(DEVICE_INTERFACE);
-        energy_rate = energyRateVar.get<double>();
-
-        // 根据状态获取时间信息
-        switch (state) {
-        case BatteryState::CHARGING:
-            try {
-                auto timeToFullVar =
-                    upowerProxy_->getProperty("TimeToFull").onInterface(DEVICE_INTERFACE);
-                time = timeToFullVar.get<int64_t>();
-                std::cerr << "BatteryModule: Time to full: " << time << " seconds" << std::endl;
-            } catch (...) {
-                std::cerr << "BatteryModule: Failed to get time to full, setting to -1"
-                          << std::endl;
-                time = -1;
-            }
-            break;
-        case BatteryState::DISCHARGING:
-            try {
-                auto timeToEmptyVar =
-                    upowerProxy_->getProperty("TimeToEmpty").onInterface(DEVICE_INTERFACE);
-                time = timeToEmptyVar.get<int64_t>();
-                std::cerr << "BatteryModule: Time to empty: " << time << " seconds" << std::endl;
-            } catch (...) {
-                std::cerr << "BatteryModule: Failed to get time to empty, setting to -1"
-                          << std::endl;
-                time = -1;
-            }
-            break;
-        default:
-            std::cerr << "BatteryModule: Battery state not charging/discharging, setting time to -1"
-                      << std::endl;
-            time = -1;
-            break;
-        }
-
-    } catch (const sdbus::Error &e) {
-        throw std::runtime_error(
-            "Failed to get battery properties: " + std::string(e.getMessage())
-        );
-    } catch (const std::exception &e) {
-        throw std::runtime_error("Error extracting property value: " + std::string(e.what()));
-    }
+    requestRefresh();
 }
 
-std::string BatteryModule::getBatteryIcon(BatteryState state, uint64_t percentage) {
+std::string_view BatteryModule::getBatteryIcon(BatteryState state, uint64_t percentage) {
     switch (state) {
     case BatteryState::CHARGING:
-    case BatteryState::FULLY_CHARGED: {
-        if (charging_icons_.empty()) {
-            return "󰂅";
-        }
-        size_t idx = charging_icons_.size() * percentage / 101;
-        if (idx >= charging_icons_.size()) {
-            idx = charging_icons_.size() - 1;
-        }
-        return charging_icons_[idx];
-    }
+    case BatteryState::FULLY_CHARGED:
+        return pickIcon(icons::BATTERY_CHARGING, static_cast<double>(percentage));
     case BatteryState::DISCHARGING:
-    case BatteryState::EMPTY: {
-        if (discharging_icons_.empty()) {
-            return "󰁹";
-        }
-        size_t idx = discharging_icons_.size() * percentage / 101;
-        if (idx >= discharging_icons_.size()) {
-            idx = discharging_icons_.size() - 1;
-        }
-        return discharging_icons_[idx];
-    }
+    case BatteryState::EMPTY:
+        return pickIcon(icons::BATTERY_DISCHARGING, static_cast<double>(percentage));
+    case BatteryState::UNKNOWN:
+    case BatteryState::PENDING_CHARGE:
+    case BatteryState::PENDING_DISCHARGE:
     default: // 同步中或未知状态
         return "󱠵";
     }
 }
 
-std::string BatteryModule::formatTime(int64_t seconds) {
-    if (seconds <= 0) {
-        return "";
-    }
-
-    uint64_t hours = static_cast<uint64_t>(seconds) / 3600;
-    uint64_t minutes = (static_cast<uint64_t>(seconds) - hours * 3600) / 60;
-
-    std::ostringstream oss;
-    oss << "(" << hours << ":" << std::setw(2) << std::setfill('0') << minutes << ")";
-    return oss.str();
-}
-
-std::string BatteryModule::formatOutput(
-    BatteryState state, uint64_t percentage, double energy, double energy_rate, int64_t time
+std::string_view BatteryModule::formatOutput(
+    FormatBuffer &buffer, BatteryState state, uint64_t percentage, double energy,
+    double energy_rate, int64_t time
 ) {
-    std::ostringstream output;
-
     // 确定颜色
-    Color color = Color::IDLE;
-    if (percentage < 20) {
-        color = Color::CRITICAL;
-    } else if (percentage < 40) {
-        color = Color::WARNING;
-    }
+    const Color color = pickColor(thresholds::BATTERY, static_cast<double>(percentage));
 
-    // 输出图标
-    std::string icon = getBatteryIcon(state, percentage);
+    // 图标颜色
+    Color icon_color = color;
     if (state == BatteryState::CHARGING || state == BatteryState::FULLY_CHARGED) {
-        output << "<span color='" << getColorString(Color::GOOD) << "'>" << icon << "</span>";
+        icon_color = Color::GOOD;
     } else if (state == BatteryState::UNKNOWN || state == BatteryState::PENDING_CHARGE ||
                state == BatteryState::PENDING_DISCHARGE) {
-        output << "<span color='" << getColorString(Color::DEACTIVE) << "'>" << icon << "</span>";
-    } else {
-        output << "<span color='" << getColorString(color) << "'>" << icon << "</span>";
+        icon_color = Color::DEACTIVE;
     }
 
-    // 输出文字信息
-    if (detailed_mode_) {
-        // 详细模式：显示能量信息
-        output << "\u2004<span color='" << getColorString(color) << "'>" << std::fixed
-               << std::setprecision(1) << energy << "Wh</span>";
-        if (time > 0) {
-            output << "\u2004(" << std::fixed << std::setprecision(1) << energy_rate << "W)";
-        }
-    } else {
-        // 简单模式：显示百分比
-        output << "\u2004<span color='" << getColorString(color) << "'>" << percentage
-               << "%</span>";
-        if (time > 0) {
-            output << "\u2004" << formatTime(time);
-        }
+    // 剩余时间
+    uint64_t hours = 0;
+    uint64_t minutes = 0;
+    if (time > 0) {
+        hours = static_cast<uint64_t>(time) / 3600;
+        minutes = (static_cast<uint64_t>(time) - hours * 3600) / 60;
     }
 
-    return output.str();
-}
\ No newline at end of file
+    // 详细模式显示能量信息，简单模式显示百分比
+    const FormatTemplate *format = time > 0 ? &simple_time_format_ : &simple_format_;
+    if (detailed_mode_) {
+        format = time > 0 ? &detailed_rate_format_ : &detailed_format_;
+    }
+    return format->render(
+        buffer, getColorString(icon_color), getBatteryIcon(state, percentage),
+        getColorString(color), percentage, energy, energy_rate, hours, minutes
+    );
+}
@@ -1,13 +1,12 @@
 #include <cmath>
 #include <modules/cpu.h>
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include <icons.h>
 #include <string>
-#include <stdexcept>
-#include <algorithm> // 用于 std::clamp
 
-CpuModule::CpuModule() : Module("cpu") {
+CpuModule::CpuModule(PowerInterface power, const std::string &power_dir)
+    : Module("cpu"), power_(power), package_(power_dir + "/energy_uj"),
+      rapl_max_energy_range_source_(power_dir + "/max_energy_range_uj"),
+      svi2_core_(power_dir + "/power1_input"), svi2_soc_(power_dir + "/power2_input") {
     // CPU模块每秒钟更新一次
     setInterval(1);
 }
@@ -15,48 +14,40 @@ CpuModule::CpuModule() : Module("cpu") {
 CpuModule::~CpuModule() {}
 
 void CpuModule::update() {
-    try {
-        rapl_max_energy_range_ = readUint64File(RAPL_MAX_ENERGY_RANGE);
-        // 获取CPU使用率
-        double usage = getUsage();
-        usage = std::floor(usage * 100) / 100;
-
-        // 选择图标 (使用vector代替数组，更现代且易于扩展)
-        const std::vector<std::string> icons = {"󰾆", "󰾅", "󰓅"};
-        size_t icon_idx = static_cast<size_t>(static_cast<double>(icons.size()) * usage / 101);
-        icon_idx = std::clamp(icon_idx, size_t(0), icons.size() - 1);
-
-        // 构建输出字符串 (使用stringstream代替C风格的snprintf)
-        std::ostringstream output;
-        output << icons[icon_idx] << " ";
-
-        // 根据当前状态显示使用率或功率
-        if (getState()) {
-            // 显示功率
-            double power = getPower();
-            power = std::floor(power * 100) / 100;
-            output.precision(power < 10 ? 2 : 1);
-            output << std::fixed << power << "W";
-        } else {
-            // 显示使用率
-            output.precision(usage < 10 ? 2 : 1);
-            output << std::fixed << usage << "%";
-        }
-
-        // 选择颜色
-        Color color = Color::IDLE;
-        if (usage >= 60) {
-            color = Color::CRITICAL;
-        } else if (usage >= 30) {
-            color = Color::WARNING;
+    // 获取CPU使用率
+    const Result<double> sample = getUsage();
+    if (!sample) {
+        setUnavailable(UNAVAILABLE_TEXT);
+        return;
+    }
+    const double usage = std::floor(*sample * 100) / 100;
+
+    // 根据当前状态显示使用率或功率
+    const bool show_power = getState() != 0;
+    double value = usage;
+    if (show_power) {
+        const Result<double> power = getPower();
+        if (!power) {
+            setUnavailable(UNAVAILABLE_TEXT);
+            return;
         }
-
-        // 设置输出
-        setOutput(output.str(), color);
-
-    } catch (const std::exception &e) {
-        setOutput("󰓅 --.-", Color::DEACTIVE);
+        value = std::floor(*power * 100) / 100;
     }
+
+    // 图标和颜色由使用率决定，显示的数值只在显示精度内比较
+    const size_t icon_idx = pickIconIndex(icons::CPU, usage);
+    const Color color = pickColor(thresholds::CPU, usage);
+    const RenderKey key = RenderKey()
+                              .add(show_power)
+                              .add(icon_idx)
+                              .add(color)
+                              .add(value, adaptiveDecimals(value, 4, 2));
+
+    renderOutput(key, [&] {
+        const FormatTemplate &format = show_power ? power_format_ : usage_format_;
+        FormatBuffer buffer;
+        setOutput(format.render(buffer, icons::CPU[icon_idx], value), color);
+    });
 }
 
 void CpuModule::handleClick(uint64_t button) {
@@ -66,7 +57,7 @@ void CpuModule::handleClick(uint64_t button) {
         uint64_t old_state = getState();
         setState(old_state ^ 1);
 
-        update();
+        requestUpdate();
         break;
     }
     default:
@@ -75,25 +66,19 @@ void CpuModule::handleClick(uint64_t button) {
     }
 }
 
-double CpuModule::getUsage() {
-    std::ifstream file(PROC_STAT);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open " + std::string(PROC_STAT));
-    }
-
-    std::string line;
-    if (!std::getline(file, line)) {
-        throw std::runtime_error("Failed to read from " + std::string(PROC_STAT));
+Result<double> CpuModule::getUsage() {
+    const Result<std::string_view> stat = proc_stat_.read();
+    if (!stat) {
+        return stat.error();
     }
 
-    file.close();
-
+    // 缓冲区以'\0'结尾，只解析第一行
     uint64_t idx, nice, system, idle, iowait, irq, softirq;
     if (sscanf(
-            line.c_str(), "cpu %lu %lu %lu %lu %lu %lu %lu", &idx, &nice, &system, &idle, &iowait,
+            stat->data(), "cpu %lu %lu %lu %lu %lu %lu %lu", &idx, &nice, &system, &idle, &iowait,
             &irq, &softirq
         ) != 7) {
-        throw std::runtime_error("Failed to parse CPU stats");
+        return Error{Errc::PARSE};
     }
 
     uint64_t total = idx + nice + system + idle + iowait + irq + softirq;
@@ -113,12 +98,31 @@ double CpuModule::getUsage() {
     return cpu_usage;
 }
 
-double CpuModule::getPower() {
-    if (USE_RAPL) {
-        uint64_t energy = Module::readUint64File(PACKAGE);
+Result<double> CpuModule::getPower() {
+    if (power_ == PowerInterface::NONE) {
+        return Error{Errc::NOT_FOUND};
+    }
 
+    if (power_ == PowerInterface::RAPL) {
+        // 最大能量数值是常量，只需读取一次
+        if (rapl_max_energy_range_ == 0) {
+            const Result<uint64_t> range = rapl_max_energy_range_source_.readUint64();
+            if (!range) {
+                return range.error();
+            }
+            rapl_max_energy_range_ = *range;
+        }
+
+        const Result<uint64_t> sample = package_.readUint64();
+        if (!sample) {
+            return sample.error();
+        }
+        const uint64_t energy = *sample;
+
+        const auto now = std::chrono::steady_clock::now();
         if (prev_energy_ == 0) {
             prev_energy_ = energy;
+            prev_energy_time_ = now;
             return 0.0;
         }
 
@@ -128,13 +132,42 @@ double CpuModule::getPower() {
         } else {
             energy_diff = (rapl_max_energy_range_ - prev_energy_ + 1) + energy;
         }
-        double power = static_cast<double>(energy_diff) / 1e6; // 转换为焦耳/秒（瓦）
+        // 按实际间隔计算，基准来自快照时间隔可能超过1秒
+        const double seconds = std::chrono::duration<double>(now - prev_energy_time_).count();
+        double power = seconds > 0 ? static_cast<double>(energy_diff) / 1e6 / seconds
+                                   : 0.0; // 转换为焦耳/秒（瓦）
 
         prev_energy_ = energy;
+        prev_energy_time_ = now;
         return power;
     } else {
-        uint64_t uwatt_core = Module::readUint64File(SVI2_P_Core);
-        uint64_t uwatt_soc = Module::readUint64File(SVI2_P_SoC);
-        return static_cast<double>(uwatt_core + uwatt_soc) / 1e6; // 转换为瓦
+        const Result<uint64_t> uwatt_core = svi2_core_.readUint64();
+        const Result<uint64_t> uwatt_soc = svi2_soc_.readUint64();
+        if (!uwatt_core || !uwatt_soc) {
+            return (uwatt_core ? uwatt_soc : uwatt_core).error();
+        }
+        return static_cast<double>(*uwatt_core + *uwatt_soc) / 1e6; // 转换为瓦
+    }
+}
+
+void CpuModule::saveCounters(std::vector<uint64_t> &counters) const {
+    counters.push_back(prev_total_);
+    counters.push_back(prev_idle_);
+    counters.push_back(prev_energy_);
+    counters.push_back(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(prev_energy_time_.time_since_epoch())
+            .count()
+    ));
+}
+
+void CpuModule::restoreCounters(std::span<const uint64_t> counters) {
+    if (counters.size() != 4) {
+        return;
     }
+    prev_total_ = counters[0];
+    prev_idle_ = counters[1];
+    prev_energy_ = counters[2];
+    prev_energy_time_ = std::chrono::steady_clock::time_point(
+        std::chrono::nanoseconds(static_cast<int64_t>(counters[3]))
+    );
 }
@@ -1,4 +1,5 @@
 #include <modules/date.h>
+#include <system.h>
 #include <time.h>
 #include <iostream>
 
@@ -24,7 +25,9 @@ void DateModule::handleClick(uint64_t button) {
     switch (button) {
     case 2: // 中键点击
         // 在后台运行qjournalctl
-        system("qjournalctl &");
+        if (System *system = getSystem()) {
+            system->getLauncher().spawn(getName(), {"qjournalctl"});
+        }
         break;
     default:
         // 其他点击不做处理
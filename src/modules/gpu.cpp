@@ -1,62 +1,73 @@
 #include <modules/gpu.h>
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include <icons.h>
 #include <string>
-#include <stdexcept>
-#include <algorithm>
-#include <cmath>
 
-GpuModule::GpuModule() : Module("gpu") {
+GpuModule::GpuModule(const std::string &device)
+    : Module("gpu"), gpu_usage_(device + "/gpu_busy_percent"),
+      vram_used_(device + "/mem_info_vram_used") {
     // GPU模块每秒钟更新一次
     setInterval(1);
+    setBlockingSample(SAMPLE_TIMEOUT);
+    // 第一次采样完成前的占位内容
+    setOutput(UNAVAILABLE_TEXT, Color::DEACTIVE);
 }
 
 GpuModule::~GpuModule() {}
 
-void GpuModule::update() {
-    try {
-        // 获取GPU使用率
-        uint64_t usage = getGpuUsage();
+void GpuModule::sample() {
+    // 两个值都读取，切换显示模式时不必等待下一次采样
+    sampled_.usage = gpu_usage_.readUint64();
+    sampled_.vram = vram_used_.readUint64();
+}
 
-        // 构建输出字符串
-        std::ostringstream output;
-        output << "󰍹" << " ";
+void GpuModule::update() {
+    current_ = sampled_;
+    render();
+}
 
-        // 根据当前状态显示GPU使用率或显存占用
-        if (show_vram_) {
-            // 显示显存占用
-            uint64_t vram_used = getVramUsed();
-            char vram_str[6];
-            formatStorageUnits(vram_str, vram_used);
-            output << vram_str;
-        } else {
-            // 显示GPU使用率
-            output.width(usage < 100 ? 2 : 3);
-            output << usage << "%";
-        }
+void GpuModule::render() {
+    // 获取GPU使用率
+    if (!current_.usage) {
+        setUnavailable(UNAVAILABLE_TEXT);
+        return;
+    }
+    const uint64_t usage = *current_.usage;
 
-        // 选择颜色
-        Color color = Color::IDLE;
-        if (usage >= 60) {
-            color = Color::CRITICAL;
-        } else if (usage >= 30) {
-            color = Color::WARNING;
+    // 根据当前状态显示GPU使用率或显存占用
+    uint64_t vram_used = 0;
+    if (show_vram_) {
+        if (!current_.vram) {
+            setUnavailable(UNAVAILABLE_TEXT);
+            return;
         }
+        vram_used = *current_.vram;
+    }
+    const Color color = pickColor(thresholds::GPU, static_cast<double>(usage));
 
-        // 设置输出
-        setOutput(output.str(), color);
-
-    } catch (const std::exception &e) {
-        setOutput("󰍹 --.-", Color::DEACTIVE);
+    RenderKey key;
+    key.add(show_vram_).add(color);
+    if (show_vram_) {
+        key.addBytes(vram_used);
+    } else {
+        key.add(usage);
     }
+
+    renderOutput(key, [&] {
+        FormatBuffer buffer;
+        if (show_vram_) {
+            vram_format_.render(buffer, vram_used);
+        } else {
+            usage_format_.render(buffer, usage);
+        }
+        setOutput(buffer.view(), color);
+    });
 }
 
 void GpuModule::handleClick(uint64_t button) {
     switch (button) {
     case 3: { // 右键点击 - 切换显示模式（GPU使用率或显存占用）
         show_vram_ = !show_vram_;
-        update();
+        render(); // 采样可能正在进行，只渲染上一次的结果
         break;
     }
     default:
@@ -64,25 +75,3 @@ void GpuModule::handleClick(uint64_t button) {
         break;
     }
 }
-
-uint64_t GpuModule::getGpuUsage() {
-    return Module::readUint64File(GPU_USAGE);
-}
-
-uint64_t GpuModule::getVramUsed() {
-    return Module::readUint64File(VRAM_USED);
-}
-
-void GpuModule::formatStorageUnits(char *buffer, uint64_t bytes) {
-    const char *units[] = {"B", "K", "M", "G", "T", "P", "E"};
-    size_t unit_idx = 0;
-    double size = static_cast<double>(bytes);
-
-    while (size >= 1024.0 && unit_idx < sizeof(units) / sizeof(units[0]) - 1) {
-        size /= 1024.0;
-        unit_idx++;
-    }
-
-    // 格式化为两位小数
-    snprintf(buffer, 6, "%.2f%s", size, units[unit_idx]);
-}
\ No newline at end of file
@@ -1,14 +1,54 @@
 #include <modules/network.h>
+#include <icons.h>
+#include <system.h>
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <string>
-#include <stdexcept>
 #include <algorithm>
 #include <vector>
 #include <cstring>
 #include <sys/stat.h>
-#include <cmath>
+#include <charconv>
+
+namespace {
+
+// 取出第一行并从文本中移除
+std::string_view nextLine(std::string_view &text) {
+    const size_t eol = text.find('\n');
+    const std::string_view line = text.substr(0, eol);
+    text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+    return line;
+}
+
+// 去掉前导空格
+std::string_view trimLeft(std::string_view text) {
+    const size_t start = text.find_first_not_of(' ');
+    return start == std::string_view::npos ? std::string_view() : text.substr(start);
+}
+
+// 以空白分隔的第index个字段开头的整数（从0开始），如"70."解析为70
+template <typename T> Result<T> fieldAt(std::string_view text, size_t index) {
+    for (size_t i = 0;; ++i) {
+        const size_t start = text.find_first_not_of(" \t");
+        if (start == std::string_view::npos) {
+            return Error{Errc::PARSE};
+        }
+        text.remove_prefix(start);
+        if (i == index) {
+            break;
+        }
+        text.remove_prefix(std::min(text.size(), text.find_first_of(" \t")));
+    }
+
+    T value{};
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc()) {
+        return Error{Errc::PARSE};
+    }
+    return value;
+}
+
+} // namespace
 
 NetworkModule::NetworkModule() : Module("network") {
     // 网络模块每秒钟更新一次
@@ -18,39 +58,32 @@ NetworkModule::NetworkModule() : Module("network") {
 NetworkModule::~NetworkModule() {}
 
 void NetworkModule::update() {
-    try {
-        std::ostringstream output;
-
-        uint64_t rx = 0, tx = 0;
-        std::string master_ifname;
-        getNetworkSpeedAndMasterDev(rx, tx, master_ifname);
-
-        if (master_ifname.empty()) {
-            output << "󱞐";
-        } else if (master_ifname[0] == 'e') {
-            formatEtherOutput(output, master_ifname, rx, tx);
-        } else if (master_ifname[0] == 'w') {
-            formatWirelessOutput(output, master_ifname, rx, tx);
-        } else {
-            output << "󱞐";
-        }
-
-        // 设置输出
-        setOutput(output.str(), Color::IDLE);
+    const Result<Traffic> traffic = getNetworkSpeedAndMasterDev();
+    if (!traffic) {
+        setUnavailable("󱞐");
+        return;
+    }
 
-    } catch (const std::exception &e) {
-        setOutput("󱞐", Color::DEACTIVE);
+    const std::string &master_ifname = traffic->master;
+    if (!master_ifname.empty() && master_ifname[0] == 'e') {
+        updateEtherOutput(master_ifname, traffic->rx, traffic->tx);
+    } else if (!master_ifname.empty() && master_ifname[0] == 'w') {
+        updateWirelessOutput(master_ifname, traffic->rx, traffic->tx);
+    } else {
+        renderOutput(RenderKey().add(0), [&] { setOutput("󱞐", Color::IDLE); });
     }
 }
 
 void NetworkModule::handleClick(uint64_t button) {
     switch (button) {
     case 2: // 中键点击 - 打开网络管理工具
-        system("iwgtk &");
+        if (System *system = getSystem()) {
+            system->getLauncher().spawn(getName(), {"iwgtk"});
+        }
         break;
     case 3: { // 右键点击 - 切换显示模式
         show_details_ = !show_details_;
-        update();
+        requestUpdate();
         break;
     }
     default:
@@ -59,82 +92,68 @@ void NetworkModule::handleClick(uint64_t button) {
     }
 }
 
-void NetworkModule::getWirelessStatus(const std::string &ifname, int64_t &link, int64_t &level) {
-    std::ifstream file(WIRELESS_STATUS);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open " + std::string(WIRELESS_STATUS));
+Result<NetworkModule::Signal> NetworkModule::getWirelessStatus(const std::string &ifname) {
+    const Result<std::string_view> wireless = wireless_.read();
+    if (!wireless) {
+        return wireless.error();
     }
 
-    std::string line;
-    // 跳过前两行
-    std::getline(file, line);
-    std::getline(file, line);
-
-    link = 0;
-    level = 0;
-
-    while (std::getline(file, line)) {
-        // 跳过前导空格
-        size_t start = line.find_first_not_of(" ");
-        if (start == std::string::npos)
-            continue;
+    // 跳过前两行表头
+    std::string_view text = *wireless;
+    for (int i = 0; i < 2 && !text.empty(); ++i) {
+        text.remove_prefix(std::min(text.size(), text.find('\n') + 1));
+    }
 
-        std::string current_line = line.substr(start);
+    while (!text.empty()) {
+        std::string_view line = nextLine(text);
 
         // 检查是否匹配接口名称
-        if (current_line.compare(0, ifname.length(), ifname) != 0) {
+        const size_t colon_pos = line.find(':');
+        if (colon_pos == std::string_view::npos || trimLeft(line.substr(0, colon_pos)) != ifname) {
             continue;
         }
 
-        // 查找冒号位置
-        size_t colon_pos = current_line.find(':');
-        if (colon_pos == std::string::npos)
-            continue;
-
-        std::string data_part = current_line.substr(colon_pos + 1);
-
-        // 解析链路质量和信号级别
-        if (sscanf(data_part.c_str(), "%*d %ld. %ld. %*d", &link, &level) == 2) {
-            break;
+        // 解析链路质量和信号级别（"状态 链路. 级别. 噪声"）
+        const std::string_view data_part = line.substr(colon_pos + 1);
+        const Result<int64_t> link = fieldAt<int64_t>(data_part, 1);
+        const Result<int64_t> level = fieldAt<int64_t>(data_part, 2);
+        if (!link || !level) {
+            return Error{Errc::PARSE};
         }
-    }
 
-    file.close();
+        // rtw88 驱动程序链路质量最大值是 70，不是 100
+        return Signal{*link * 10 / 7, *level};
+    }
 
-    // rtw88 驱动程序链路质量最大值是 70，不是 100
-    link = link * 10 / 7;
+    return Signal{0, 0};
 }
 
-void NetworkModule::getNetworkSpeedAndMasterDev(uint64_t &rx, uint64_t &tx, std::string &master) {
-    std::ifstream file(NET_DEV);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open " + std::string(NET_DEV));
+Result<NetworkModule::Traffic> NetworkModule::getNetworkSpeedAndMasterDev() {
+    const Result<std::string_view> dev = net_dev_.read();
+    if (!dev) {
+        return dev.error();
     }
 
-    std::string line;
-    // 跳过前两行
-    std::getline(file, line);
-    std::getline(file, line);
+    // 跳过前两行表头
+    std::string_view text = *dev;
+    for (int i = 0; i < 2 && !text.empty(); ++i) {
+        text.remove_prefix(std::min(text.size(), text.find('\n') + 1));
+    }
 
+    Traffic traffic;
     bool found = false;
-    rx = 0;
-    tx = 0;
-
-    while (std::getline(file, line)) {
-        // 跳过前导空格
-        size_t start = line.find_first_not_of(" ");
-        if (start == std::string::npos)
-            continue;
 
-        std::string current_line = line.substr(start);
+    while (!text.empty()) {
+        const std::string_view line = nextLine(text);
 
         // 查找冒号位置
-        size_t colon_pos = current_line.find(':');
-        if (colon_pos == std::string::npos)
+        const size_t colon_pos = line.find(':');
+        if (colon_pos == std::string_view::npos) {
             continue;
+        }
 
-        std::string ifname = current_line.substr(0, colon_pos);
-        std::string data_part = current_line.substr(colon_pos + 1);
+        const std::string_view ifname = trimLeft(line.substr(0, colon_pos));
+        const std::string_view data_part = line.substr(colon_pos + 1);
 
         // 只接受 wlan 和 ether
         if (ifname.empty() || (ifname[0] != 'w' && ifname[0] != 'e')) {
@@ -143,7 +162,8 @@ void NetworkModule::getNetworkSpeedAndMasterDev(uint64_t &rx, uint64_t &tx, std:
 
         // 检查网络接口是否 up
         char carrier_path[256];
-        snprintf(carrier_path, sizeof(carrier_path), CARRIER_PATH_TEMPLATE, ifname.c_str());
+        snprintf(carrier_path, sizeof(carrier_path), CARRIER_PATH_TEMPLATE,
+                 static_cast<int>(ifname.size()), ifname.data());
 
         struct stat st;
         if (stat(carrier_path, &st) != 0) {
@@ -155,7 +175,7 @@ void NetworkModule::getNetworkSpeedAndMasterDev(uint64_t &rx, uint64_t &tx, std:
             continue;
         }
 
-        uint64_t carrier;
+        uint64_t carrier = 0;
         carrier_file >> carrier;
         carrier_file.close();
 
@@ -165,79 +185,102 @@ void NetworkModule::getNetworkSpeedAndMasterDev(uint64_t &rx, uint64_t &tx, std:
 
         // 保存接口名称
         if (!found || ifname[0] == 'e') {
-            master = ifname;
+            traffic.master = ifname;
         }
 
-        // 解析接收和发送字节数
-        uint64_t prx, ptx;
-        if (sscanf(data_part.c_str(), "%lu %*u %*u %*u %*u %*u %*u %*u %lu", &prx, &ptx) == 2) {
-            rx += prx;
-            tx += ptx;
+        // 解析接收和发送字节数（第1和第9列）
+        const Result<uint64_t> prx = fieldAt<uint64_t>(data_part, 0);
+        const Result<uint64_t> ptx = fieldAt<uint64_t>(data_part, 8);
+        if (prx && ptx) {
+            traffic.rx += *prx;
+            traffic.tx += *ptx;
             found = true;
         }
     }
 
-    file.close();
-
     if (!found) {
-        master = "";
-        return;
+        traffic.master.clear();
+        return traffic;
     }
 
     // 计算差值
+    const auto now = std::chrono::steady_clock::now();
     if (prev_rx_ == 0) {
-        prev_rx_ = rx;
+        prev_rx_ = traffic.rx;
     }
     if (prev_tx_ == 0) {
-        prev_tx_ = tx;
+        prev_tx_ = traffic.tx;
     }
 
-    uint64_t rx_diff = rx - prev_rx_;
-    uint64_t tx_diff = tx - prev_tx_;
+    // 计数器在接口重置时可能回退
+    uint64_t rx_diff = traffic.rx >= prev_rx_ ? traffic.rx - prev_rx_ : 0;
+    uint64_t tx_diff = traffic.tx >= prev_tx_ ? traffic.tx - prev_tx_ : 0;
 
-    prev_rx_ = rx;
-    prev_tx_ = tx;
+    // 换算为每秒字节数，基准来自快照时间隔可能超过1秒
+    const auto elapsed = std::chrono::duration<double>(now - prev_time_).count();
+    if (prev_time_.time_since_epoch().count() != 0 && elapsed > 1.5) {
+        rx_diff = static_cast<uint64_t>(static_cast<double>(rx_diff) / elapsed);
+        tx_diff = static_cast<uint64_t>(static_cast<double>(tx_diff) / elapsed);
+    }
+
+    prev_rx_ = traffic.rx;
+    prev_tx_ = traffic.tx;
+    prev_time_ = now;
 
-    rx = rx_diff;
-    tx = tx_diff;
+    traffic.rx = rx_diff;
+    traffic.tx = tx_diff;
+    return traffic;
 }
 
-void NetworkModule::formatEtherOutput(
-    std::ostringstream &output, const std::string &ifname, uint64_t rx, uint64_t tx
-) {
+void NetworkModule::updateEtherOutput(const std::string &ifname, uint64_t rx, uint64_t tx) {
+    RenderKey key;
+    key.add('e').add(show_details_);
+
+    // 网络速度，-1表示无效
+    int64_t speed = -1;
     if (show_details_) {
-        // 显示网络速度
         char speed_path[256];
-        snprintf(speed_path, sizeof(speed_path), SPEED_PATH_TEMPLATE, ifname.c_str());
-
-        try {
-            uint64_t speed = Module::readUint64File(speed_path);
-            // 检查是否为无效值（-1在无符号中表示很大的数）
-            if (speed == static_cast<uint64_t>(-1) || speed > 10000) {
-                output << "󰈀" << " " << "--M";
-            } else {
-                output << "󰈀" << " " << speed << "M";
-            }
-        } catch (const std::exception &e) {
-            // 读取失败时显示--
-            output << "󰈀" << " " << "--M";
+        snprintf(speed_path, sizeof(speed_path), SPEED_PATH_TEMPLATE,
+                 static_cast<int>(ifname.size()), ifname.data());
+
+        // 接口变化时重新打开；链路断开和虚拟接口读取speed返回EINVAL，由数据源负缓存
+        if (!speed_ || speed_->getPath() != speed_path) {
+            speed_ = std::make_unique<SampleSource>(speed_path);
         }
+
+        // 未知速度为-1，解析失败时同样显示--
+        const Result<uint64_t> value = speed_->readUint64();
+        if (value && *value <= 10000) {
+            speed = static_cast<int64_t>(*value);
+        }
+        key.add(speed);
     } else {
-        // 显示流量
-        output << "󰈀" << " ";
-        formatStorageUnits(output, rx);
-        output << " ";
-        formatStorageUnits(output, tx);
+        key.addBytes(rx).addBytes(tx);
     }
+
+    renderOutput(key, [&] {
+        FormatBuffer buffer;
+        if (!show_details_) {
+            // 显示流量
+            traffic_format_.render(buffer, "󰈀", rx, tx);
+        } else if (speed < 0) {
+            speed_format_.render(buffer, "󰈀", "--");
+        } else {
+            speed_format_.render(buffer, "󰈀", speed);
+        }
+        setOutput(buffer.view(), Color::IDLE);
+    });
 }
 
-void NetworkModule::formatWirelessOutput(
-    std::ostringstream &output, const std::string &ifname, uint64_t rx, uint64_t tx
-) {
-    int64_t link = 0, level = 0;
-    getWirelessStatus(ifname, link, level);
+void NetworkModule::updateWirelessOutput(const std::string &ifname, uint64_t rx, uint64_t tx) {
+    const Result<Signal> signal = getWirelessStatus(ifname);
+    if (!signal) {
+        setUnavailable("󱞐");
+        return;
+    }
+    const int64_t link = signal->link;
+    const int64_t level = signal->level;
 
-    const std::vector<std::string> icons = {"󰤮", "󰤯", "󰤟", "󰤢", "󰤥", "󰤨"};
     size_t idx = 0;
     idx += level > -100;
     idx += level > -90;
@@ -246,43 +289,46 @@ void NetworkModule::formatWirelessOutput(
     idx += level > -55;
 
     // 采用 level 方法判断出问题的时候，就用 link 方法
-    if (idx == 0 || idx >= icons.size()) {
-        idx = icons.size() * static_cast<uint64_t>(link) / 101;
+    if (idx == 0 || idx >= icons::WIRELESS.size()) {
+        idx = icons::WIRELESS.size() * static_cast<uint64_t>(link) / 101;
     }
 
-    idx = std::min(idx, icons.size() - 1);
+    idx = std::min(idx, icons::WIRELESS.size() - 1);
 
+    RenderKey key;
+    key.add('w').add(show_details_).add(idx);
     if (show_details_) {
-        output << icons[idx] << " " << link << "%" << " " << level << "dB";
+        key.add(link).add(level);
     } else {
-        output << icons[idx] << " ";
-        formatStorageUnits(output, rx);
-        output << " ";
-        formatStorageUnits(output, tx);
+        key.addBytes(rx).addBytes(tx);
     }
-}
-
-void NetworkModule::formatStorageUnits(std::ostringstream &output, uint64_t bytes) {
-    const char *units = "KMGTPE"; // 单位从 K 开始
-    int unit_idx = -1;            // 0=K, 1=M, 2=G, 3=T, 4=P, 5=E
 
-    double size = static_cast<double>(bytes);
+    renderOutput(key, [&] {
+        FormatBuffer buffer;
+        if (show_details_) {
+            signal_format_.render(buffer, icons::WIRELESS[idx], link, level);
+        } else {
+            traffic_format_.render(buffer, icons::WIRELESS[idx], rx, tx);
+        }
+        setOutput(buffer.view(), Color::IDLE);
+    });
+}
 
-    // 确保最小单位为 K
-    while ((size >= 1000.0 && unit_idx < 5) || unit_idx < 0) {
-        size /= 1024;
-        unit_idx++;
-    }
+void NetworkModule::saveCounters(std::vector<uint64_t> &counters) const {
+    counters.push_back(prev_rx_);
+    counters.push_back(prev_tx_);
+    counters.push_back(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(prev_time_.time_since_epoch()).count()
+    ));
+}
 
-    // 动态选择格式，确保不超过5个字符
-    if (size >= 100.0) {
-        output.precision(0);
-        output << std::fixed << " " << std::round(size) << units[unit_idx];
-    } else if (size >= 10.0) {
-        output.precision(1);
-        output << std::fixed << size << units[unit_idx];
-    } else {
-        output.precision(2);
-        output << std::fixed << size << units[unit_idx];
+void NetworkModule::restoreCounters(std::span<const uint64_t> counters) {
+    if (counters.size() != 3) {
+        return;
     }
-}
\ No newline at end of file
+    prev_rx_ = counters[0];
+    prev_tx_ = counters[1];
+    prev_time_ = std::chrono::steady_clock::time_point(
+        std::chrono::nanoseconds(static_cast<int64_t>(counters[2]))
+    );
+}
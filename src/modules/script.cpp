@@ -0,0 +1,545 @@
+#include <modules/script.h>
+#include <escape.h>
+#include <system.h>
+#include <nlohmann/json.hpp>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using json = nlohmann::json;
+
+namespace {
+
+// 单行输出的最大长度，超过时截断，防止失控的脚本撑大缓冲区
+constexpr size_t MAX_LINE_SIZE = 4096;
+
+// 子进程连续运行超过该时间后，重启退避重新从1秒开始
+constexpr auto STABLE_RUN_TIME = std::chrono::seconds(30);
+
+// 重启退避的上限（秒）
+constexpr uint64_t MAX_RESTART_DELAY = 60;
+
+// 默认超时（秒）
+constexpr uint64_t DEFAULT_TIMEOUT = 10;
+
+// 去掉首尾空白
+std::string_view trim(std::string_view text) {
+    const auto first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    const auto last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+// 将脚本给出的颜色映射到调色板，无法识别时使用IDLE
+Color parseColor(std::string_view text) {
+    for (size_t i = 0; i < COLOR_COUNT; ++i) {
+        const std::string_view hex = COLOR_STRINGS[i];
+        if (hex.size() == text.size() &&
+            std::equal(hex.begin(), hex.end(), text.begin(), [](char a, char b) {
+                return std::tolower(static_cast<unsigned char>(a)) ==
+                       std::tolower(static_cast<unsigned char>(b));
+            })) {
+            return static_cast<Color>(i);
+        }
+    }
+    return Color::IDLE;
+}
+
+// 创建管道，父进程一端非阻塞，两端都设置CLOEXEC
+bool createPipe(int fds[2], bool parent_reads) {
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        return false;
+    }
+    const int parent_fd = parent_reads ? fds[0] : fds[1];
+    fcntl(parent_fd, F_SETFL, fcntl(parent_fd, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+} // namespace
+
+ScriptModule::ScriptModule(const std::string &name, const std::string &command, Mode mode,
+                           uint64_t interval, uint64_t timeout)
+    : Module(name), argv_(Launcher::splitCommand(command)), mode_(mode),
+      run_interval_(interval),
+      timeout_(timeout > 0 ? timeout
+                           : std::min(run_interval_ > 0 ? run_interval_ : DEFAULT_TIMEOUT,
+                                      DEFAULT_TIMEOUT)) {
+    // 常驻模式由子进程的输出驱动，定时模式在init()中设置间隔
+    setInterval(0);
+}
+
+ScriptModule::~ScriptModule() {
+    System *system = getSystem();
+
+    if (pid_ != -1 && system) {
+        // 子进程退出时本对象已不存在，只让启动服务负责回收
+        system->getLauncher().detach(pid_);
+        system->getLauncher().signal(pid_, SIGTERM);
+    }
+
+    closePipes();
+
+    if (timeout_fd_ != -1) {
+        if (system) {
+            system->unwatchFd(timeout_fd_);
+        }
+        close(timeout_fd_);
+    }
+}
+
+void ScriptModule::init() {
+    if (argv_.empty()) {
+        std::cerr << "Script " << getName() << ": empty command" << std::endl;
+        setOutput("", Color::DEACTIVE);
+        return;
+    }
+
+    if (mode_ == Mode::PERSIST) {
+        spawnChild();
+        return;
+    }
+
+    // 定时模式使用一个timerfd实现超时终止
+    timeout_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timeout_fd_ != -1) {
+        System *system = getSystem();
+        if (!system || !system->watchFd(timeout_fd_, EPOLLIN, [this](uint32_t) { onTimeout(); })) {
+            close(timeout_fd_);
+            timeout_fd_ = -1;
+        }
+    }
+    if (timeout_fd_ == -1) {
+        std::cerr << "Script " << getName() << ": timeout timer unavailable" << std::endl;
+    }
+
+    // 间隔为0时只在启动、点击、刷新信号和控制命令时运行
+    setInterval(run_interval_);
+}
+
+void ScriptModule::update() {
+    if (argv_.empty() || pid_ != -1) {
+        return; // 正在运行，等待输出或退出
+    }
+
+    spawnChild();
+}
+
+void ScriptModule::handleClick(uint64_t button) {
+    if (mode_ == Mode::INTERVAL) {
+        // 与i3blocks相同：通过BLOCK_BUTTON传递按钮并立即重新运行
+        pending_button_ = button;
+        requestUpdate();
+        return;
+    }
+
+    if (stdin_fd_ == -1) {
+        return;
+    }
+
+    json event;
+    event["name"] = getName();
+    event["button"] = button;
+    const std::string line = event.dump() + "\n";
+
+    // 管道已满时丢弃本次点击，而不是阻塞事件循环
+    const ssize_t written = write(stdin_fd_, line.data(), line.size());
+    if (written != static_cast<ssize_t>(line.size())) {
+        std::cerr << "Script " << getName() << ": failed to forward click" << std::endl;
+    }
+}
+
+std::string ScriptModule::defaultConfigPath() {
+    if (const char *config_home = std::getenv("XDG_CONFIG_HOME"); config_home && *config_home) {
+        return std::string(config_home) + "/seedstatus/scripts.conf";
+    }
+    if (const char *home = std::getenv("HOME")) {
+        return std::string(home) + "/.config/seedstatus/scripts.conf";
+    }
+    return {};
+}
+
+std::vector<std::shared_ptr<ScriptModule>> ScriptModule::loadConfig(const std::string &path) {
+    std::vector<std::shared_ptr<ScriptModule>> scripts;
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return scripts;
+    }
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+
+        const std::string_view text = trim(line);
+        if (text.empty() || text.front() == '#') {
+            continue;
+        }
+
+        std::istringstream stream{std::string(text)};
+        std::string name, mode;
+        stream >> name >> mode;
+
+        // 可选的"键=值"选项，目前只有signal=N
+        int refresh_signal = 0;
+        bool valid = true;
+        std::string command;
+        std::string token;
+        while (stream >> token) {
+            if (token.rfind("signal=", 0) != 0) {
+                std::getline(stream, command);
+                command = token + command;
+                break;
+            }
+            const char *value = token.data() + 7;
+            const auto result = std::from_chars(value, token.data() + token.size(), refresh_signal);
+            if (result.ec != std::errc() || result.ptr != token.data() + token.size() ||
+                refresh_signal <= 0) {
+                std::cerr << path << ":" << line_number << ": invalid option \"" << token << "\""
+                          << std::endl;
+                valid = false;
+                break;
+            }
+        }
+        command = std::string(trim(command));
+
+        if (!valid) {
+            continue;
+        }
+        if (name.empty() || mode.empty() || command.empty()) {
+            std::cerr << path << ":" << line_number
+                      << ": expected \"name mode [signal=N] command...\"" << std::endl;
+            continue;
+        }
+
+        std::shared_ptr<ScriptModule> script;
+        if (mode == "persist") {
+            script = std::make_shared<ScriptModule>(name, command, Mode::PERSIST);
+        } else {
+            // 定时模式："间隔[:超时]"，间隔为0表示只按需运行
+            uint64_t interval = 0, timeout = 0;
+            const char *begin = mode.data();
+            const char *end = mode.data() + mode.size();
+            auto result = std::from_chars(begin, end, interval);
+            if (result.ec == std::errc() && result.ptr != end && *result.ptr == ':') {
+                result = std::from_chars(result.ptr + 1, end, timeout);
+            }
+            if (result.ec != std::errc() || result.ptr != end) {
+                std::cerr << path << ":" << line_number << ": invalid mode \"" << mode
+                          << "\", expected persist or interval[:timeout]" << std::endl;
+                continue;
+            }
+            script = std::make_shared<ScriptModule>(name, command, Mode::INTERVAL, interval, timeout);
+        }
+
+        script->setRefreshSignal(refresh_signal);
+        scripts.push_back(std::move(script));
+    }
+
+    return scripts;
+}
+
+void ScriptModule::spawnChild() {
+    System *system = getSystem();
+    if (!system) {
+        return;
+    }
+
+    int out[2] = {-1, -1};
+    int in[2] = {-1, -1};
+    if (!createPipe(out, true) || (mode_ == Mode::PERSIST && !createPipe(in, false))) {
+        std::cerr << "Script " << getName() << ": pipe failed: " << strerror(errno) << std::endl;
+        for (const int fd : {out[0], out[1], in[0], in[1]}) {
+            if (fd != -1) {
+                close(fd);
+            }
+        }
+        return;
+    }
+
+    Launcher::SpawnOptions options;
+    options.stdin_fd = in[0];
+    options.stdout_fd = out[1];
+    options.on_exit = [this](pid_t, int status) { onChildExit(status); };
+    if (pending_button_ != 0) {
+        options.env.push_back("BLOCK_BUTTON=" + std::to_string(pending_button_));
+        pending_button_ = 0;
+    }
+    options.env.push_back("BLOCK_NAME=" + getName());
+
+    pid_ = system->getLauncher().spawn(getName(), argv_, std::move(options));
+
+    // 子进程一端已被复制，父进程关闭自己持有的副本
+    close(out[1]);
+    if (in[0] != -1) {
+        close(in[0]);
+    }
+
+    if (pid_ == -1) {
+        close(out[0]);
+        if (in[1] != -1) {
+            close(in[1]);
+        }
+        if (mode_ == Mode::PERSIST) {
+            // 启动失败同样按退避重试
+            setInterval(restart_delay_);
+            restart_delay_ = std::min(restart_delay_ * 2, MAX_RESTART_DELAY);
+        }
+        return;
+    }
+
+    stdout_fd_ = out[0];
+    stdin_fd_ = in[1];
+    started_at_ = std::chrono::steady_clock::now();
+    line_buffer_.clear();
+    run_output_.clear();
+    term_sent_ = false;
+
+    if (!system->watchFd(stdout_fd_, EPOLLIN, [this](uint32_t) { readOutput(); })) {
+        std::cerr << "Script " << getName() << ": failed to watch output" << std::endl;
+    }
+
+    if (mode_ == Mode::PERSIST) {
+        // 已经在运行，不再需要定时重启
+        setInterval(0);
+    } else {
+        armTimeout(timeout_);
+    }
+}
+
+void ScriptModule::readOutput() {
+    if (stdout_fd_ == -1) {
+        return;
+    }
+
+    char buf[4096];
+    for (;;) {
+        const ssize_t n = read(stdout_fd_, buf, sizeof(buf));
+        if (n > 0) {
+            if (mode_ == Mode::INTERVAL) {
+                // 只保留开头部分，i3blocks协议只使用前三行
+                const size_t room = MAX_LINE_SIZE - std::min(run_output_.size(), MAX_LINE_SIZE);
+                run_output_.append(buf, std::min(static_cast<size_t>(n), room));
+                continue;
+            }
+
+            line_buffer_.append(buf, static_cast<size_t>(n));
+
+            // 只有最后一个完整行需要显示，中间的行被跳过
+            const size_t last_newline = line_buffer_.rfind('\n');
+            if (last_newline != std::string::npos) {
+                const size_t prev_newline =
+                    last_newline == 0 ? std::string::npos : line_buffer_.rfind('\n', last_newline - 1);
+                const size_t start = prev_newline == std::string::npos ? 0 : prev_newline + 1;
+                applyLine(line_buffer_.substr(start, last_newline - start));
+                line_buffer_.erase(0, last_newline + 1);
+            }
+            if (line_buffer_.size() > MAX_LINE_SIZE) {
+                line_buffer_.clear();
+            }
+            continue;
+        }
+
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+
+        bool would_block = n == -1 && errno == EAGAIN;
+#if EWOULDBLOCK != EAGAIN
+        would_block = would_block || (n == -1 && errno == EWOULDBLOCK);
+#endif
+        if (would_block) {
+            return;
+        }
+
+        // EOF或读取错误：子进程关闭了输出，退出状态由pidfd报告
+        if (System *system = getSystem()) {
+            system->unwatchFd(stdout_fd_);
+        }
+        close(stdout_fd_);
+        stdout_fd_ = -1;
+        return;
+    }
+}
+
+void ScriptModule::onChildExit(int status) {
+    // 取走管道中剩余的输出
+    readOutput();
+    closePipes();
+    armTimeout(0);
+    pid_ = -1;
+
+    const bool success = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    if (mode_ == Mode::INTERVAL) {
+        if (success) {
+            applyRunOutput();
+        } else {
+            // 保留上一次的输出，等待下一次运行
+            std::cerr << "Script " << getName() << ": run failed, keeping cached output"
+                      << std::endl;
+            if (!has_output_) {
+                setCachedOutput("", Color::DEACTIVE);
+            }
+        }
+        return;
+    }
+
+    // 常驻模式：按指数退避重启，稳定运行一段时间后重置退避
+    if (std::chrono::steady_clock::now() - started_at_ >= STABLE_RUN_TIME) {
+        restart_delay_ = 1;
+    }
+    std::cerr << "Script " << getName() << ": exited, restarting in " << restart_delay_ << "s"
+              << std::endl;
+    setCachedOutput(cached_text_, Color::DEACTIVE);
+    setInterval(restart_delay_);
+    restart_delay_ = std::min(restart_delay_ * 2, MAX_RESTART_DELAY);
+}
+
+void ScriptModule::onTimeout() {
+    uint64_t expirations = 0;
+    if (read(timeout_fd_, &expirations, sizeof(expirations)) != sizeof(expirations) ||
+        pid_ == -1) {
+        return;
+    }
+
+    System *system = getSystem();
+    if (!system) {
+        return;
+    }
+
+    if (!term_sent_) {
+        std::cerr << "Script " << getName() << ": timed out after " << timeout_
+                  << "s, terminating" << std::endl;
+        system->getLauncher().signal(pid_, SIGTERM);
+        term_sent_ = true;
+        armTimeout(1);
+    } else {
+        system->getLauncher().signal(pid_, SIGKILL);
+    }
+}
+
+void ScriptModule::closePipes() {
+    System *system = getSystem();
+
+    if (stdout_fd_ != -1) {
+        if (system) {
+            system->unwatchFd(stdout_fd_);
+        }
+        close(stdout_fd_);
+        stdout_fd_ = -1;
+    }
+
+    if (stdin_fd_ != -1) {
+        close(stdin_fd_);
+        stdin_fd_ = -1;
+    }
+}
+
+void ScriptModule::applyLine(const std::string &raw_line) {
+    std::string_view line = trim(raw_line);
+
+    // 兼容完整的i3bar协议输出：跳过协议头后的"["和元素之间的前导逗号
+    if (!line.empty() && line.front() == ',') {
+        line = trim(line.substr(1));
+    }
+    if (line == "[") {
+        return;
+    }
+
+    if (line.empty() || (line.front() != '{' && line.front() != '[')) {
+        setCachedOutput(escapePango(line), Color::IDLE);
+        return;
+    }
+
+    try {
+        json block = json::parse(line);
+
+        // 一行是一个块数组时只显示第一个块
+        if (block.is_array()) {
+            if (block.empty()) {
+                setCachedOutput("", Color::IDLE);
+                return;
+            }
+            block = block.front();
+        }
+        if (!block.is_object()) {
+            return;
+        }
+
+        // i3bar协议头（{"version":1,...}）不是输出
+        if (block.contains("version")) {
+            return;
+        }
+
+        std::string text = block.value("full_text", std::string());
+        if (block.value("markup", std::string()) != "pango") {
+            text = escapePango(text);
+        }
+
+        Color color = Color::IDLE;
+        if (block.value("urgent", false)) {
+            color = Color::CRITICAL;
+        } else if (block.contains("color") && block["color"].is_string()) {
+            color = parseColor(block["color"].get<std::string>());
+        }
+
+        setCachedOutput(text, color);
+    } catch (const std::exception &e) {
+        std::cerr << "Script " << getName() << ": invalid JSON block: " << e.what() << std::endl;
+    }
+}
+
+void ScriptModule::applyRunOutput() {
+    std::istringstream stream(run_output_);
+    std::string full_text, short_text, color;
+    std::getline(stream, full_text);
+    std::getline(stream, short_text);
+    std::getline(stream, color);
+
+    if (!trim(full_text).empty() && trim(full_text).front() == '{') {
+        applyLine(full_text);
+        return;
+    }
+
+    const std::string_view color_text = trim(color);
+    setCachedOutput(
+        escapePango(trim(full_text)), color_text.empty() ? Color::IDLE : parseColor(color_text)
+    );
+}
+
+void ScriptModule::setCachedOutput(const std::string &text, Color color) {
+    if (has_output_ && text == cached_text_ && color == cached_color_) {
+        return;
+    }
+
+    cached_text_ = text;
+    cached_color_ = color;
+    has_output_ = true;
+    setOutput(text, color);
+}
+
+void ScriptModule::armTimeout(uint64_t seconds) {
+    if (timeout_fd_ == -1) {
+        return;
+    }
+
+    struct itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(seconds);
+    timerfd_settime(timeout_fd_, 0, &spec, nullptr);
+}
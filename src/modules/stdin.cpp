@@ -1,14 +1,14 @@
 #include <modules/stdin.h>
 #include <fcntl.h>
 #include <cstring>
+#include <charconv>
 #include <iostream>
-#include <nlohmann/json.hpp>
 #include <system.h>
 
 // 定义缓冲区大小
 #define BUF_SIZE 4096
 
-StdinModule::StdinModule(System *system) : Module("stdin"), system_(system) {
+StdinModule::StdinModule() : Module("stdin") {
     // Stdin模块不需要定时更新，只在有输入时更新
     setInterval(0);
 }
@@ -63,81 +63,72 @@ void StdinModule::setNonBlocking(int fd) {
 
 void StdinModule::parseInput() {
     char input[BUF_SIZE];
-    ssize_t n = read(STDIN_FILENO, input, BUF_SIZE - 1);
 
-    if (n == -1) {
-        // 检查是否为非阻塞IO的正常返回
-        if (errno != EAGAIN) {
+    // 边沿触发的epoll要求一直读到EAGAIN，否则剩余数据不会再次通知
+    while (true) {
+        ssize_t n = read(STDIN_FILENO, input, BUF_SIZE);
+
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // 检查是否为非阻塞IO的正常返回
+            bool would_block = errno == EAGAIN;
 #if EWOULDBLOCK != EAGAIN
-            if (errno != EWOULDBLOCK) {
+            would_block = would_block || errno == EWOULDBLOCK;
 #endif
-                // 真正的错误处理
+            if (!would_block) {
                 std::cerr << "StdinModule: Error reading from stdin: " << strerror(errno)
                           << std::endl;
-#if EWOULDBLOCK != EAGAIN
-            } else {
-                std::cerr << "StdinModule: stdin would block (EWOULDBLOCK)" << std::endl;
             }
-#else
-            std::cerr << "StdinModule: stdin would block (EAGAIN)" << std::endl;
-#endif
+            return;
         }
-        return;
-    }
 
-    if (n == 0) {
-        std::cerr << "StdinModule: EOF received on stdin" << std::endl;
-        return;
-    }
+        if (n == 0) {
+            std::cerr << "StdinModule: EOF received on stdin" << std::endl;
+            return;
+        }
 
-    // 确保输入以null结尾
-    input[n] = '\0';
+        // 追加到残留缓冲区，取出所有已完整到达的事件
+        parser_.append(input, static_cast<size_t>(n));
 
-    // 尝试查找第一个JSON对象
-    const char *json_start = strchr(input, '{');
-    if (!json_start) {
-        std::cerr << "StdinModule: No JSON object found in input" << std::endl;
-        return;
+        ClickEvent event;
+        while (parser_.next(event)) {
+            dispatchClick(event);
+        }
     }
+}
 
-    try {
-        // 尝试解析JSON对象
-        auto json = nlohmann::json::parse(json_start, nullptr, false);
-
-        if (json.is_discarded()) {
-            std::cerr << "StdinModule: Failed to parse JSON input" << std::endl;
-            return;
+void StdinModule::dispatchClick(const ClickEvent &event) {
+    // 使用所属的System实例
+    System *system = getSystem();
+    if (!system) {
+        std::cerr << "StdinModule: System pointer is null, cannot handle click event" << std::endl;
+        return;
+    }
+    // 获取模块管理器
+    ModuleManager &module_manager = system->getModuleManager();
+
+    // 优先按instance字段（模块ID）路由，缺失时回退到名称索引
+    ModuleId id = INVALID_MODULE_ID;
+    if (!event.instance.empty()) {
+        ModuleId parsed = 0;
+        const char *end = event.instance.data() + event.instance.size();
+        const auto [ptr, ec] = std::from_chars(event.instance.data(), end, parsed);
+        if (ec == std::errc() && ptr == end) {
+            id = parsed;
         }
+    }
+    if (id == INVALID_MODULE_ID) {
+        id = module_manager.findModuleId(event.name);
+    }
 
-        // 检查是否包含必要的字段
-        if (json.contains("name") && json.contains("button")) {
-            std::string module_name = json["name"];
-            uint64_t button = json["button"];
-
-            // 使用System实例指针
-            if (!system_) {
-                std::cerr << "StdinModule: System pointer is null, cannot handle click event"
-                          << std::endl;
-                return;
-            }
-            System &system = *system_;
-            // 获取模块管理器
-            ModuleManager &module_manager = system.getModuleManager();
-
-            // 查找对应的模块
-            auto module = module_manager.getModuleByName(module_name);
-
-            if (module) {
-                // 调用模块的handleClick方法
-                std::cerr << "StdinModule: Forwarding click event to module " << module_name
-                          << " with button " << button << std::endl;
-                module->handleClick(button);
-            } else {
-                std::cerr << "StdinModule: Module " << module_name << " not found" << std::endl;
-            }
-        }
-    } catch (const std::exception &e) {
-        // 处理所有可能的异常
-        std::cerr << "StdinModule: Exception while parsing input: " << e.what() << std::endl;
+    // 调用模块的handleClick方法
+    if (module_manager.dispatchClick(id, event.button)) {
+        std::cerr << "StdinModule: Forwarded click event to module " << id << " with button "
+                  << event.button << " (modifiers 0x" << std::hex << event.modifiers << std::dec
+                  << ")" << std::endl;
+    } else {
+        std::cerr << "StdinModule: Module " << event.name << " not found" << std::endl;
     }
-}
\ No newline at end of file
+}
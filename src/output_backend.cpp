@@ -0,0 +1,406 @@
+#include <output_backend.h>
+#include <escape.h>
+#include <system.h>
+#include <algorithm>
+#include <charconv>
+
+namespace {
+
+// 模块之间的空格分隔块（i3bar）
+constexpr std::string_view SPACER_FRAGMENT =
+    "{\"full_text\":\" \",\"separator\":false,\"separator_block_width\":0,\"markup\":\"pango\"}";
+
+// 非法UTF-8字节的替代字符（U+FFFD）
+constexpr std::string_view REPLACEMENT_CHARACTER = "\xEF\xBF\xBD";
+
+// 码点的UTF-8编码写入out（至少4字节），返回字节数；超出范围时写入替代字符
+size_t encodeUtf8(uint32_t cp, char *out) {
+    if (cp < 0x80) {
+        out[0] = static_cast<char>(cp);
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (cp >> 6));
+        out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (cp >> 12));
+        out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    if (cp < 0x110000) {
+        out[0] = static_cast<char>(0xF0 | (cp >> 18));
+        out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 4;
+    }
+    REPLACEMENT_CHARACTER.copy(out, REPLACEMENT_CHARACTER.size());
+    return REPLACEMENT_CHARACTER.size();
+}
+
+// 颜色值只允许#和字母数字，避免破坏后端的格式语法
+bool isSafeColor(std::string_view color) {
+    if (color.empty()) {
+        return false;
+    }
+    for (const char c : color) {
+        const bool alnum = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        if (!alnum && c != '#') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 从span标签中取出color/foreground/fgcolor属性，没有时返回空
+std::string_view spanColor(std::string_view tag) {
+    for (const std::string_view attr : {"foreground=", "fgcolor=", "color="}) {
+        size_t pos = tag.find(attr);
+        // 属性名前必须是空白，避免把background=中的color=当成前景色
+        while (pos != std::string_view::npos && tag[pos - 1] != ' ') {
+            pos = tag.find(attr, pos + 1);
+        }
+        if (pos == std::string_view::npos) {
+            continue;
+        }
+
+        pos += attr.size();
+        if (pos >= tag.size() || (tag[pos] != '\'' && tag[pos] != '"')) {
+            continue;
+        }
+        const size_t end = tag.find(tag[pos], pos + 1);
+        if (end == std::string_view::npos) {
+            continue;
+        }
+        return tag.substr(pos + 1, end - pos - 1);
+    }
+    return {};
+}
+
+/**
+ * 把Pango文本降级为纯文本，颜色变化通过回调交给后端
+ *
+ * text(c)接收每个解码后的字节，color(value)在span开始和结束时被调用，
+ * 结束时value为外层span的颜色，没有外层span时为空（恢复模块颜色）。
+ */
+template <typename TextSink, typename ColorSink>
+void convertMarkup(std::string_view markup, TextSink &&text, ColorSink &&color) {
+    // 每层span的颜色，不改变颜色的span记为空
+    std::string_view colors[8];
+    size_t depth = 0;
+    size_t overflow = 0;
+
+    auto currentColor = [&]() -> std::string_view {
+        for (size_t i = depth; i > 0; --i) {
+            if (!colors[i - 1].empty()) {
+                return colors[i - 1];
+            }
+        }
+        return {};
+    };
+
+    size_t pos = 0;
+    while (pos < markup.size()) {
+        const char c = markup[pos];
+
+        if (c == '<') {
+            const size_t end = markup.find('>', pos);
+            if (end == std::string_view::npos) {
+                break; // 不完整的标签，丢弃其余部分
+            }
+            const std::string_view tag = markup.substr(pos + 1, end - pos - 1);
+            pos = end + 1;
+
+            if (tag.rfind("span", 0) == 0 && (tag.size() == 4 || tag[4] == ' ')) {
+                if (depth == std::size(colors)) {
+                    ++overflow;
+                    continue;
+                }
+                const std::string_view value = spanColor(tag);
+                colors[depth++] = isSafeColor(value) ? value : std::string_view();
+                if (!colors[depth - 1].empty()) {
+                    color(colors[depth - 1]);
+                }
+            } else if (tag == "/span") {
+                if (overflow > 0) {
+                    --overflow;
+                } else if (depth > 0) {
+                    const bool changed = !colors[--depth].empty();
+                    if (changed) {
+                        color(currentColor());
+                    }
+                }
+            }
+            // 其余标签（b、i、small等）没有对应的文本语法，直接去掉
+            continue;
+        }
+
+        if (c == '&') {
+            const size_t end = markup.find(';', pos);
+            if (end != std::string_view::npos && end - pos <= 10) {
+                const std::string_view entity = markup.substr(pos + 1, end - pos - 1);
+                // 解码到栈上的缓冲区，不为每个实体分配字符串
+                char decoded[4];
+                size_t length = 0;
+                if (entity == "amp") {
+                    decoded[length++] = '&';
+                } else if (entity == "lt") {
+                    decoded[length++] = '<';
+                } else if (entity == "gt") {
+                    decoded[length++] = '>';
+                } else if (entity == "quot") {
+                    decoded[length++] = '"';
+                } else if (entity == "apos") {
+                    decoded[length++] = '\'';
+                } else if (entity.size() > 1 && entity[0] == '#') {
+                    const bool hex = entity[1] == 'x' || entity[1] == 'X';
+                    const std::string_view digits = entity.substr(hex ? 2 : 1);
+                    uint32_t cp = 0;
+                    const auto [digits_end, ec] =
+                        std::from_chars(digits.data(), digits.data() + digits.size(), cp, hex ? 16 : 10);
+                    if (!digits.empty() && digits_end == digits.data() + digits.size()) {
+                        // 超出uint32_t的码点同样编码为替代字符
+                        length = encodeUtf8(ec == std::errc() ? cp : 0x110000, decoded);
+                    }
+                }
+                if (length > 0) {
+                    for (size_t i = 0; i < length; ++i) {
+                        text(decoded[i]);
+                    }
+                    pos = end + 1;
+                    continue;
+                }
+            }
+        }
+
+        text(c);
+        ++pos;
+    }
+}
+
+/**
+ * i3bar/swaybar JSON协议
+ */
+class I3barBackend : public OutputBackend {
+  public:
+    std::string_view name() const override {
+        return "i3bar";
+    }
+
+    std::string header() const override {
+        return "{ \"version\": 1, \"stop_signal\": " + std::to_string(System::STOP_SIGNAL) +
+               ", \"cont_signal\": " + std::to_string(System::CONT_SIGNAL) +
+               ", \"click_events\": true }\n[\n[],\n";
+    }
+
+    bool acceptsClicks() const override {
+        return true;
+    }
+
+    ModuleTemplate compile(const Module &module) const override {
+        std::string head = "{\"name\":\"";
+        appendJsonEscaped(module.getName(), head);
+        head += "\",\"instance\":\"" + std::to_string(module.getId()) +
+                "\",\"separator\":false,\"separator_block_width\":0,\"markup\":\"pango\",\"color\":\"";
+
+        ModuleTemplate tmpl;
+        for (size_t i = 0; i < COLOR_COUNT; ++i) {
+            tmpl.prefix[i] = head;
+            tmpl.prefix[i] += getColorString(static_cast<Color>(i));
+            tmpl.prefix[i] += "\",\"full_text\":\"";
+        }
+        tmpl.suffix = "\"},";
+        tmpl.suffix += SPACER_FRAGMENT;
+        tmpl.suffix += ',';
+        return tmpl;
+    }
+
+    void appendText(std::string_view markup, Color /*color*/, std::string &out) const override {
+        appendJsonEscaped(markup, out);
+    }
+
+    std::string_view frameBegin() const override {
+        return "[";
+    }
+
+    std::string_view frameEnd() const override {
+        return "],\n";
+    }
+};
+
+/**
+ * 纯UTF-8文本，每帧一行
+ */
+class PlainBackend : public OutputBackend {
+  public:
+    std::string_view name() const override {
+        return "plain";
+    }
+
+    std::string header() const override {
+        return {};
+    }
+
+    bool acceptsClicks() const override {
+        return false;
+    }
+
+    ModuleTemplate compile(const Module & /*module*/) const override {
+        ModuleTemplate tmpl;
+        tmpl.suffix = " ";
+        return tmpl;
+    }
+
+    void appendText(std::string_view markup, Color /*color*/, std::string &out) const override {
+        convertMarkup(
+            markup, [&out](char c) { out += c == '\n' ? ' ' : c; }, [](std::string_view) {}
+        );
+    }
+
+    std::string_view frameBegin() const override {
+        return {};
+    }
+
+    std::string_view frameEnd() const override {
+        return "\n";
+    }
+};
+
+/**
+ * lemonbar格式字符串
+ */
+class LemonbarBackend : public OutputBackend {
+  public:
+    std::string_view name() const override {
+        return "lemonbar";
+    }
+
+    std::string header() const override {
+        return {};
+    }
+
+    bool acceptsClicks() const override {
+        return false;
+    }
+
+    ModuleTemplate compile(const Module &module) const override {
+        // 点击时lemonbar在标准输出打印"click <模块ID> <按钮>"，可以转发给控制套接字
+        std::string actions;
+        const std::string id = std::to_string(module.getId());
+        for (int button = 1; button <= 5; ++button) {
+            actions += "%{A" + std::to_string(button) + ":click " + id + ' ' +
+                       std::to_string(button) + ":}";
+        }
+
+        ModuleTemplate tmpl;
+        for (size_t i = 0; i < COLOR_COUNT; ++i) {
+            tmpl.prefix[i] = actions + "%{F";
+            tmpl.prefix[i] += getColorString(static_cast<Color>(i));
+            tmpl.prefix[i] += '}';
+        }
+        tmpl.suffix = "%{F-}%{A}%{A}%{A}%{A}%{A} ";
+        return tmpl;
+    }
+
+    void appendText(std::string_view markup, Color color, std::string &out) const override {
+        convertMarkup(
+            markup,
+            [&out](char c) {
+                if (c == '%') {
+                    out += "%%";
+                } else {
+                    out += c == '\n' ? ' ' : c;
+                }
+            },
+            [&out, color](std::string_view value) {
+                out += "%{F";
+                out += value.empty() ? getColorString(color) : value;
+                out += '}';
+            }
+        );
+    }
+
+    std::string_view frameBegin() const override {
+        return "%{r}";
+    }
+
+    std::string_view frameEnd() const override {
+        return "\n";
+    }
+};
+
+/**
+ * tmux状态栏格式
+ */
+class TmuxBackend : public OutputBackend {
+  public:
+    std::string_view name() const override {
+        return "tmux";
+    }
+
+    std::string header() const override {
+        return {};
+    }
+
+    bool acceptsClicks() const override {
+        return false;
+    }
+
+    ModuleTemplate compile(const Module & /*module*/) const override {
+        ModuleTemplate tmpl;
+        for (size_t i = 0; i < COLOR_COUNT; ++i) {
+            tmpl.prefix[i] = "#[fg=";
+            tmpl.prefix[i] += getColorString(static_cast<Color>(i));
+            tmpl.prefix[i] += ']';
+        }
+        tmpl.suffix = "#[default] ";
+        return tmpl;
+    }
+
+    void appendText(std::string_view markup, Color color, std::string &out) const override {
+        convertMarkup(
+            markup,
+            [&out](char c) {
+                if (c == '#') {
+                    out += "##";
+                } else {
+                    out += c == '\n' ? ' ' : c;
+                }
+            },
+            [&out, color](std::string_view value) {
+                out += "#[fg=";
+                out += value.empty() ? getColorString(color) : value;
+                out += ']';
+            }
+        );
+    }
+
+    std::string_view frameBegin() const override {
+        return {};
+    }
+
+    std::string_view frameEnd() const override {
+        return "\n";
+    }
+};
+
+} // namespace
+
+std::unique_ptr<OutputBackend> makeOutputBackend(std::string_view name) {
+    if (name == "i3bar" || name == "swaybar") {
+        return std::make_unique<I3barBackend>();
+    }
+    if (name == "plain") {
+        return std::make_unique<PlainBackend>();
+    }
+    if (name == "lemonbar") {
+        return std::make_unique<LemonbarBackend>();
+    }
+    if (name == "tmux") {
+        return std::make_unique<TmuxBackend>();
+    }
+    return nullptr;
+}
@@ -0,0 +1,157 @@
+#include <output_writer.h>
+#include <system.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+OutputWriter::OutputWriter(System &system) : system_(system) {}
+
+bool OutputWriter::initialize(int fd) {
+    if (fcntl(fd, F_GETFL) == -1) {
+        std::cerr << "Invalid output descriptor: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    fd_ = fd;
+    return true;
+}
+
+void OutputWriter::write(std::string_view data) {
+    if (failed_) {
+        return;
+    }
+
+    if (inflight_offset_ == inflight_.size()) {
+        inflight_.clear();
+        inflight_offset_ = 0;
+    }
+    inflight_.append(data);
+    flush();
+}
+
+void OutputWriter::submitFrame(std::string_view frame) {
+    if (failed_) {
+        return;
+    }
+
+    ++stats_.frames_submitted;
+
+    // 上一份数据还没写完：只保留最新的一帧，未开始写出的旧帧直接丢弃
+    if (inflight_offset_ < inflight_.size()) {
+        if (has_pending_) {
+            ++stats_.frames_dropped;
+        }
+        pending_.assign(frame);
+        has_pending_ = true;
+        return;
+    }
+
+    inflight_.assign(frame);
+    inflight_offset_ = 0;
+    inflight_frame_ = true;
+    flush();
+}
+
+bool OutputWriter::hasPending() const {
+    return inflight_offset_ < inflight_.size() || has_pending_;
+}
+
+OutputWriter::Stats OutputWriter::getStats() const {
+    Stats stats = stats_;
+    stats.pending_bytes = inflight_.size() - inflight_offset_ + (has_pending_ ? pending_.size() : 0);
+    return stats;
+}
+
+void OutputWriter::flush() {
+    for (;;) {
+        if (inflight_offset_ == inflight_.size()) {
+            if (inflight_frame_) {
+                ++stats_.frames_written;
+                inflight_frame_ = false;
+            }
+            if (!has_pending_) {
+                break;
+            }
+
+            // 当前数据写完，接着写最新的一帧
+            inflight_.swap(pending_);
+            inflight_offset_ = 0;
+            inflight_frame_ = true;
+            has_pending_ = false;
+        }
+
+        // 描述符是阻塞的：先确认可写，再写出不超过PIPE_BUF的一段
+        // （只对管道和套接字成立，终端和普通文件上仍可能阻塞，见output_writer.h）
+        struct pollfd pfd = {fd_, POLLOUT, 0};
+        int ready;
+        do {
+            ready = poll(&pfd, 1, 0);
+            Telemetry::addSyscalls();
+        } while (ready == -1 && errno == EINTR);
+        if (ready == 0) {
+            ++stats_.stalls;
+            if (setWatching(true)) {
+                return;
+            }
+            // 无法用epoll等待（不会发生在管道上），直接阻塞写出
+        }
+
+        const size_t length = std::min<size_t>(inflight_.size() - inflight_offset_, PIPE_BUF);
+        const ssize_t n = ::write(fd_, inflight_.data() + inflight_offset_, length);
+        Telemetry::addSyscalls();
+        if (n > 0) {
+            inflight_offset_ += static_cast<size_t>(n);
+            stats_.bytes_written += static_cast<uint64_t>(n);
+            continue;
+        }
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        fail(n == -1 ? errno : EIO);
+        return;
+    }
+
+    setWatching(false);
+}
+
+void OutputWriter::onWritable(uint32_t /*events*/) {
+    // EPOLLERR/EPOLLHUP也在这里处理，下一次write()会返回EPIPE
+    flush();
+}
+
+bool OutputWriter::setWatching(bool enable) {
+    if (enable == watching_) {
+        return true;
+    }
+
+    if (enable) {
+        if (!system_.watchFd(fd_, EPOLLOUT, [this](uint32_t events) { onWritable(events); })) {
+            return false;
+        }
+    } else {
+        system_.unwatchFd(fd_);
+    }
+    watching_ = enable;
+    return true;
+}
+
+void OutputWriter::fail(int error) {
+    std::cerr << "Output write failed: " << strerror(error) << ", shutting down" << std::endl;
+
+    failed_ = true;
+    inflight_.clear();
+    inflight_offset_ = 0;
+    inflight_frame_ = false;
+    pending_.clear();
+    has_pending_ = false;
+    setWatching(false);
+
+    // 读取端（i3bar）已经退出，继续运行没有意义
+    system_.stop();
+}
@@ -0,0 +1,101 @@
+#include <sample_source.h>
+#include <telemetry.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+SampleSource::SampleSource(std::string path, size_t capacity)
+    : path_(std::move(path)), buffer_(capacity + 1) {}
+
+SampleSource::~SampleSource() {
+    if (fd_ != -1) {
+        close(fd_);
+    }
+}
+
+Result<std::string_view> SampleSource::read() {
+    if (fd_ == -1) {
+        if (backoff_.count() != 0 && std::chrono::steady_clock::now() < retry_at_) {
+            return Error{Errc::UNAVAILABLE};
+        }
+
+        fd_ = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+        Telemetry::addSyscalls();
+        if (fd_ == -1) {
+            const int err = errno;
+            const bool missing = err == ENOENT || err == ENODEV || err == ENXIO;
+            return fail({missing ? Errc::NOT_FOUND : Errc::IO, err});
+        }
+    }
+
+    ssize_t length;
+    do {
+        length = pread(fd_, buffer_.data(), buffer_.size() - 1, 0);
+        Telemetry::addSyscalls();
+    } while (length == -1 && errno == EINTR);
+
+    if (length == -1) {
+        return fail({Errc::IO, errno});
+    }
+
+    if (backoff_.count() != 0) {
+        std::cerr << "SampleSource: " << path_ << " is available again" << std::endl;
+        backoff_ = std::chrono::seconds(0);
+    }
+
+    Telemetry::addBytesRead(static_cast<uint64_t>(length));
+    buffer_[static_cast<size_t>(length)] = '\0';
+    return std::string_view(buffer_.data(), static_cast<size_t>(length));
+}
+
+Result<uint64_t> SampleSource::readUint64() {
+    const Result<std::string_view> text = read();
+    if (!text) {
+        return text.error();
+    }
+    return parseUint64(*text);
+}
+
+const std::string &SampleSource::getPath() const {
+    return path_;
+}
+
+Error SampleSource::fail(Error error) {
+    if (fd_ != -1) {
+        close(fd_);
+        Telemetry::addSyscalls();
+        fd_ = -1;
+    }
+
+    // 只在开始失败时记录一次，重新探测失败时不再重复
+    if (backoff_.count() == 0) {
+        std::cerr << "SampleSource: " << path_ << " unavailable (" << errcName(error.code)
+                  << (error.sys_errno != 0 ? ": " : "")
+                  << (error.sys_errno != 0 ? strerror(error.sys_errno) : "")
+                  << "), probing again with backoff" << std::endl;
+        backoff_ = MIN_BACKOFF;
+    } else {
+        backoff_ = std::min(backoff_ * 2, MAX_BACKOFF);
+    }
+
+    retry_at_ = std::chrono::steady_clock::now() + backoff_;
+    return error;
+}
+
+Result<uint64_t> parseUint64(std::string_view text) {
+    const size_t start = text.find_first_not_of(" \t\n");
+    if (start == std::string_view::npos) {
+        return Error{Errc::PARSE};
+    }
+
+    uint64_t value = 0;
+    const auto result = std::from_chars(text.data() + start, text.data() + text.size(), value);
+    if (result.ec != std::errc()) {
+        return Error{Errc::PARSE};
+    }
+    return value;
+}
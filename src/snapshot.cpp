@@ -0,0 +1,158 @@
+#include <snapshot.h>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+
+// 文件格式版本，格式变化时递增
+constexpr std::string_view MAGIC = "seedstatus-snapshot 1";
+
+// 单个条目的上限，防止损坏的文件导致巨大的分配
+constexpr size_t MAX_FIELD_SIZE = 64 * 1024;
+constexpr size_t MAX_COUNTERS = 64;
+
+int64_t toNanoseconds(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+} // namespace
+
+std::string Snapshot::defaultPath() {
+    if (const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR"); runtime_dir && *runtime_dir) {
+        return std::string(runtime_dir) + "/seedstatus.snapshot";
+    }
+    return {};
+}
+
+bool Snapshot::save(const std::string &path, const std::string &boot_id,
+                    const ModuleManager &manager) {
+    // 格式：
+    //   seedstatus-snapshot 1
+    //   boot <boot_id>
+    //   time <steady_clock纳秒>
+    //   每个模块一条：<名称长度> <输出长度> <颜色> <计数器个数> <计数器...>\n<名称><输出>\n
+    std::string data;
+    data += MAGIC;
+    data += "\nboot " + boot_id;
+    data += "\ntime " + std::to_string(toNanoseconds(std::chrono::steady_clock::now())) + '\n';
+
+    std::vector<uint64_t> counters;
+    for (const auto &module : manager.getModules()) {
+        if (!module) {
+            continue;
+        }
+
+        counters.clear();
+        // 采样进行中的模块，计数器可能正在被工作线程写入
+        if (manager.isReady(module->getId()) && !manager.isSampling(module->getId())) {
+            module->saveCounters(counters);
+        }
+
+        data += std::to_string(module->getName().size()) + ' ' +
+                std::to_string(module->getOutput().size()) + ' ' +
+                std::to_string(static_cast<int>(module->getColor())) + ' ' +
+                std::to_string(counters.size());
+        for (const uint64_t counter : counters) {
+            data += ' ' + std::to_string(counter);
+        }
+        data += '\n';
+        data += module->getName();
+        data += module->getOutput();
+        data += '\n';
+    }
+
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file.flush()) {
+            std::cerr << "Failed to write snapshot " << temp_path << std::endl;
+            return false;
+        }
+    }
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to replace snapshot " << path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::optional<Snapshot> Snapshot::load(const std::string &path, const std::string &boot_id) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || line != MAGIC) {
+        return std::nullopt;
+    }
+    if (!std::getline(file, line) || line != "boot " + boot_id || boot_id.empty()) {
+        return std::nullopt;
+    }
+
+    Snapshot snapshot;
+    int64_t saved_ns = 0;
+    if (!std::getline(file, line) || std::sscanf(line.c_str(), "time %ld", &saved_ns) != 1) {
+        return std::nullopt;
+    }
+    snapshot.saved_at_ = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(saved_ns));
+
+    const auto age = snapshot.getAge();
+    if (age < std::chrono::steady_clock::duration::zero() || age > MAX_AGE) {
+        return std::nullopt;
+    }
+
+    while (std::getline(file, line)) {
+        std::istringstream header(line);
+        size_t name_size = 0, output_size = 0, counter_count = 0;
+        int color = 0;
+        if (!(header >> name_size >> output_size >> color >> counter_count) ||
+            name_size > MAX_FIELD_SIZE || output_size > MAX_FIELD_SIZE ||
+            counter_count > MAX_COUNTERS || color < 0 || static_cast<size_t>(color) >= COLOR_COUNT) {
+            return std::nullopt;
+        }
+
+        Entry entry;
+        entry.color = static_cast<Color>(color);
+        entry.counters.resize(counter_count);
+        for (uint64_t &counter : entry.counters) {
+            if (!(header >> counter)) {
+                return std::nullopt;
+            }
+        }
+
+        entry.name.resize(name_size);
+        entry.output.resize(output_size);
+        if (!file.read(entry.name.data(), static_cast<std::streamsize>(name_size)) ||
+            !file.read(entry.output.data(), static_cast<std::streamsize>(output_size)) ||
+            file.get() != '\n') {
+            return std::nullopt;
+        }
+        snapshot.entries_.push_back(std::move(entry));
+    }
+
+    return snapshot;
+}
+
+const Snapshot::Entry *Snapshot::find(std::string_view name, size_t occurrence) const {
+    for (const Entry &entry : entries_) {
+        if (entry.name == name && occurrence-- == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+std::chrono::steady_clock::duration Snapshot::getAge() const {
+    return std::chrono::steady_clock::now() - saved_at_;
+}
+
+size_t Snapshot::size() const {
+    return entries_.size();
+}
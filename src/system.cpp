@@ -1,14 +1,27 @@
 #include <system.h>
+#include <alsa_mixer.h>
 #include <modules/date.h>
 #include <modules/temp.h>
+#include <probes.h>
+#include <sys/signalfd.h>
 #include <unistd.h>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <stdexcept>
 
 System::System() = default;
 
-System::~System() = default;
+System::~System() {
+    // 先停止工作线程，尚未执行的完成回调引用了System
+    workers_.shutdown();
+
+    // 再销毁挂起的协程，它们的帧引用了模块
+    tasks_.shutdown();
+
+    // 先销毁模块，它们在析构时可能还需要注销监听
+    module_manager_.clear();
+}
 
 bool System::initialize() {
     try {
@@ -17,6 +30,32 @@ bool System::initialize() {
             return false;
         }
 
+        // 在模块创建线程之前接管信号
+        if (!setupSignals()) {
+            epoll_fd_wrapper_.reset();
+            return false;
+        }
+
+        // 工作线程继承上面阻塞的信号掩码；线程池不可用时阻塞操作同步执行
+        if (workers_.initialize()) {
+            if (!watchFd(workers_.getFd(), EPOLLIN, [this](uint32_t) { workers_.runCompletions(); })) {
+                workers_.shutdown();
+            }
+        }
+        module_manager_.setWorkerPool(&workers_);
+
+        // 协程的定时器
+        if (!tasks_.initialize()) {
+            epoll_fd_wrapper_.reset();
+            return false;
+        }
+
+        // 接管标准输出：描述符保持阻塞，写出前用poll()确认可写，i3bar停止读取时不会阻塞事件循环
+        if (!output_.initialize()) {
+            epoll_fd_wrapper_.reset();
+            return false;
+        }
+
         // 初始化定时器
         if (!timer_.initialize(epoll_fd_wrapper_.get())) {
             epoll_fd_wrapper_.reset();
@@ -29,11 +68,23 @@ bool System::initialize() {
             return false;
         }
 
-        // 初始化所有模块
+        // 先输出i3bar协议头，模块初始化期间状态栏已经可以显示内容
+        outputProtocolHeader();
+        traceStartup("protocol header");
+
+        // 初始化所有模块，耗时的准备在工作线程中进行
         initializeModules();
 
-        // 输出i3bar协议头
-        outputProtocolHeader();
+        // 控制套接字不可用时不影响状态栏本身
+        control_.start();
+
+        // 立即输出第一帧，尚未就绪的模块显示占位内容
+        outputFrame();
+        traceStartup("first frame (" + std::to_string(starts_pending_) + " modules pending)");
+        if (starts_pending_ == 0) {
+            AlsaMixerHub::releasePreloaded();
+            traceStartup("complete frame");
+        }
 
         running_ = true;
         return true;
@@ -53,11 +104,15 @@ void System::run() {
     struct epoll_event events[MAX_EVENTS];
 
     // 初始输出所有模块
-    module_manager_.outputModules();
+    outputFrame();
 
     // 主事件循环
     while (running_) {
-        int nfds = epoll_wait(epoll_fd_wrapper_.get(), events, MAX_EVENTS, -1);
+        // 有采样在工作线程中进行时，最迟在其超时时刻醒来
+        const int timeout = module_manager_.getSampleWaitTimeout();
+        int nfds = epoll_wait(epoll_fd_wrapper_.get(), events, MAX_EVENTS, timeout);
+        Telemetry::addSyscalls();
+        SEEDSTATUS_PROBE1(loop_wakeup, nfds);
         if (nfds == -1) {
             if (errno == EINTR) {
                 continue; // 被信号中断，继续循环
@@ -65,6 +120,9 @@ void System::run() {
             std::cerr << "epoll_wait error: " << strerror(errno) << std::endl;
             continue;
         }
+        const auto iteration_start = std::chrono::steady_clock::now();
+        const uint64_t trace_start = Trace::isEnabled() ? Trace::now() : 0;
+        module_manager_.beginIteration();
 
         // 处理所有事件
         try {
@@ -73,15 +131,172 @@ void System::run() {
             std::cerr << "Error handling events: " << e.what() << std::endl;
         }
 
+        // 超时的采样显示过时标记，事件循环不等待它们
+        module_manager_.expireSamples();
+
+        // 提交本轮事件中累积的操作（如合并后的音量调节）
+        module_manager_.flushPending();
+
+        checkWatchdog(iteration_start);
+
+        // 状态栏被隐藏时不输出
+        if (paused_) {
+            telemetry_.recordIteration(iteration_start, 0);
+            if (trace_start != 0) {
+                Trace::complete(TraceKind::ITERATION, static_cast<uint32_t>(nfds), trace_start,
+                                Trace::now());
+            }
+            continue;
+        }
+
         // 输出所有模块的更新
-        module_manager_.outputModules();
+        telemetry_.recordIteration(iteration_start, outputFrame());
+        if (trace_start != 0) {
+            Trace::complete(TraceKind::ITERATION, static_cast<uint32_t>(nfds), trace_start,
+                            Trace::now());
+        }
+    }
+
+    // 退出前保存快照，下一次启动（如i3重新加载配置）立即显示
+    saveSnapshot();
+    flushTrace();
+}
+
+bool System::flushTrace() const {
+    return Trace::flush([this](uint32_t id) -> const std::string * {
+        const auto &modules = module_manager_.getModules();
+        return id < modules.size() && modules[id] ? &modules[id]->getName() : nullptr;
+    });
+}
+
+void System::checkWatchdog(std::chrono::steady_clock::time_point start) {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed <= FRAME_WATCHDOG) {
+        return;
+    }
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    const ModuleManager::SlowestUpdate slowest = module_manager_.getSlowestUpdate();
+    const std::shared_ptr<Module> module = slowest.id < module_manager_.getModuleCount()
+                                               ? module_manager_.getModule(slowest.id)
+                                               : nullptr;
+
+    std::cerr << "Watchdog: event loop iteration took " << ms << " ms";
+    // 最慢的update()不足一半时，时间主要花在点击、fd处理函数或协程中
+    if (module && slowest.ns * 2 >= std::chrono::nanoseconds(elapsed).count()) {
+        std::cerr << ", stalled by " << module->getName() << " update ("
+                  << slowest.ns / 1000000 << " ms)";
+    } else {
+        std::cerr << ", mostly outside module updates (clicks, fd handlers or tasks)";
     }
+    std::cerr << std::endl;
 }
 
 void System::stop() {
     running_ = false;
 }
 
+bool System::setupSignals() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, STOP_SIGNAL);
+    sigaddset(&mask, CONT_SIGNAL);
+    sigaddset(&mask, TELEMETRY_SIGNAL);
+    for (int signo = SIGRTMIN; signo <= SIGRTMAX; ++signo) {
+        sigaddset(&mask, signo);
+    }
+
+    // 写出到已退出的i3bar时返回EPIPE而不是直接终止进程
+    // （子进程由Launcher重置为默认处理方式）
+    ::signal(SIGPIPE, SIG_IGN);
+
+    // 阻塞后信号只能通过signalfd读取，之后创建的线程继承该掩码
+    if (sigprocmask(SIG_BLOCK, &mask, nullptr) == -1) {
+        std::cerr << "Failed to block signals: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd == -1) {
+        std::cerr << "Failed to create signalfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+    signal_fd_wrapper_.reset(fd);
+
+    return watchFd(fd, EPOLLIN, [this](uint32_t) { handleSignals(); });
+}
+
+void System::handleSignals() {
+    struct signalfd_siginfo info;
+
+    while (read(signal_fd_wrapper_.get(), &info, sizeof(info)) == sizeof(info)) {
+        const int signo = static_cast<int>(info.ssi_signo);
+
+        if (signo == SIGINT || signo == SIGTERM) {
+            std::cerr << "\nReceived signal " << (signo == SIGINT ? "SIGINT" : "SIGTERM") << " ("
+                      << signo << "), shutting down..." << std::endl;
+            stop();
+        } else if (signo == TELEMETRY_SIGNAL) {
+            std::cerr << telemetry_.report(module_manager_) << std::flush;
+            flushTrace();
+        } else if (signo == STOP_SIGNAL) {
+            suspend();
+        } else if (signo == CONT_SIGNAL) {
+            resume();
+        } else if (signo >= SIGRTMIN && signo <= SIGRTMAX) {
+            // i3blocks风格的刷新信号：SIGRTMIN+N更新所有使用信号N的模块
+            if (module_manager_.refreshBySignal(signo - SIGRTMIN) == 0) {
+                std::cerr << "No module uses refresh signal " << signo - SIGRTMIN << std::endl;
+            }
+        }
+    }
+}
+
+void System::suspend() {
+    if (paused_) {
+        return;
+    }
+
+    paused_ = true;
+    timer_.pause();
+    std::cerr << "Status bar hidden, sampling suspended" << std::endl;
+}
+
+void System::resume() {
+    if (!paused_) {
+        return;
+    }
+
+    paused_ = false;
+    timer_.resume();
+    std::cerr << "Status bar visible, sampling resumed" << std::endl;
+
+    // 隐藏期间的数据已经过时，立即完整刷新一次，随后由run()输出
+    module_manager_.refreshAll();
+}
+
+void System::setOutputBackend(std::unique_ptr<OutputBackend> backend) {
+    module_manager_.setBackend(std::move(backend));
+}
+
+void System::setReprobeHardware(bool reprobe) {
+    reprobe_hardware_ = reprobe;
+}
+
+void System::setVolumeStep(uint64_t step) {
+    volume_step_ = step;
+}
+
+void System::setVolumeCommand(std::string command) {
+    volume_command_ = std::move(command);
+}
+
+const HardwareProfile &System::getHardware() const {
+    return hardware_;
+}
+
 void System::addModule(std::shared_ptr<Module> module) {
     if (!module) {
         throw std::invalid_argument("Module cannot be null");
@@ -89,29 +304,133 @@ void System::addModule(std::shared_ptr<Module> module) {
 
     try {
         module_manager_.addModule(module);
+        module->system_ = this;
+        restoreFromSnapshot(*module);
 
-        // 初始化模块
-        module->init();
+        // 耗时的准备在工作线程中进行，模块就绪前只显示占位内容
+        if (module->isAsyncStart()) {
+            beginAsyncStart(module);
+            return;
+        }
 
-        // 如果模块有文件描述符，则添加到epoll
-        int fd = module->getFd();
-        if (fd != -1) {
-            if (!addToEpoll(fd, module)) {
-                throw std::runtime_error("Failed to add module to epoll");
-            }
+        module->start();
+        finishStart(module);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to add module " << module->getName() << ": " << e.what() << std::endl;
+        throw;
+    }
+}
+
+void System::restoreFromSnapshot(Module &module) {
+    if (!snapshot_) {
+        return;
+    }
+
+    // 同名模块（如两个CPU模块）按注册顺序对应
+    size_t occurrence = 0;
+    for (ModuleId id = 0; id < module.getId(); ++id) {
+        const auto &other = module_manager_.getModules()[id];
+        if (other && other->getName() == module.getName()) {
+            ++occurrence;
         }
+    }
+
+    const Snapshot::Entry *entry = snapshot_->find(module.getName(), occurrence);
+    if (!entry) {
+        return;
+    }
+    module.setOutput(entry->output, entry->color);
+    module.restoreCounters(entry->counters);
+}
 
-        // 如果模块有更新间隔，则添加到定时器
-        if (module->getInterval() > 0) {
-            timer_.addIntervalModule(module);
+void System::saveSnapshot() {
+    if (snapshot_path_.empty() || hardware_.boot_id.empty()) {
+        return;
+    }
+    Snapshot::save(snapshot_path_, hardware_.boot_id, module_manager_);
+}
+
+void System::finishStart(const std::shared_ptr<Module> &module) {
+    // 初始化模块
+    module->init();
+
+    // 如果模块有文件描述符，则添加到epoll
+    int fd = module->getFd();
+    if (fd != -1) {
+        if (!addToEpoll(fd, module)) {
+            throw std::runtime_error("Failed to add module to epoll");
         }
+    }
 
-        // 立即更新一次
-        module->update();
+    // 从现在起接收更新和点击，立即更新一次
+    module_manager_.setReady(module->getId(), true);
+    module_manager_.refreshModule(module->getId());
+}
+
+void System::beginAsyncStart(std::shared_ptr<Module> module) {
+    module_manager_.setReady(module->getId(), false);
+    ++starts_pending_;
+
+    // 结果由工作线程写入，完成回调在事件循环线程中读取
+    auto result = std::make_shared<StartResult>();
+    result->module = std::move(module);
+
+    workers_.submit(
+        [result]() {
+            const auto begin = std::chrono::steady_clock::now();
+            try {
+                result->module->start();
+            } catch (const std::exception &e) {
+                result->error = e.what();
+            } catch (...) {
+                result->error = "unknown error";
+            }
+            result->elapsed = std::chrono::steady_clock::now() - begin;
+        },
+        [this, result]() { handleStartResult(*result); }
+    );
+}
+
+void System::handleStartResult(const StartResult &result) {
+    Module &module = *result.module;
+    if (!result.error.empty()) {
+        std::cerr << "Module " << module.getName() << " start failed: " << result.error
+                  << std::endl;
+    }
+
+    try {
+        finishStart(result.module);
     } catch (const std::exception &e) {
-        std::cerr << "Failed to add module " << module->getName() << ": " << e.what() << std::endl;
-        throw;
+        std::cerr << "Failed to initialize module " << module.getName() << ": " << e.what()
+                  << std::endl;
+    }
+    --starts_pending_;
+
+    char elapsed[32];
+    std::snprintf(elapsed, sizeof(elapsed), "%.1f",
+                  std::chrono::duration<double, std::milli>(result.elapsed).count());
+    traceStartup("module " + module.getName() + " ready (start() took " + elapsed + " ms)");
+
+    if (starts_pending_ != 0) {
+        return;
+    }
+
+    // 所有模块均已就绪，不会再有模块接管预先加载的混音器
+    AlsaMixerHub::releasePreloaded();
+    if (!paused_) {
+        outputFrame();
     }
+    traceStartup("complete frame");
+}
+
+void System::traceStartup(const std::string &event) const {
+    const double elapsed = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - startup_begin_
+    )
+                               .count();
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f", elapsed);
+    std::cerr << "Startup: " << event << " after " << text << " ms" << std::endl;
 }
 
 bool System::addToEpoll(int fd, std::shared_ptr<Module> module) {
@@ -122,8 +441,9 @@ bool System::addToEpoll(int fd, std::shared_ptr<Module> module) {
     struct epoll_event ev{};
     ev.events = EPOLLIN | EPOLLET;
 
-    // 使用void*存储模块指针
-    ev.data.ptr = module.get();
+    // 存储模块ID，定时器使用单独的来源标记
+    ev.data.u64 = module ? makeEventData(EventSource::MODULE, module->getId())
+                         : makeEventData(EventSource::TIMER, 0);
 
     if (epoll_ctl(epoll_fd_wrapper_.get(), EPOLL_CTL_ADD, fd, &ev) == -1) {
         std::cerr << "Failed to add fd " << fd << " to epoll: " << strerror(errno) << std::endl;
@@ -147,6 +467,103 @@ bool System::removeFromEpoll(int fd) {
     return true;
 }
 
+uint64_t System::makeEventData(EventSource source, uint32_t index) {
+    return (static_cast<uint64_t>(source) << 32) | index;
+}
+
+bool System::watchFd(int fd, uint32_t events, FdHandler handler) {
+    if (fd < 0 || !handler) {
+        return false;
+    }
+    if (watch_slots_.count(fd)) {
+        std::cerr << "fd " << fd << " is already watched" << std::endl;
+        return false;
+    }
+
+    uint32_t slot;
+    if (!free_watch_slots_.empty()) {
+        slot = free_watch_slots_.back();
+        free_watch_slots_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(watches_.size());
+        watches_.emplace_back();
+    }
+
+    struct epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = makeEventData(EventSource::WATCH, slot);
+
+    if (epoll_ctl(epoll_fd_wrapper_.get(), EPOLL_CTL_ADD, fd, &ev) == -1) {
+        std::cerr << "Failed to watch fd " << fd << ": " << strerror(errno) << std::endl;
+        free_watch_slots_.push_back(slot);
+        return false;
+    }
+
+    watches_[slot].fd = fd;
+    watches_[slot].handler = std::move(handler);
+    watch_slots_.emplace(fd, slot);
+    return true;
+}
+
+bool System::modifyWatch(int fd, uint32_t events) {
+    const auto it = watch_slots_.find(fd);
+    if (it == watch_slots_.end()) {
+        return false;
+    }
+
+    struct epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = makeEventData(EventSource::WATCH, it->second);
+
+    if (epoll_ctl(epoll_fd_wrapper_.get(), EPOLL_CTL_MOD, fd, &ev) == -1) {
+        std::cerr << "Failed to modify watch on fd " << fd << ": " << strerror(errno)
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool System::unwatchFd(int fd) {
+    const auto it = watch_slots_.find(fd);
+    if (it == watch_slots_.end()) {
+        return false;
+    }
+
+    const uint32_t slot = it->second;
+    watch_slots_.erase(it);
+
+    if (epoll_fd_wrapper_.get() != -1 &&
+        epoll_ctl(epoll_fd_wrapper_.get(), EPOLL_CTL_DEL, fd, nullptr) == -1) {
+        std::cerr << "Failed to unwatch fd " << fd << ": " << strerror(errno) << std::endl;
+    }
+
+    // 槽位在本轮事件处理结束后才复用，避免同一批次中残留的事件被错误分发
+    watches_[slot].fd = -1;
+    watches_[slot].handler = nullptr;
+    released_watch_slots_.push_back(slot);
+    return true;
+}
+
+WorkerPool &System::getWorkerPool() {
+    return workers_;
+}
+
+TaskScheduler &System::getTaskScheduler() {
+    return tasks_;
+}
+
+const Telemetry &System::getTelemetry() const {
+    return telemetry_;
+}
+
+Launcher &System::getLauncher() {
+    return launcher_;
+}
+
+OutputWriter &System::getOutputWriter() {
+    return output_;
+}
+
 ModuleManager &System::getModuleManager() {
     return module_manager_;
 }
@@ -174,46 +591,151 @@ bool System::createEpoll() {
 #include <modules/audio.h>
 #include <modules/backlight.h>
 #include <modules/battery.h>
+#include <modules/script.h>
 
 void System::initializeModules() {
-    // 添加Stdin模块，用于处理点击事件
-    addModule(std::make_shared<StdinModule>(this));
+    // 添加Stdin模块，用于处理点击事件（只有i3bar协议通过标准输入发送点击）
+    if (module_manager_.getBackend().acceptsClicks()) {
+        addModule(std::make_shared<StdinModule>());
+    }
+
+    // 只创建有对应硬件的模块
+    hardware_ = HardwareProbe::load(reprobe_hardware_);
+
+    // 上一个进程留下的快照，注册模块时用来填充首次更新前的内容
+    snapshot_path_ = Snapshot::defaultPath();
+    if (!snapshot_path_.empty()) {
+        snapshot_ = Snapshot::load(snapshot_path_, hardware_.boot_id);
+        if (snapshot_) {
+            char age[32];
+            std::snprintf(age, sizeof(age), "%.1f",
+                          std::chrono::duration<double>(snapshot_->getAge()).count());
+            traceStartup("snapshot restored (" + std::to_string(snapshot_->size()) +
+                         " modules, " + age + " s old)");
+        }
+    }
+
+    // 优先使用RAPL，没有时使用SVI2遥测
+    CpuModule::PowerInterface power = CpuModule::PowerInterface::NONE;
+    std::string power_dir;
+    if (!hardware_.rapl.empty()) {
+        power = CpuModule::PowerInterface::RAPL;
+        power_dir = hardware_.rapl;
+    } else if (!hardware_.svi2.empty()) {
+        power = CpuModule::PowerInterface::SVI2;
+        power_dir = hardware_.svi2;
+    }
+
     // 按照指定顺序初始化模块
-    addModule(std::make_shared<BatteryModule>());    // Battery Status
-    addModule(std::make_shared<BacklightModule>());  // Backlight Control
-    addModule(std::make_shared<MicrophoneModule>()); // Microphone Control
-    addModule(std::make_shared<VolumeModule>());     // Volume Control
-    addModule(std::make_shared<NetworkModule>());    // Network Status
-    addModule(std::make_shared<GpuModule>());        // GPU Usage
-    addModule(std::make_shared<MemoryModule>());     // Memory Usage
-    auto p = std::make_shared<CpuModule>();          // CPU Power
-    p->setState(1);
-    addModule(p);
-    addModule(std::make_shared<CpuModule>()); // CPU Usage
-    addModule(std::make_shared<TempModule>());
+    if (hardware_.battery) {
+        addModule(std::make_shared<BatteryModule>()); // Battery Status
+    }
+    if (!hardware_.backlight.empty()) {
+        addModule(std::make_shared<BacklightModule>(hardware_.backlight)); // Backlight Control
+    }
+    // 音量步长和外部脚本对两个音频模块都生效
+    const auto configureAudio = [this](const std::shared_ptr<AudioModule> &audio) {
+        if (volume_step_ != 0) {
+            audio->setVolumeStep(volume_step_);
+        }
+        audio->setVolumeCommand(volume_command_);
+        return audio;
+    };
+    if (hardware_.capture) {
+        addModule(configureAudio(std::make_shared<MicrophoneModule>())); // Microphone Control
+    }
+    if (hardware_.playback) {
+        addModule(configureAudio(std::make_shared<VolumeModule>())); // Volume Control
+    }
+    addModule(std::make_shared<NetworkModule>()); // Network Status
+    if (!hardware_.gpu.empty()) {
+        addModule(std::make_shared<GpuModule>(hardware_.gpu)); // GPU Usage
+    }
+    addModule(std::make_shared<MemoryModule>()); // Memory Usage
+    if (power != CpuModule::PowerInterface::NONE) {
+        auto p = std::make_shared<CpuModule>(power, power_dir); // CPU Power
+        p->setState(1);
+        addModule(p);
+    }
+    addModule(std::make_shared<CpuModule>(power, power_dir)); // CPU Usage
+    if (!hardware_.cpu_temp.empty()) {
+        addModule(std::make_shared<TempModule>(hardware_.cpu_temp));
+    }
+    // 用户脚本（~/.config/seedstatus/scripts.conf）
+    for (auto &script : ScriptModule::loadConfig(ScriptModule::defaultConfigPath())) {
+        addModule(script);
+    }
     addModule(std::make_shared<DateModule>());
+
+    snapshot_.reset();
 }
 
 void System::handleEvents(struct epoll_event *events, int nfds) {
 
     for (int i = 0; i < nfds; ++i) {
-
-        // 检查是否是定时器事件
-        if (events[i].data.ptr == nullptr) {
-            timer_.update();
-        } else {
-            // 其他模块事件
-            Module *module = static_cast<Module *>(events[i].data.ptr);
-            if (module) {
-                module->update();
+        const auto source = static_cast<EventSource>(events[i].data.u64 >> 32);
+        const auto index = static_cast<uint32_t>(events[i].data.u64);
+        Trace::instant(TraceKind::WAKEUP, static_cast<uint32_t>(source), index);
+        SEEDSTATUS_PROBE2(event_dispatch, static_cast<uint32_t>(source), index);
+
+        switch (source) {
+        case EventSource::TIMER:
+            // 定时器事件
+            if (const uint64_t expirations = timer_.update(); expirations > 0) {
+                SEEDSTATUS_PROBE2(timer_tick, expirations, timer_.getCounter());
+                module_manager_.dispatchTick(timer_.getCounter());
+                telemetry_.recordTick();
+                // 一次到期多次（循环卡住或进程被暂停后恢复）时计数可能跳过整倍数
+                if (timer_.getCounter() - last_saved_counter_ >= Snapshot::SAVE_INTERVAL) {
+                    last_saved_counter_ = timer_.getCounter();
+                    saveSnapshot();
+                }
+            }
+            break;
+        case EventSource::MODULE:
+            // 模块事件，按模块ID分发
+            module_manager_.dispatchEvent(index);
+            break;
+        case EventSource::WATCH:
+            // 通用监听，槽位已被注销时忽略
+            if (index < watches_.size() && watches_[index].handler) {
+                // 复制一份处理函数，处理函数内部可能注销自身
+                FdHandler handler = watches_[index].handler;
+                handler(events[i].events);
             }
+            break;
+        default:
+            break;
         }
     }
+
+    // 本轮注销的槽位现在可以复用
+    free_watch_slots_.insert(
+        free_watch_slots_.end(), released_watch_slots_.begin(), released_watch_slots_.end()
+    );
+    released_watch_slots_.clear();
 }
 
 void System::outputProtocolHeader() {
-    std::cout << "{ \"version\": 1, \"click_events\": true }" << std::endl;
-    std::cout << '[' << std::endl;
-    std::cout << "[]," << std::endl;
-    std::cout.flush();
+    const std::string header = module_manager_.getBackend().header();
+    if (!header.empty()) {
+        output_.write(header);
+    }
+}
+
+size_t System::outputFrame() {
+    if (!module_manager_.hasFrameChanges()) {
+        return 0;
+    }
+
+    TraceSpan span(TraceKind::OUTPUT, 0);
+    try {
+        const std::string &frame = module_manager_.buildFrame();
+        output_.submitFrame(frame);
+        SEEDSTATUS_PROBE1(frame_emit, frame.size());
+        return frame.size();
+    } catch (const std::exception &e) {
+        std::cerr << "Error in outputFrame: " << e.what() << std::endl;
+    }
+    return 0;
 }
\ No newline at end of file
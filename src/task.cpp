@@ -0,0 +1,281 @@
+#include <task.h>
+#include <system.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+namespace {
+
+// 空闲链表节点，复用已释放帧的开头
+struct FreeBlock {
+    FreeBlock *next;
+};
+
+constexpr size_t SIZE_CLASSES = FramePool::MAX_POOLED_SIZE / FramePool::GRANULARITY;
+
+// 每个大小级别的空闲链表，第i级存放(i+1)*GRANULARITY字节的帧
+std::array<FreeBlock *, SIZE_CLASSES> free_lists{};
+FramePool::Stats pool_stats;
+
+// 帧大小对应的级别，超出内存池范围时为SIZE_CLASSES
+size_t sizeClass(size_t size) {
+    if (size == 0 || size > FramePool::MAX_POOLED_SIZE) {
+        return SIZE_CLASSES;
+    }
+    return (size - 1) / FramePool::GRANULARITY;
+}
+
+} // namespace
+
+void *FramePool::allocate(size_t size) {
+    ++pool_stats.allocations;
+
+    const size_t index = sizeClass(size);
+    if (index == SIZE_CLASSES) {
+        ++pool_stats.heap_allocations;
+        return ::operator new(size);
+    }
+
+    if (FreeBlock *block = free_lists[index]) {
+        free_lists[index] = block->next;
+        ++pool_stats.pool_hits;
+        --pool_stats.cached_blocks;
+        return block;
+    }
+
+    // 按级别的完整大小分配，释放后可被同级别的任意帧复用
+    ++pool_stats.heap_allocations;
+    return ::operator new((index + 1) * GRANULARITY);
+}
+
+void FramePool::deallocate(void *ptr, size_t size) noexcept {
+    if (!ptr) {
+        return;
+    }
+
+    const size_t index = sizeClass(size);
+    if (index == SIZE_CLASSES) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    auto *block = static_cast<FreeBlock *>(ptr);
+    block->next = free_lists[index];
+    free_lists[index] = block;
+    ++pool_stats.cached_blocks;
+}
+
+FramePool::Stats FramePool::getStats() {
+    return pool_stats;
+}
+
+void TaskPromiseBase::finishRoot(TaskScheduler &scheduler, std::coroutine_handle<> handle,
+                                 std::exception_ptr exception) noexcept {
+    scheduler.finishRoot(handle, std::move(exception));
+}
+
+SleepAwaiter::~SleepAwaiter() {
+    if (pending_ && scheduler_) {
+        scheduler_->cancelTimer(timer_);
+    }
+}
+
+bool SleepAwaiter::suspend(std::coroutine_handle<> handle, TaskScheduler *scheduler) {
+    if (!scheduler) {
+        std::cerr << "sleepFor() awaited outside of a spawned task, not sleeping" << std::endl;
+        return false;
+    }
+
+    scheduler_ = scheduler;
+    handle_ = handle;
+    timer_ = scheduler->addTimer(std::chrono::steady_clock::now() + duration_, this);
+    pending_ = true;
+    return true;
+}
+
+ReadableAwaiter::~ReadableAwaiter() {
+    if (pending_ && scheduler_) {
+        scheduler_->system_.unwatchFd(fd_);
+    }
+}
+
+bool ReadableAwaiter::suspend(std::coroutine_handle<> handle, TaskScheduler *scheduler) {
+    if (!scheduler) {
+        std::cerr << "readable() awaited outside of a spawned task" << std::endl;
+        revents_ = EPOLLERR;
+        return false;
+    }
+
+    scheduler_ = scheduler;
+    handle_ = handle;
+    if (!scheduler->system_.watchFd(fd_, events_, [this](uint32_t revents) { onReady(revents); })) {
+        revents_ = EPOLLERR;
+        return false;
+    }
+    pending_ = true;
+    return true;
+}
+
+void ReadableAwaiter::onReady(uint32_t revents) {
+    // 一次性监听：恢复之前注销，协程可以立即再次等待同一个fd
+    scheduler_->system_.unwatchFd(fd_);
+    pending_ = false;
+    revents_ = revents;
+    handle_.resume();
+}
+
+TaskScheduler::TaskScheduler(System &system) : system_(system) {}
+
+TaskScheduler::~TaskScheduler() {
+    shutdown();
+}
+
+bool TaskScheduler::initialize() {
+    if (timer_fd_ != -1) {
+        return true;
+    }
+
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ == -1) {
+        std::cerr << "Failed to create task timerfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (!system_.watchFd(timer_fd_, EPOLLIN, [this](uint32_t) { handleTimer(); })) {
+        close(timer_fd_);
+        timer_fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+void TaskScheduler::spawn(Task<> task, std::string name) {
+    auto handle = task.release();
+    if (!handle) {
+        return;
+    }
+
+    handle.promise().scheduler_ = this;
+    roots_.push_back(Root{handle, std::move(name)});
+    ++stats_.spawned;
+
+    // 运行到第一个挂起点；同步结束时finishRoot()已经回收了帧
+    handle.resume();
+}
+
+void TaskScheduler::finishRoot(std::coroutine_handle<> handle, std::exception_ptr exception) noexcept {
+    for (auto it = roots_.begin(); it != roots_.end(); ++it) {
+        if (it->handle != handle) {
+            continue;
+        }
+
+        ++stats_.finished;
+        if (exception) {
+            ++stats_.failed;
+            try {
+                std::rethrow_exception(exception);
+            } catch (const std::exception &e) {
+                std::cerr << "Task " << it->name << " failed: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "Task " << it->name << " failed with unknown error" << std::endl;
+            }
+        }
+        roots_.erase(it);
+        break;
+    }
+
+    // 帧停在最终挂起点，可以安全销毁
+    handle.destroy();
+}
+
+void TaskScheduler::shutdown() {
+    // 销毁根任务时，帧中挂起的等待对象会注销定时器和监听
+    std::vector<Root> roots;
+    roots.swap(roots_);
+    for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+        it->handle.destroy();
+    }
+
+    if (timer_fd_ != -1) {
+        system_.unwatchFd(timer_fd_);
+        close(timer_fd_);
+        timer_fd_ = -1;
+    }
+}
+
+TaskScheduler::Stats TaskScheduler::getStats() const {
+    Stats stats = stats_;
+    stats.running = roots_.size();
+    stats.timers = timers_.size();
+    return stats;
+}
+
+SleepAwaiter::TimerMap::iterator
+TaskScheduler::addTimer(std::chrono::steady_clock::time_point deadline, SleepAwaiter *awaiter) {
+    auto timer = timers_.emplace(deadline, awaiter);
+    if (timer == timers_.begin()) {
+        armTimer();
+    }
+    return timer;
+}
+
+void TaskScheduler::cancelTimer(SleepAwaiter::TimerMap::iterator timer) {
+    // 取消的不是最早的定时器时不必重新设置timerfd；是的话多一次空唤醒也无妨
+    timers_.erase(timer);
+}
+
+void TaskScheduler::armTimer() {
+    if (timer_fd_ == -1) {
+        return;
+    }
+
+    struct itimerspec spec{};
+    if (!timers_.empty()) {
+        const auto deadline = timers_.begin()->first;
+        if (deadline == armed_at_) {
+            return;
+        }
+        armed_at_ = deadline;
+
+        // steady_clock即CLOCK_MONOTONIC，可以直接作为绝对时刻；0表示解除，至少为1纳秒
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            deadline.time_since_epoch()
+        )
+                            .count();
+        spec.it_value.tv_sec = ns / 1000000000;
+        spec.it_value.tv_nsec = ns % 1000000000;
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+            spec.it_value.tv_nsec = 1;
+        }
+    } else {
+        armed_at_ = {};
+    }
+
+    if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) == -1) {
+        std::cerr << "Failed to arm task timer: " << strerror(errno) << std::endl;
+    }
+}
+
+void TaskScheduler::handleTimer() {
+    uint64_t expirations;
+    if (read(timer_fd_, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return;
+    }
+    armed_at_ = {};
+
+    // 恢复的协程可能注册或取消其它定时器，每次都重新取最早的一个
+    const auto now = std::chrono::steady_clock::now();
+    while (!timers_.empty() && timers_.begin()->first <= now) {
+        SleepAwaiter *awaiter = timers_.begin()->second;
+        timers_.erase(timers_.begin());
+        awaiter->pending_ = false;
+        awaiter->handle_.resume();
+    }
+
+    armTimer();
+}
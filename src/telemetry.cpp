@@ -0,0 +1,156 @@
+#include <telemetry.h>
+#include <module.h>
+#include <cstdio>
+
+double Histogram::getMean() const {
+    return count_ == 0 ? 0.0 : static_cast<double>(sum_) / static_cast<double>(count_);
+}
+
+uint64_t Histogram::getPercentile(double quantile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+
+    // 第rank个值（从1开始）所在的桶
+    const double clamped = quantile < 0.0 ? 0.0 : (quantile > 1.0 ? 1.0 : quantile);
+    uint64_t rank = static_cast<uint64_t>(clamped * static_cast<double>(count_) + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            const uint64_t upper = bucketUpperBound(i);
+            return upper < max_ ? upper : max_;
+        }
+    }
+    return max_;
+}
+
+void Histogram::reset() {
+    *this = Histogram{};
+}
+
+uint64_t Histogram::bucketUpperBound(size_t index) {
+    constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const size_t shift = (index >> SUB_BUCKET_BITS) - 1;
+    const uint64_t lower = uint64_t{SUB_BUCKETS + (index & (SUB_BUCKETS - 1))} << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+}
+
+namespace {
+
+// 分布摘要"p50/p90/p99/最大值"，每个值除以divisor
+std::string distribution(const Histogram &histogram, uint64_t divisor) {
+    char text[96];
+    std::snprintf(text, sizeof(text), "%llu/%llu/%llu/%llu",
+                  static_cast<unsigned long long>(histogram.getPercentile(0.50) / divisor),
+                  static_cast<unsigned long long>(histogram.getPercentile(0.90) / divisor),
+                  static_cast<unsigned long long>(histogram.getPercentile(0.99) / divisor),
+                  static_cast<unsigned long long>(histogram.getMax() / divisor));
+    return text;
+}
+
+// 报告中的一行
+void appendLine(std::string &out, const std::string &label, const Histogram &histogram,
+                uint64_t divisor) {
+    char text[192];
+    std::snprintf(text, sizeof(text), "  %-24s n=%-8llu mean=%-8.1f p50/p90/p99/max=%s\n",
+                  label.c_str(), static_cast<unsigned long long>(histogram.getCount()),
+                  histogram.getMean() / static_cast<double>(divisor),
+                  distribution(histogram, divisor).c_str());
+    out += text;
+}
+
+} // namespace
+
+Telemetry::Telemetry() : started_(std::chrono::steady_clock::now()) {}
+
+void Telemetry::recordIteration(std::chrono::steady_clock::time_point start, size_t frame_bytes) {
+    const auto now = std::chrono::steady_clock::now();
+    loop_latency_.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count()
+    ));
+
+    if (frame_bytes == 0) {
+        return;
+    }
+    frame_bytes_.record(frame_bytes);
+    if (frames_ > 0) {
+        frame_interval_.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_frame_).count()
+        ));
+    }
+    last_frame_ = now;
+    ++frames_;
+}
+
+void Telemetry::recordTick() {
+    const uint64_t bytes = getBytesRead();
+    const uint64_t syscalls = getSyscalls();
+    tick_bytes_.record(bytes - tick_bytes_base_);
+    tick_syscalls_.record(syscalls - tick_syscalls_base_);
+    tick_bytes_base_ = bytes;
+    tick_syscalls_base_ = syscalls;
+}
+
+std::string Telemetry::report(const ModuleManager &modules) const {
+    const double uptime =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+
+    char header[192];
+    std::snprintf(header, sizeof(header),
+                  "Telemetry: uptime %.0f s, %llu frames (%.2f/s), %llu bytes read, %llu syscalls\n",
+                  uptime, static_cast<unsigned long long>(frames_),
+                  uptime > 0 ? static_cast<double>(frames_) / uptime : 0.0,
+                  static_cast<unsigned long long>(getBytesRead()),
+                  static_cast<unsigned long long>(getSyscalls()));
+
+    std::string out = header;
+    appendLine(out, "loop latency (us)", loop_latency_, 1000);
+    appendLine(out, "frame interval (ms)", frame_interval_, 1000000);
+    appendLine(out, "frame size (bytes)", frame_bytes_, 1);
+    appendLine(out, "bytes read per tick", tick_bytes_, 1);
+    appendLine(out, "syscalls per tick", tick_syscalls_, 1);
+
+    const auto &list = modules.getModules();
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (list[i]) {
+            appendLine(out, "update " + list[i]->getName() + " (us)",
+                       modules.getUpdateLatency(static_cast<ModuleId>(i)), 1000);
+        }
+    }
+    return out;
+}
+
+std::string Telemetry::summary(const ModuleManager &modules) const {
+    const auto uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_);
+
+    char fps[32];
+    std::snprintf(fps, sizeof(fps), "%.2f",
+                  uptime.count() > 0 ? static_cast<double>(frames_) / uptime.count() : 0.0);
+
+    std::string out = "uptime=" + std::to_string(static_cast<uint64_t>(uptime.count())) +
+                      " frames=" + std::to_string(frames_) + " fps=" + fps +
+                      " bytes_read=" + std::to_string(getBytesRead()) +
+                      " syscalls=" + std::to_string(getSyscalls()) +
+                      " loop_us=" + distribution(loop_latency_, 1000) +
+                      " interval_ms=" + distribution(frame_interval_, 1000000) +
+                      " frame_bytes=" + distribution(frame_bytes_, 1) +
+                      " tick_bytes=" + distribution(tick_bytes_, 1) +
+                      " tick_syscalls=" + distribution(tick_syscalls_, 1);
+
+    const auto &list = modules.getModules();
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (list[i]) {
+            out += " update_us." + std::to_string(i) + ':' + list[i]->getName() + '=' +
+                   distribution(modules.getUpdateLatency(static_cast<ModuleId>(i)), 1000);
+        }
+    }
+    return out;
+}
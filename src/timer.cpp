@@ -4,7 +4,6 @@
 #include <cstring>
 #include <iostream>
 #include <stdexcept>
-#include <algorithm>
 
 Timer::Timer() = default;
 
@@ -51,59 +50,15 @@ int Timer::getFd() const {
     return timer_fd_wrapper_.get();
 }
 
-void Timer::addIntervalModule(std::shared_ptr<Module> module) {
-    if (!module) {
-        throw std::invalid_argument("Module cannot be null");
-    }
-
-    interval_modules_.push_back(module);
-}
-
-void Timer::removeModule(const std::shared_ptr<Module> &module) {
-    if (!module) {
-        return;
-    }
-
-    auto it = std::remove(interval_modules_.begin(), interval_modules_.end(), module);
-    interval_modules_.erase(it, interval_modules_.end());
-}
-
-void Timer::handleTimerEvent() {
-    try {
-        // 读取定时器事件
-        uint64_t expirations = readTimerFd();
-        if (expirations > 0) {
-            counter_ += expirations;
-            const uint64_t current_counter = counter_;
-
-            // 更新所有需要按时间间隔更新的模块
-            for (const auto &module : interval_modules_) {
-                if (!module)
-                    continue;
-
-                try {
-                    if (module->getInterval() > 0 && current_counter % module->getInterval() == 0) {
-                        module->update();
-                    }
-                } catch (const std::exception &e) {
-                    std::cerr << "Error updating module " << module->getName() << ": " << e.what()
-                              << std::endl;
-                }
-            }
-        }
-    } catch (const std::exception &e) {
-        std::cerr << "Error in handleTimerEvent: " << e.what() << std::endl;
-    } catch (...) {
-        std::cerr << "Unknown error in handleTimerEvent" << std::endl;
-    }
-}
-
-void Timer::update() {
-    handleTimerEvent();
+uint64_t Timer::handleTimerEvent() {
+    // 读取定时器事件，累加节拍计数
+    const uint64_t expirations = readTimerFd();
+    counter_ += expirations;
+    return expirations;
 }
 
-bool Timer::shouldUpdate(uint64_t counter, std::shared_ptr<Module> module) {
-    return module && module->getInterval() > 0 && counter % module->getInterval() == 0;
+uint64_t Timer::update() {
+    return handleTimerEvent();
 }
 
 uint64_t Timer::getCounter() const {
@@ -126,9 +81,27 @@ bool Timer::setInterval(uint64_t seconds) {
         return false;
     }
 
+    interval_ = seconds;
     return true;
 }
 
+bool Timer::pause() {
+    // it_value为0时解除定时器
+    struct itimerspec new_value{};
+
+    if (timerfd_settime(timer_fd_wrapper_.get(), 0, &new_value, nullptr) == -1) {
+        std::cerr << "Failed to pause timer: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // timerfd_settime()同时清除了尚未读取的到期次数
+    return true;
+}
+
+bool Timer::resume() {
+    return setInterval(interval_);
+}
+
 int Timer::createTimerFd() {
     int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
     if (timer_fd == -1) {
@@ -0,0 +1,218 @@
+#include <trace.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// 各种类事件的名称，按TraceKind的顺序
+constexpr const char *KIND_NAMES[] = {
+    "iteration", "wakeup", "update", "sample", "click", "flush", "output", "dbus", "alsa",
+};
+static_assert(std::size(KIND_NAMES) == static_cast<size_t>(TraceKind::COUNT));
+
+// epoll唤醒来源的名称，与System::EventSource的取值一致
+constexpr const char *SOURCE_NAMES[] = {"module", "timer", "watch"};
+
+// 当前线程的ID，每个线程只查询一次
+uint32_t currentTid() {
+    thread_local const uint32_t tid = static_cast<uint32_t>(gettid());
+    return tid;
+}
+
+// 参数是否为模块ID
+bool hasModuleArg(TraceKind kind) {
+    switch (kind) {
+    case TraceKind::UPDATE:
+    case TraceKind::SAMPLE:
+    case TraceKind::CLICK:
+    case TraceKind::FLUSH:
+    case TraceKind::DBUS:
+        return true;
+    case TraceKind::ITERATION:
+    case TraceKind::WAKEUP:
+    case TraceKind::OUTPUT:
+    case TraceKind::ALSA:
+    case TraceKind::COUNT:
+        return false;
+    default:
+        return false;
+    }
+}
+
+// 把名称作为JSON字符串内容写出（模块名称只含可打印字符，仍然转义引号和反斜杠）
+void writeEscaped(FILE *file, const std::string &text) {
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', file);
+        }
+        if (static_cast<unsigned char>(c) >= 0x20) {
+            std::fputc(c, file);
+        }
+    }
+}
+
+} // namespace
+
+void Trace::enable(std::string path, size_t capacity) {
+    capacity = std::bit_ceil(capacity < 2 ? size_t{2} : capacity);
+    events_ = std::make_unique<Event[]>(capacity);
+
+    // 逐页写入，让内核现在就分配物理页，记录事件时不再缺页
+    for (size_t i = 0; i < capacity; ++i) {
+        events_[i].sequence.store(0, std::memory_order_relaxed);
+        events_[i].start = 0;
+    }
+
+    mask_ = capacity - 1;
+    path_ = path.empty() ? defaultPath() : std::move(path);
+    next_.store(0, std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_release);
+}
+
+void Trace::complete(TraceKind kind, uint32_t arg, uint64_t start, uint64_t end) {
+    if (!isEnabled()) {
+        return;
+    }
+    record(kind, arg, 0, start, end > start ? end - start : 0, false);
+}
+
+void Trace::instant(TraceKind kind, uint32_t arg, uint32_t arg2) {
+    if (!isEnabled()) {
+        return;
+    }
+    record(kind, arg, arg2, now(), 0, true);
+}
+
+void Trace::record(TraceKind kind, uint32_t arg, uint32_t arg2, uint64_t start, uint64_t duration,
+                   bool is_instant) {
+    const uint64_t sequence = next_.fetch_add(1, std::memory_order_relaxed);
+    Event &event = events_[sequence & mask_];
+
+    // 先把槽位标记为正在写入，读取者看到序号前后不一致时跳过
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    event.start = start;
+    event.duration = duration;
+    event.arg = arg;
+    event.arg2 = arg2;
+    event.tid = currentTid();
+    event.kind = kind;
+    event.is_instant = is_instant;
+
+    event.sequence.store(sequence + 1, std::memory_order_release);
+}
+
+bool Trace::flush(const std::function<const std::string *(uint32_t)> &module_name) {
+    if (!isEnabled()) {
+        return false;
+    }
+
+    // 路径可能在所有人可写的/tmp下：用mkostemp以O_EXCL创建权限为0600的临时文件，
+    // 不会跟随别人预先放置的符号链接；rename()替换目标本身，也不跟随符号链接
+    std::string tmp_path = path_ + ".XXXXXX";
+    const int fd = mkostemp(tmp_path.data(), O_CLOEXEC);
+    if (fd == -1) {
+        std::cerr << "Failed to create trace file " << tmp_path << ": " << strerror(errno)
+                  << std::endl;
+        return false;
+    }
+    FILE *file = fdopen(fd, "w");
+    if (!file) {
+        std::cerr << "Failed to open trace file " << tmp_path << ": " << strerror(errno)
+                  << std::endl;
+        close(fd);
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    const unsigned pid = static_cast<unsigned>(getpid());
+    std::fprintf(file,
+                 "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                 "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,"
+                 "\"args\":{\"name\":\"event loop\"}}",
+                 pid, pid);
+
+    // 从最旧的事件开始，跳过已被覆盖或正在写入的槽位
+    const uint64_t end = next_.load(std::memory_order_acquire);
+    const uint64_t capacity = mask_ + 1;
+    const uint64_t begin = end > capacity ? end - capacity : 0;
+    size_t written = 0;
+
+    for (uint64_t sequence = begin; sequence < end; ++sequence) {
+        const Event &slot = events_[sequence & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != sequence + 1) {
+            continue;
+        }
+        const uint64_t start = slot.start;
+        const uint64_t duration = slot.duration;
+        const uint32_t arg = slot.arg;
+        const uint32_t arg2 = slot.arg2;
+        const uint32_t tid = slot.tid;
+        const TraceKind kind = slot.kind;
+        const bool is_instant = slot.is_instant;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence + 1) {
+            continue;
+        }
+
+        const size_t kind_index = static_cast<size_t>(kind);
+        if (kind_index >= std::size(KIND_NAMES)) {
+            continue;
+        }
+
+        std::fprintf(file, ",\n{\"name\":\"%s", KIND_NAMES[kind_index]);
+        const std::string *name = hasModuleArg(kind) ? module_name(arg) : nullptr;
+        if (name) {
+            std::fputc(' ', file);
+            writeEscaped(file, *name);
+        } else if (kind == TraceKind::WAKEUP && arg < std::size(SOURCE_NAMES)) {
+            std::fprintf(file, " %s", SOURCE_NAMES[arg]);
+        }
+
+        // 时间戳以微秒为单位
+        std::fprintf(file, "\",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,", KIND_NAMES[kind_index],
+                     is_instant ? "i\",\"s\":\"t" : "X", static_cast<double>(start) / 1000.0);
+        if (!is_instant) {
+            std::fprintf(file, "\"dur\":%.3f,", static_cast<double>(duration) / 1000.0);
+        }
+        std::fprintf(file, "\"pid\":%u,\"tid\":%u,\"args\":{\"arg\":%u,\"arg2\":%u}}", pid, tid,
+                     arg, arg2);
+        ++written;
+    }
+
+    std::fputs("\n]}\n", file);
+    const bool ok = std::fflush(file) == 0 && !std::ferror(file);
+    std::fclose(file);
+
+    if (!ok || std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+        std::cerr << "Failed to write trace file " << path_ << ": " << strerror(errno)
+                  << std::endl;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    std::cerr << "Trace: wrote " << written << " events to " << path_;
+    if (end > capacity) {
+        std::cerr << " (" << end - capacity << " older events overwritten)";
+    }
+    std::cerr << std::endl;
+    return true;
+}
+
+std::string Trace::defaultPath() {
+    if (const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR"); runtime_dir && *runtime_dir) {
+        return std::string(runtime_dir) + "/seedstatus-trace.json";
+    }
+    return "/tmp/seedstatus-" + std::to_string(getuid()) + "-trace.json";
+}
+
+const std::string &Trace::getPath() {
+    return path_;
+}
@@ -0,0 +1,220 @@
+#include <worker_pool.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <system_error>
+
+WorkerPool::Shared::~Shared() {
+    discardCompleted(*this);
+    if (event_fd != -1) {
+        close(event_fd);
+    }
+}
+
+WorkerPool::WorkerPool() = default;
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+bool WorkerPool::initialize(size_t threads) {
+    if (shared_->event_fd != -1) {
+        return true;
+    }
+
+    const int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd == -1) {
+        std::cerr << "Failed to create worker eventfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+    shared_->event_fd = fd;
+
+    threads = std::max<size_t>(threads, 1);
+    try {
+        for (size_t i = 0; i < threads; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(shared_->mutex);
+                ++shared_->running;
+            }
+            threads_.emplace_back(&WorkerPool::workerLoop, shared_);
+        }
+    } catch (const std::system_error &e) {
+        std::cerr << "Failed to start worker thread: " << e.what() << std::endl;
+        std::lock_guard<std::mutex> lock(shared_->mutex);
+        --shared_->running;
+        // 已经启动的线程照常工作
+        return !threads_.empty();
+    }
+    return true;
+}
+
+int WorkerPool::getFd() const {
+    return shared_->event_fd;
+}
+
+void WorkerPool::submit(std::function<void()> work, std::function<void()> done) {
+    ++stats_.submitted;
+
+    // 未初始化（或初始化失败）时退化为同步执行
+    if (threads_.empty()) {
+        try {
+            if (work) {
+                work();
+            }
+        } catch (const std::exception &e) {
+            std::cerr << "Worker job failed: " << e.what() << std::endl;
+        }
+        if (done) {
+            done();
+        }
+        ++stats_.completed;
+        return;
+    }
+
+    auto job = std::make_unique<Job>();
+    job->work = std::move(work);
+    job->done = std::move(done);
+    {
+        std::lock_guard<std::mutex> lock(shared_->mutex);
+        shared_->queue.push_back(std::move(job));
+    }
+    shared_->wake.notify_one();
+}
+
+size_t WorkerPool::runCompletions() {
+    const int fd = shared_->event_fd;
+    if (fd == -1) {
+        return 0;
+    }
+
+    // 先清零eventfd再取出栈：之后完成的任务看到空栈，会再次写eventfd
+    uint64_t count;
+    if (read(fd, &count, sizeof(count)) == sizeof(count)) {
+        ++stats_.wakeups;
+    }
+
+    Job *head = shared_->completed.exchange(nullptr, std::memory_order_acquire);
+
+    // 栈顶是最后完成的任务，反转后按完成顺序处理
+    Job *ordered = nullptr;
+    while (head) {
+        Job *next = head->next;
+        head->next = ordered;
+        ordered = head;
+        head = next;
+    }
+
+    size_t processed = 0;
+    while (ordered) {
+        std::unique_ptr<Job> job(ordered);
+        ordered = job->next;
+        if (job->done) {
+            try {
+                job->done();
+            } catch (const std::exception &e) {
+                std::cerr << "Worker completion failed: " << e.what() << std::endl;
+            }
+        }
+        ++processed;
+    }
+
+    stats_.completed += processed;
+    return processed;
+}
+
+void WorkerPool::shutdown() {
+    if (threads_.empty()) {
+        return;
+    }
+
+    std::deque<std::unique_ptr<Job>> dropped;
+    bool all_exited;
+    {
+        std::unique_lock<std::mutex> lock(shared_->mutex);
+        shared_->stopping = true;
+        dropped.swap(shared_->queue);
+        shared_->wake.notify_all();
+        all_exited = shared_->exited.wait_for(lock, SHUTDOWN_TIMEOUT,
+                                              [this] { return shared_->running == 0; });
+    }
+
+    for (auto &thread : threads_) {
+        if (all_exited) {
+            thread.join();
+        } else {
+            thread.detach();
+        }
+    }
+    if (!all_exited) {
+        std::cerr << "Worker threads still blocked after "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(SHUTDOWN_TIMEOUT).count()
+                  << " ms, detaching" << std::endl;
+    }
+    threads_.clear();
+
+    discardCompleted(*shared_);
+}
+
+WorkerPool::Stats WorkerPool::getStats() const {
+    return stats_;
+}
+
+void WorkerPool::workerLoop(std::shared_ptr<Shared> shared) {
+    while (true) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(shared->mutex);
+            shared->wake.wait(lock, [&] { return shared->stopping || !shared->queue.empty(); });
+            if (shared->stopping) {
+                break;
+            }
+            job = std::move(shared->queue.front());
+            shared->queue.pop_front();
+        }
+
+        try {
+            if (job->work) {
+                job->work();
+            }
+        } catch (const std::exception &e) {
+            std::cerr << "Worker job failed: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Worker job failed with unknown error" << std::endl;
+        }
+
+        pushCompleted(*shared, job.release());
+    }
+
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    --shared->running;
+    shared->exited.notify_all();
+}
+
+void WorkerPool::pushCompleted(Shared &shared, Job *job) {
+    Job *head = shared.completed.load(std::memory_order_relaxed);
+    do {
+        job->next = head;
+    } while (!shared.completed.compare_exchange_weak(head, job, std::memory_order_release,
+                                                     std::memory_order_relaxed));
+
+    // 栈原先不为空时，事件循环还没有取走上一批，已经有一个待处理的通知
+    if (head != nullptr) {
+        return;
+    }
+
+    const uint64_t one = 1;
+    if (write(shared.event_fd, &one, sizeof(one)) != sizeof(one)) {
+        std::cerr << "Failed to signal worker completion: " << strerror(errno) << std::endl;
+    }
+}
+
+void WorkerPool::discardCompleted(Shared &shared) {
+    Job *head = shared.completed.exchange(nullptr, std::memory_order_acquire);
+    while (head) {
+        std::unique_ptr<Job> job(head);
+        head = job->next;
+    }
+}